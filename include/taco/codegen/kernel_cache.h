@@ -0,0 +1,58 @@
+#ifndef TACO_KERNEL_CACHE_H
+#define TACO_KERNEL_CACHE_H
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace taco {
+namespace ir {
+
+/// The persistent kernel cache stores compiled kernel libraries on disk so
+/// that they can be reloaded by later processes instead of being recompiled.
+/// The cache is enabled by setting the TACO_KERNEL_CACHE_DIR environment
+/// variable to a writable directory. TACO_KERNEL_CACHE_MAX_SIZE sets the
+/// maximum total size of the cached libraries in bytes (default 1 GB); the
+/// least recently used libraries are evicted when the limit is exceeded.
+
+/// Statistics about the use of the persistent kernel cache by this process.
+struct KernelCacheStats {
+  size_t hits      = 0;  // compiles satisfied by a cached library
+  size_t misses    = 0;  // compiles that had to invoke the compiler
+  size_t stores    = 0;  // libraries added to the cache
+  size_t evictions = 0;  // libraries removed to honor the size limit
+  size_t evictedBytes = 0;
+};
+
+/// True if the persistent kernel cache is enabled.
+bool isKernelCacheEnabled();
+
+/// Get the persistent kernel cache directory (with a trailing slash), or the
+/// empty string if the cache is disabled.
+std::string getKernelCacheDir();
+
+/// Get the maximum total size of the persistent kernel cache in bytes.
+size_t getKernelCacheMaxSize();
+
+/// Get the statistics of the persistent kernel cache for this process.
+KernelCacheStats getKernelCacheStats();
+
+/// Reset the statistics of the persistent kernel cache for this process.
+void resetKernelCacheStats();
+
+/// Compute the cache key of a kernel library from the complete text of its
+/// generated source files and the command used to compile it.
+std::string getKernelCacheKey(const std::string& source,
+                              const std::string& compileCommand);
+
+/// Look up a cached library. Returns the path to the library on a hit and the
+/// empty string on a miss.
+std::string lookupKernelCache(const std::string& key);
+
+/// Copy the compiled library at `libpath` into the cache under `key` and
+/// evict old libraries if the cache exceeds its maximum size. Returns the path
+/// of the cached library.
+std::string storeKernelCache(const std::string& key, const std::string& libpath);
+
+}}
+#endif
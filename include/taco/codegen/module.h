@@ -2,6 +2,7 @@
 #define TACO_MODULE_H
 
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
@@ -12,6 +13,8 @@
 namespace taco {
 namespace ir {
 
+class CodeGen_LLVM;
+
 class Module {
 public:
   /// Create a module for some target
@@ -23,7 +26,9 @@ public:
 
   void reset();
 
-  /// Compile the source into a library, returning its full path
+  /// Compile the source into a library, returning its full path.  When the
+  /// module is compiled in-process by the LLVM backend there is no library
+  /// and the empty string is returned.
   std::string compile();
   
   /// Compile the module into a source file located at the specified location
@@ -73,6 +78,7 @@ private:
   std::string libname;
   std::string tmpdir;
   void* lib_handle;
+  std::shared_ptr<CodeGen_LLVM> llvmCodeGen;
   std::vector<Stmt> funcs;
   
   // true iff the module was created from user-provided source
@@ -82,6 +88,7 @@ private:
   
   void setJITLibname();
   void setJITTmpdir();
+  void generateSource();
 };
 
 } // namespace ir
@@ -62,9 +62,26 @@ public:
   /// Gets the type of the idx array for level i
   Datatype getCoordinateTypeIdx(size_t level) const;
 
+  /// Gets the type of positions into the levels, which is the type of the
+  /// widest position array.
+  Datatype getPositionType() const;
+
   /// Sets the types of the coordinate arrays for each level
   void setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTypes);
 
+  /// Sets the types of the position and idx arrays of every compressed and
+  /// singleton level.
+  /// Positions may be Int32 or Int64, so that tensors with more than 2^31
+  /// nonzeros can be stored, and coordinates are UInt8, UInt16, Int32 or
+  /// Int64.
+  void setCoordinateTypes(Datatype posType, Datatype idxType);
+
+  /// Sets the type of the idx array of every compressed and singleton level to
+  /// the narrowest of UInt8, UInt16 and Int32 that holds every coordinate of
+  /// the level's mode, so that small modes move fewer bytes.  `dimensions` are
+  /// the tensor dimensions in mode order.
+  void narrowCoordinateTypes(const std::vector<int>& dimensions);
+
 private:
   std::vector<ModeFormatPack> modeFormatPacks;
   std::vector<int> modeOrdering;
@@ -85,12 +102,20 @@ public:
   static ModeFormat dense;       /// e.g., first mode in CSR
   static ModeFormat compressed;  /// e.g., second mode in CSR
   static ModeFormat singleton;   /// e.g., second mode in COO
+  static ModeFormat hashed;      /// e.g., sparse workspaces and results
+  static ModeFormat bitmap;      /// e.g., moderately dense modes
+  static ModeFormat rle;         /// e.g., runs of equal values
+  static ModeFormat sell;        /// e.g., second mode in SELL
 
   static ModeFormat sparse;      /// alias for compressed
   static ModeFormat Dense;       /// alias for dense
   static ModeFormat Compressed;  /// alias for compressed
   static ModeFormat Sparse;      /// alias for compressed
   static ModeFormat Singleton;   /// alias for singleton
+  static ModeFormat Hashed;      /// alias for hashed
+  static ModeFormat Bitmap;      /// alias for bitmap
+  static ModeFormat RLE;         /// alias for rle
+  static ModeFormat Sell;        /// alias for sell
 
   /// Properties of a mode format
   enum Property {
@@ -133,6 +158,8 @@ public:
   bool hasLocate() const;
   bool hasInsert() const;
   bool hasAppend() const;
+  bool hasRunIter() const;
+  bool hasWordIter() const;
 
   /// Returns true if mode format is defined, false otherwise. An undefined mode
   /// type can be used to indicate a mode whose format is not (yet) known.
@@ -147,6 +174,9 @@ private:
 
   friend class ModePack;
   friend class Iterator;
+  friend class TensorBase;
+  friend class LowererImpl;
+  friend class Index;
 };
 
 
@@ -175,11 +205,19 @@ extern const ModeFormat Dense;
 extern const ModeFormat Compressed;
 extern const ModeFormat Sparse;
 extern const ModeFormat Singleton;
+extern const ModeFormat Hashed;
+extern const ModeFormat Bitmap;
+extern const ModeFormat RLE;
+extern const ModeFormat Sell;
 
 extern const ModeFormat dense;
 extern const ModeFormat compressed;
 extern const ModeFormat sparse;
 extern const ModeFormat singleton;
+extern const ModeFormat hashed;
+extern const ModeFormat bitmap;
+extern const ModeFormat rle;
+extern const ModeFormat sell;
 
 extern const Format CSR;
 extern const Format CSC;
@@ -188,6 +226,21 @@ extern const Format DCSC;
 
 const Format COO(int order, bool isUnique = true, bool isOrdered = true, 
                  bool isAoS = false, const std::vector<int>& modeOrdering = {});
+
+/// Block sparse formats for tensors blocked with Tensor::block, whose first
+/// half of modes index the blocks and whose second half index the components
+/// in a block.  BCSR stores a blocked matrix as a CSR matrix of dense blocks,
+/// and BCSF(order) stores a blocked tensor as a CSF tensor of dense blocks.
+extern const Format BCSR;
+const Format BCSF(int order);
+
+/// The SELL-C-sigma sliced ELLPACK format for matrices, with a dense row level and
+/// a SELL column level whose slices hold `sliceHeight` rows each (the
+/// predefined Sell mode format has slices of 8 rows).  Rows are sorted by
+/// length in windows of `sortingScope` rows before they are sliced, and the
+/// SELL level stores the resulting row permutation.  Matrices whose rows are
+/// sorted are iterated over in storage order rather than row by row.
+const Format SELL(int sliceHeight, int sortingScope=1);
 /// @}
 
 /// True if all modes are dense.
@@ -167,6 +167,11 @@ public:
 /// Check if two index expressions are isomorphic.
 bool isomorphic(IndexExpr, IndexExpr);
 
+/// Compute a structural hash of an index expression.  The hash is invariant
+/// under the renamings of tensor and index variables that `isomorphic`
+/// accepts, so isomorphic expressions always have the same hash.
+size_t isomorphicHash(IndexExpr);
+
 /// Compare two index expressions by value.
 bool equals(IndexExpr, IndexExpr);
 
@@ -625,6 +630,12 @@ public:
   ///  reorder computations to increase locality
   IndexStmt precompute(IndexExpr expr, IndexVar i, IndexVar iw, TensorVar workspace) const;
 
+  /// Precomputes `expr` into a workspace of order two or higher, such as a
+  /// dense tile of the result, indexed by `i` in the consumer and by `iw` in
+  /// the producer.
+  IndexStmt precompute(IndexExpr expr, std::vector<IndexVar> i,
+                       std::vector<IndexVar> iw, TensorVar workspace) const;
+
   /// bound specifies a compile-time constraint on an index variable's
   /// iteration space that allows knowledge of the
   /// size or structured sparsity pattern of the inputs to be
@@ -645,6 +656,11 @@ public:
 /// Check if two index statements are isomorphic.
 bool isomorphic(IndexStmt, IndexStmt);
 
+/// Compute a structural hash of an index statement.  The hash is invariant
+/// under the renamings of tensor and index variables that `isomorphic`
+/// accepts, so isomorphic statements always have the same hash.
+size_t isomorphicHash(IndexStmt);
+
 /// Compare two index statments by value.
 bool equals(IndexStmt, IndexStmt);
 
@@ -937,9 +953,21 @@ IndexStmt makeReductionNotation(IndexStmt);
 
 /// Convert reduction notation to concrete notation, by inserting forall nodes,
 /// replacing reduction nodes by compound assignments, and inserting temporaries
-/// as needed.
+/// as needed.  Nested reductions are computed into temporaries under the loops
+/// whose index variables they use, with the other loops moved inside, unless
+/// that would iterate over the result or a sparse operand out of order.
 IndexStmt makeConcreteNotation(IndexStmt);
 
+/// Fuse a chain of assignments into the assignment that consumes their
+/// results, by replacing every access of a producer's result with the
+/// producer's right-hand side, renamed to the access' index variables.
+/// Producers may consume each other's results, and must be assignments in
+/// reduction notation that do not update their results.  Reductions of inlined
+/// producers are computed into scalar temporaries by makeConcreteNotation,
+/// under the loops that index them (e.g. SDDMM followed by SpMM computes each
+/// sampled product once, outside of the loop over the columns of the result).
+Assignment fuse(Assignment consumer, const std::vector<Assignment>& producers);
+
 /// Returns the results of the index statement, in the order they appear.
 std::vector<TensorVar> getResults(IndexStmt stmt);
 
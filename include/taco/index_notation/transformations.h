@@ -82,15 +82,21 @@ std::ostream &operator<<(std::ostream &, const Reorder &);
 
 
 /// The precompute optimizaton rewrites an index expression to precompute `expr`
-/// and store it to the given workspace.
+/// and store it to the given workspace.  Workspaces of order two and higher
+/// are indexed by several index variables and are computed in the loop over
+/// the first of them.
 class Precompute : public TransformationInterface {
 public:
   Precompute();
   Precompute(IndexExpr expr, IndexVar i, IndexVar iw, TensorVar workspace);
+  Precompute(IndexExpr expr, std::vector<IndexVar> i,
+             std::vector<IndexVar> iw, TensorVar workspace);
 
   IndexExpr getExpr() const;
   IndexVar geti() const;
   IndexVar getiw() const;
+  const std::vector<IndexVar>& getIVars() const;
+  const std::vector<IndexVar>& getIWVars() const;
   TensorVar getWorkspace() const;
 
   /// Apply the precompute optimization to a concrete index statement.
@@ -749,8 +749,9 @@ struct GetProperty : public ExprNode<GetProperty> {
   std::string name;
 
   static Expr make(Expr tensor, TensorProperty property, int mode=0);
+  /// Index arrays hold elements of type `type`.
   static Expr make(Expr tensor, TensorProperty property, int mode,
-                   int index, std::string name);
+                   int index, std::string name, Datatype type=Int());
   
   static const IRNodeType _type_info = IRNodeType::GetProperty;
 };
@@ -0,0 +1,18 @@
+#ifndef LLVM_H
+#define LLVM_H
+
+#ifndef LLVM_BUILT
+  #define LLVM_BUILT false
+#endif
+
+namespace taco {
+/// Functions used by taco to select the in-process LLVM JIT backend
+/// Check if should compile kernels in-process with LLVM
+bool should_use_LLVM_codegen();
+/// Enable/Disable LLVM codegen (kernels the LLVM backend cannot compile are
+/// always handed to the C compiler)
+void set_LLVM_codegen_enabled(bool enabled);
+
+}
+
+#endif
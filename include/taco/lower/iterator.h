@@ -76,6 +76,8 @@ public:
   bool hasLocate() const;
   bool hasInsert() const;
   bool hasAppend() const;
+  bool hasRunIter() const;
+  bool hasWordIter() const;
 
   /// Get the index variable this iterator iteratores over.
   IndexVar getIndexVar() const;
@@ -132,6 +134,14 @@ public:
   ModeFunction posAccess(const ir::Expr& pos, 
                          const std::vector<ir::Expr>& coords) const;
   
+  /// Return code for level functions that implement run iteration.
+  ModeFunction runBounds(const ir::Expr& parentPos) const;
+  ModeFunction runAccess(const ir::Expr& pos) const;
+
+  /// Return code for level functions that implement word iteration.
+  ModeFunction wordBounds(const ir::Expr& parentPos) const;
+  ModeFunction wordAccess(const ir::Expr& word) const;
+
   /// Returns code for level function that implements locate capability.
   ModeFunction locate(const std::vector<ir::Expr>& coords) const;
 
@@ -41,6 +41,7 @@ class CallIntrinsic;
 class MergeLattice;
 class MergePoint;
 class ModeAccess;
+class SellModeFormat;
 
 namespace ir {
 class Stmt;
@@ -90,6 +91,45 @@ protected:
                                          std::set<Access> reducedAccesses,
                                          ir::Stmt recoveryStmt);
 
+  /// Lower a forall that iterates over the runs of coordinates in the
+  /// iterator, and over the coordinates of every run unless the forall reduces
+  /// a value that is the same for every coordinate of a run.
+  virtual ir::Stmt lowerForallRuns(Forall forall, Iterator iterator,
+                                   std::vector<Iterator> locaters,
+                                   std::vector<Iterator> inserters,
+                                   std::vector<Iterator> appenders,
+                                   std::set<Access> reducedAccesses,
+                                   ir::Stmt recoveryStmt);
+
+  /// Lower a forall that iterates over the words of the iterators, 64
+  /// coordinates at a time, and over the set bits of the union of their words.
+  /// Located operands with word iteration whose zeros zero the forall are
+  /// intersected with the union a word at a time.
+  virtual ir::Stmt lowerForallWords(Forall forall,
+                                    std::vector<Iterator> iterators,
+                                    std::vector<Iterator> locaters,
+                                    std::vector<Iterator> inserters,
+                                    std::vector<Iterator> appenders,
+                                    std::set<Access> reducedAccesses,
+                                    ir::Stmt recoveryStmt);
+
+  /// Returns true if the forall may be lowered to a loop over words.
+  bool canIterateWords(Forall forall) const;
+
+  /// Lower a forall over the parent coordinates of the SELL mode iterator,
+  /// together with the forall over its coordinates nested in it, to loops
+  /// over the slices, the slots of a slice, and the fibers of a slice.
+  virtual ir::Stmt lowerForallSlices(Forall forall, Iterator iterator,
+                                     std::vector<Iterator> locaters,
+                                     std::vector<Iterator> inserters,
+                                     std::set<Access> reducedAccesses,
+                                     ir::Stmt recoveryStmt);
+
+  /// Returns true if the forall and the forall nested in it may be lowered to
+  /// loops over the slices of a SELL mode, which is stored in `iterator`.
+  bool canIterateSlices(Forall forall, MergeLattice lattice,
+                        Iterator* iterator) const;
+
   /// Lower a forall that iterates over the positions in the iterator, accesses
   /// the iterators coordinate, and locates tensor positions from the locate
   /// iterators.
@@ -236,6 +276,9 @@ protected:
   /// Retrieve the values array of the tensor var.
   ir::Expr getValuesArray(TensorVar) const;
 
+  /// Check whether a tensor IR variable is a workspace of a where statement.
+  bool isWorkspace(ir::Expr tensor) const;
+
   /// Retrieve the dimension of an index variable (the values it iterates over),
   /// which is encoded as the interval [0, result).
   ir::Expr getDimension(IndexVar indexVar) const;
@@ -343,9 +386,20 @@ protected:
 
   ir::Stmt codeToLoadCoordinatesFromPosIterators(std::vector<Iterator> iterators, bool declVars);
 
+  /// Access the position of the coordinate of a coordinate iterator, and
+  /// whether the mode stores it.
+  ModeFunction coordIterAccess(Iterator iterator) const;
+
+  /// Declare the position and valid variables of coordinate iterators.
+  ir::Stmt codeToAccessCoordIterators(std::vector<Iterator> iterators);
+
     /// Create statements to append coordinate to result modes.
   ir::Stmt appendCoordinate(std::vector<Iterator> appenders, ir::Expr coord);
 
+  /// Create statements to insert coordinates into result modes, at the
+  /// positions located for them.
+  ir::Stmt insertCoordinates(std::vector<Iterator> inserters);
+
   /// Create statements to append positions to result modes.
   ir::Stmt generateAppendPositions(std::vector<Iterator> appenders);
 
@@ -357,6 +411,9 @@ protected:
   ir::Expr checkThatNoneAreExhausted(std::vector<Iterator> iterators);
 
 private:
+  /// Returns the SELL mode format the iterator iterates over, or null.
+  static const SellModeFormat* getSellModeFormat(Iterator iterator);
+
   bool assemble;
   bool compute;
 
@@ -402,6 +459,15 @@ private:
 
   int inParallelLoopDepth = 0;
 
+  /// Per-thread workspace allocations and frees that are hoisted out of the
+  /// outermost CPU parallel loop.
+  std::vector<ir::Stmt> hoistedAllocations;
+  std::vector<ir::Stmt> hoistedFrees;
+
+  /// The length of the run whose coordinates a reduction is lowered for, if
+  /// the reduction adds the same value for every coordinate of the run.
+  ir::Expr runLength;
+
   std::map<ParallelUnit, ir::Expr> parallelUnitSizes;
   std::map<ParallelUnit, IndexVar> parallelUnitIndexVars;
 
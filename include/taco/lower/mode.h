@@ -56,6 +56,15 @@ public:
   void     addVar(std::string varName, ir::Expr var);
   /// @}
 
+  /// The values array indexed by the positions of the mode, if the mode is the
+  /// last mode of a tensor whose values are computed while the mode is
+  /// assembled.  Modes that move coordinates while they are assembled, like
+  /// hashed modes that grow their tables, move the values with them.
+  /// @{
+  ir::Expr getValuesArray() const;
+  void     setValuesArray(ir::Expr values);
+  /// @}
+
   /// Check whether the mode is defined.
   bool defined() const;
 
@@ -76,12 +85,22 @@ public:
   ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor, int mode, 
            int level);
 
+  /// Construct a mode pack whose i-th index array holds elements of type
+  /// `arrayTypes[i]` and whose arrays are indexed by positions of type
+  /// `posType`.
+  ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor, int mode,
+           int level, const std::vector<Datatype>& arrayTypes,
+           Datatype posType);
+
   /// Returns number of tensor modes belonging to mode pack.
   size_t getNumModes() const;
 
   /// Returns arrays shared by tensor modes.
   ir::Expr getArray(size_t i) const;
 
+  /// Returns the type of positions into the arrays.
+  Datatype getPosType() const;
+
 private:
   struct Content;
   std::shared_ptr<Content> content;
@@ -0,0 +1,65 @@
+#ifndef TACO_MODE_FORMAT_BITMAP_H
+#define TACO_MODE_FORMAT_BITMAP_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A bitmap mode stores one bit per coordinate of every fiber, packed into
+/// 64-bit words, and values for every coordinate like a dense mode.  The
+/// positions of a fiber are [parentPos*dimension, (parentPos+1)*dimension),
+/// bit p of the bitmap is set if position p holds a nonzero, and the values of
+/// the other positions are zero.  Bitmap modes suit moderately dense modes:
+/// they move one bit instead of a coordinate per nonzero, and support locate,
+/// ordered iteration and inserts.  Word iteration visits the set bits of a
+/// fiber 64 coordinates at a time, and lets loops over several bitmaps combine
+/// their words with bitwise and and or.  Coordinate iteration tests the bit of
+/// every coordinate, and is only used to merge bitmaps with other formats.
+class BitmapModeFormat : public ModeFormatImpl {
+public:
+  BitmapModeFormat();
+  BitmapModeFormat(bool isOrdered, bool isUnique);
+
+  ~BitmapModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction coordIterBounds(std::vector<ir::Expr> parentCoords,
+                               Mode mode) const override;
+  ModeFunction coordIterAccess(ir::Expr parentPos,
+                               std::vector<ir::Expr> coords,
+                               Mode mode) const override;
+  ModeFunction coordBounds(ir::Expr parentPos, Mode mode) const override;
+
+  ModeFunction wordIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction wordIterAccess(ir::Expr parentPos, ir::Expr word,
+                              Mode mode) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Stmt getInsertCoord(ir::Expr p, const std::vector<ir::Expr>& i,
+                          Mode mode) const override;
+  ir::Expr getWidth(Mode mode) const override;
+  ir::Stmt getInsertInitCoords(ir::Expr pBegin, ir::Expr pEnd,
+                               Mode mode) const override;
+  ir::Stmt getInsertInitLevel(ir::Expr szPrev, ir::Expr sz,
+                              Mode mode) const override;
+  ir::Stmt getInsertFinalizeLevel(ir::Expr szPrev, ir::Expr sz,
+                                  Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the number of 64-bit words of a bitmap with `size` bits.
+  static size_t getNumWords(size_t size);
+
+protected:
+  ir::Expr getSizeArray(ModePack pack) const;
+  ir::Expr getBitmapArray(ModePack pack) const;
+  ir::Expr getBitmapCapacity(Mode mode) const;
+};
+
+}
+
+#endif
@@ -37,6 +37,13 @@ public:
                                   int level) const override;
 
 protected:
+  /// Constructs a mode format that shares the pos and crd arrays, and the
+  /// append capability, of compressed modes but is iterated differently.
+  CompressedModeFormat(std::string name, bool isFull, bool isOrdered,
+                       bool isUnique, bool hasCoordValIter,
+                       bool hasCoordPosIter, bool hasRunIter,
+                       long long allocSize);
+
   ir::Expr getPosArray(ModePack pack) const;
   ir::Expr getCoordArray(ModePack pack) const;
 
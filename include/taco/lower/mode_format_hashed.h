@@ -0,0 +1,74 @@
+#ifndef TACO_MODE_FORMAT_HASHED_H
+#define TACO_MODE_FORMAT_HASHED_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A hashed mode stores the coordinates of every fiber in an open addressing
+/// hash table with linear probing.  The tables of a level have the same
+/// power-of-two width and are stored one after the other, so the positions of
+/// a fiber are [parentPos*width, (parentPos+1)*width) and empty slots hold
+/// coordinate -1 and value zero.  Hashed modes support locate in expected
+/// constant time, and inserts, so sparse results with scattered writes can be
+/// assembled without a dense workspace.
+///
+/// Tables are kept at most half full.  Packing sizes them from the largest
+/// fiber, and assembling doubles the width of a level's tables, and rehashes
+/// them, when a fiber grows past half the width.  Growing moves the positions
+/// of the level, so tables of levels above other levels must be created wide
+/// enough to never grow, at twice the dimension of the mode.
+class HashedModeFormat : public ModeFormatImpl {
+public:
+  /// Creates a hashed mode format whose tables have at least `width` slots.
+  HashedModeFormat(int width=0);
+  HashedModeFormat(bool isOrdered, bool isUnique, int width);
+
+  ~HashedModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  ModeFunction locate(ir::Expr parentPos, std::vector<ir::Expr> coords,
+                      Mode mode) const override;
+
+  ir::Stmt getInsertCoord(ir::Expr p, const std::vector<ir::Expr>& i,
+                          Mode mode) const override;
+  ir::Expr getWidth(Mode mode) const override;
+  ir::Stmt getInsertInitCoords(ir::Expr pBegin, ir::Expr pEnd,
+                               Mode mode) const override;
+  ir::Stmt getInsertInitLevel(ir::Expr szPrev, ir::Expr sz,
+                              Mode mode) const override;
+  ir::Stmt getInsertFinalizeLevel(ir::Expr szPrev, ir::Expr sz,
+                                  Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the width of tables that hold `numCoordinates` coordinates at
+  /// most half full: the smallest power of two that is at least the requested
+  /// width and twice `numCoordinates`.
+  int getTableWidth(int numCoordinates) const;
+
+protected:
+  ir::Expr getWidthArray(ModePack pack) const;
+  ir::Expr getCoordArray(ModePack pack) const;
+  ir::Expr getCoordCapacity(Mode mode) const;
+  ir::Expr getFillArray(Mode mode) const;
+  ir::Expr getFillCapacity(Mode mode) const;
+  ir::Expr getNumTables(Mode mode) const;
+
+  ir::Stmt getGrowTables(ir::Expr p, ir::Expr coord, ir::Expr table,
+                         Mode mode) const;
+
+  bool equals(const ModeFormatImpl& other) const override;
+
+  const int width;
+};
+
+}
+
+#endif
@@ -61,7 +61,8 @@ public:
   ModeFormatImpl(std::string name, bool isFull, bool isOrdered, bool isUnique, 
                  bool isBranchless, bool isCompact, bool hasCoordValIter, 
                  bool hasCoordPosIter, bool hasLocate, bool hasInsert, 
-                 bool hasAppend);
+                 bool hasAppend, bool hasRunIter=false,
+                 bool hasWordIter=false);
 
   virtual ~ModeFormatImpl();
 
@@ -88,8 +89,10 @@ public:
 
 
   /// The position iteration capability's iterator function computes a range
-  /// [result[0], result[1]) of positions to iterate over.
-  /// `pos_iter_bounds(p_{k−1}) -> begin_{k}, end_{k}`
+  /// [result[0], result[1]) of positions to iterate over.  Modes that
+  /// interleave their fibers may also return a stride (result[2]) between
+  /// the positions of a fiber.
+  /// `pos_iter_bounds(p_{k−1}) -> begin_{k}, end_{k}[, stride_{k}]`
   virtual ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const;
 
   /// The position iteration capability's access function maps a position
@@ -101,6 +104,32 @@ public:
                                      Mode mode) const;
 
 
+  /// The run iteration capability's iterator function computes a range
+  /// [result[0], result[1]) of positions to iterate over, where every position
+  /// holds a run of consecutive coordinates that share the position.
+  /// `run_iter_bounds(p_{k−1}) -> begin_{k}, end_{k}`
+  virtual ModeFunction runIterBounds(ir::Expr parentPos, Mode mode) const;
+
+  /// The run iteration capability's access function maps a position iterator
+  /// variable to the range [result[0], result[1]) of coordinates in its run.
+  /// `run_iter_access(p_{k}) -> begin_{i_k}, end_{i_k}`
+  virtual ModeFunction runIterAccess(ir::Expr pos, Mode mode) const;
+
+
+  /// The word iteration capability's iterator function computes a range
+  /// [result[0], result[1]) of words to iterate over, where word w covers the
+  /// coordinates [64*w, 64*w+64) of the fiber.
+  /// `word_iter_bounds(p_{k−1}) -> begin_{k}, end_{k}`
+  virtual ModeFunction wordIterBounds(ir::Expr parentPos, Mode mode) const;
+
+  /// The word iteration capability's access function maps a word iterator
+  /// variable to a 64-bit integer (result[0]) whose bit b is set if coordinate
+  /// 64*w+b of the fiber is stored.
+  /// `word_iter_access(p_{k−1}, w) -> bits`
+  virtual ModeFunction wordIterAccess(ir::Expr parentPos, ir::Expr word,
+                                      Mode mode) const;
+
+
   /// The locate capability locates the position of a coordinate (result[0])
   /// and reports if the coordinate could not be found (result[1]).
   /// `locate(p_{k−1}, i_{1}, ..., i_{k}) -> p_{k}, found`
@@ -168,6 +197,8 @@ public:
   const bool hasLocate;
   const bool hasInsert;
   const bool hasAppend;
+  const bool hasRunIter;
+  const bool hasWordIter;
 
 protected:
   /// Check if other mode format is identical. Can assume that this method will 
@@ -0,0 +1,47 @@
+#ifndef TACO_MODE_FORMAT_RLE_H
+#define TACO_MODE_FORMAT_RLE_H
+
+#include "taco/lower/mode_format_compressed.h"
+
+namespace taco {
+
+/// A run-length encoded mode stores the nonzeros of every fiber as runs of
+/// consecutive coordinates that share a position, and hence a value.  Like a
+/// compressed mode the positions of a fiber are [pos[parentPos],
+/// pos[parentPos+1]), but position p holds the run of coordinates
+/// [runs[2*p], runs[2*p+1]).  Loops over a run-length encoded mode iterate over
+/// runs as intervals, and reductions over a run scale its value by the length
+/// of the run instead of visiting its coordinates.  Packing merges adjacent
+/// runs of the last mode of a tensor that hold equal values.
+class RunLengthModeFormat : public CompressedModeFormat {
+public:
+  RunLengthModeFormat(long long allocSize=DEFAULT_ALLOC_SIZE);
+
+  ~RunLengthModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction coordIterBounds(std::vector<ir::Expr> parentCoords,
+                               Mode mode) const override;
+  ModeFunction coordIterAccess(ir::Expr parentPos,
+                               std::vector<ir::Expr> coords,
+                               Mode mode) const override;
+  ModeFunction coordBounds(ir::Expr parentPos, Mode mode) const override;
+
+  ModeFunction runIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction runIterAccess(ir::Expr pos, Mode mode) const override;
+
+  ir::Stmt getAppendCoord(ir::Expr pos, ir::Expr coord,
+                          Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+protected:
+  ir::Expr getRunsArray(ModePack pack) const;
+  ir::Expr getDimension(ModePack pack) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef TACO_MODE_FORMAT_SELL_H
+#define TACO_MODE_FORMAT_SELL_H
+
+#include "taco/lower/mode_format_impl.h"
+
+namespace taco {
+
+/// A sliced ELLPACK (SELL-C) mode cuts the fibers of a level into slices of
+/// `sliceHeight` consecutive fibers, pads every fiber of a slice to the length
+/// of the slice's longest fiber, and stores the slice slot by slot, so that
+/// the k-th coordinates of the fibers of a slice are adjacent.  The slices are
+/// stored one after the other, and pos[s] is the position of the first slot of
+/// slice s.  The positions of fiber p are therefore pos[p/C] + p%C,
+/// pos[p/C] + p%C + C, ..., up to pos[p/C+1], where C is the slice height, and
+/// padding positions hold coordinate -1 and value zero.
+///
+/// With a sorting scope sigma greater than one (SELL-C-sigma), the fibers of every sigma
+/// consecutive parent positions are sorted by decreasing length before they
+/// are sliced, so that fibers of similar lengths share slices and need less
+/// padding, and perm[f] holds the parent coordinate of the f-th sliced fiber.
+///
+/// Kernels iterate over SELL modes slice by slice, slot by slot, with the
+/// fibers of a slice as the innermost loop, so that they access the adjacent
+/// coordinates and values of a slot together.  SELL modes whose fibers are
+/// not sorted also support strided position iteration of one fiber at a
+/// time, which visits fibers in order.  SELL modes cannot be merged with
+/// other sparse operands, nor assembled by kernels, and are instead packed
+/// on the host from sorted coordinates.
+class SellModeFormat : public ModeFormatImpl {
+public:
+  /// Creates a SELL mode format with slices of `sliceHeight` fibers, whose
+  /// fibers are sorted by length in windows of `sortingScope` fibers.
+  SellModeFormat(int sliceHeight=8, int sortingScope=1);
+
+  ~SellModeFormat() override {}
+
+  ModeFormat copy(std::vector<ModeFormat::Property> properties) const override;
+
+  ModeFunction posIterBounds(ir::Expr parentPos, Mode mode) const override;
+  ModeFunction posIterAccess(ir::Expr pos, std::vector<ir::Expr> coords,
+                             Mode mode) const override;
+
+  std::vector<ir::Expr> getArrays(ir::Expr tensor, int mode,
+                                  int level) const override;
+
+  /// Returns the bounds of the positions of slice `slice`.
+  ModeFunction sliceBounds(ir::Expr slice, Mode mode) const;
+
+  /// Returns the parent coordinate of the sliced fiber `fiber`.
+  ir::Expr fiberCoord(ir::Expr fiber, Mode mode) const;
+
+  /// Returns the number of fibers in a slice.
+  int getSliceHeight() const;
+
+  /// Returns the number of fibers that are sorted by length together.
+  int getSortingScope() const;
+
+protected:
+  ir::Expr getPosArray(ModePack pack) const;
+  ir::Expr getCoordArray(ModePack pack) const;
+  ir::Expr getPermArray(ModePack pack) const;
+
+  bool equals(const ModeFormatImpl& other) const override;
+
+  const int sliceHeight;
+  const int sortingScope;
+};
+
+}
+
+#endif
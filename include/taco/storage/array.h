@@ -24,6 +24,11 @@ public:
   /// Construct an array of elements of the given type.
   Array(Datatype type, void* data, size_t size, Policy policy=Free);
 
+  /// Construct an array of elements of the given type that points into memory
+  /// owned by `owner` (e.g. a memory-mapped file).  The array has the UserOwns
+  /// policy and keeps the owner alive for as long as the array lives.
+  Array(Datatype type, void* data, size_t size, std::shared_ptr<void> owner);
+
   /// Returns the type of the array elements
   const Datatype& getType() const;
 
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "taco/format.h"
+#include "taco/type.h"
 
 namespace taco {
 class TensorBase;
@@ -25,6 +26,24 @@ TensorBase readMTX(std::istream& stream, const ModeFormat& modetype,
 /// Read an mtx matrix from a stream.
 TensorBase readMTX(std::istream& stream, const Format& format, bool pack=true);
 
+/// Read an mtx matrix from a file, parsing the values directly as `ctype`.
+/// Pattern matrices have no values in the file and every component is one.
+/// If `ctype` is Pattern only the sparsity structure is read.
+TensorBase readMTX(std::string filename, const ModeFormat& modetype,
+                   Datatype ctype, bool pack=true);
+
+/// Read an mtx matrix from a file, parsing the values directly as `ctype`.
+TensorBase readMTX(std::string filename, const Format& format, Datatype ctype,
+                   bool pack=true);
+
+/// Read an mtx matrix from a stream, parsing the values directly as `ctype`.
+TensorBase readMTX(std::istream& stream, const ModeFormat& modetype,
+                   Datatype ctype, bool pack=true);
+
+/// Read an mtx matrix from a stream, parsing the values directly as `ctype`.
+TensorBase readMTX(std::istream& stream, const Format& format, Datatype ctype,
+                   bool pack=true);
+
 TensorBase readSparse(std::istream& stream, const ModeFormat& modetype, 
                       bool symm = false);
 TensorBase readDense(std::istream& stream, const ModeFormat& modetype, 
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "taco/format.h"
+#include "taco/type.h"
 
 namespace taco {
 class TensorBase;
@@ -62,6 +63,15 @@ TensorBase readRB(std::istream& stream, const ModeFormat& modetype,
 /// Read an rb matrix from a stream
 TensorBase readRB(std::istream& stream, const Format& format, bool pack=true);
 
+/// Read an rb matrix from a file, parsing the values directly as `ctype`.
+/// Pattern matrices have no values in the file and every component is one.
+TensorBase readRB(std::string filename, const Format& format, Datatype ctype,
+                  bool pack=true);
+
+/// Read an rb matrix from a stream, parsing the values directly as `ctype`.
+TensorBase readRB(std::istream& stream, const Format& format, Datatype ctype,
+                  bool pack=true);
+
 /// Write an rb matrix to a file
 void writeRB(std::string filename, const TensorBase& tensor);
 
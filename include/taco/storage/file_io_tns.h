@@ -6,6 +6,7 @@
 #include <string>
 
 #include "taco/format.h"
+#include "taco/type.h"
 
 namespace taco {
 class TensorBase;
@@ -25,6 +26,22 @@ TensorBase readTNS(std::istream& stream, const ModeFormat& modetype,
 /// Read a tns tensor from a stream.
 TensorBase readTNS(std::istream& stream, const Format& format, bool pack=true);
 
+/// Read a tns tensor from a file, parsing the values directly as `ctype`.
+TensorBase readTNS(std::string filename, const ModeFormat& modetype,
+                   Datatype ctype, bool pack=true);
+
+/// Read a tns tensor from a file, parsing the values directly as `ctype`.
+TensorBase readTNS(std::string filename, const Format& format, Datatype ctype,
+                   bool pack=true);
+
+/// Read a tns tensor from a stream, parsing the values directly as `ctype`.
+TensorBase readTNS(std::istream& stream, const ModeFormat& modetype,
+                   Datatype ctype, bool pack=true);
+
+/// Read a tns tensor from a stream, parsing the values directly as `ctype`.
+TensorBase readTNS(std::istream& stream, const Format& format, Datatype ctype,
+                   bool pack=true);
+
 /// Write a tns tensor to a file.
 void writeTNS(std::string filename, const TensorBase& tensor);
 
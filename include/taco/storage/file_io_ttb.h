@@ -0,0 +1,51 @@
+/// Read and write the ttb taco binary tensor format.  A ttb file holds a
+/// tensor's storage exactly as it is laid out in memory (format, dimensions,
+/// index arrays and values), with every array aligned to 64 bytes, so that a
+/// tensor can be loaded by memory-mapping the file without parsing or copying.
+
+#ifndef TACO_FILE_IO_TTB_H
+#define TACO_FILE_IO_TTB_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "taco/format.h"
+
+namespace taco {
+class TensorBase;
+class Format;
+
+/// Read a ttb tensor from a file by memory-mapping it.  The tensor's index and
+/// value arrays point directly into the mapping, which is private to the
+/// process (writes to the tensor are not written back to the file) and stays
+/// mapped for as long as any of the arrays live.
+TensorBase readTTB(std::string filename);
+
+/// Read a ttb tensor from a file, which must store the tensor in `modetype`.
+/// If `pack` is false the components are copied out of the file and inserted
+/// into the returned tensor, which must then be packed before use.
+TensorBase readTTB(std::string filename, const ModeFormat& modetype,
+                   bool pack=true);
+
+/// Read a ttb tensor from a file, which must store the tensor in `format`.
+TensorBase readTTB(std::string filename, const Format& format, bool pack=true);
+
+/// Read a ttb tensor from a stream.  Unlike reading from a file this copies
+/// the stream contents into memory.
+TensorBase readTTB(std::istream& stream, const ModeFormat& modetype,
+                   bool pack=true);
+
+/// Read a ttb tensor from a stream.  Unlike reading from a file this copies
+/// the stream contents into memory.
+TensorBase readTTB(std::istream& stream, const Format& format, bool pack=true);
+
+/// Write a packed tensor to a ttb file.
+void writeTTB(std::string filename, const TensorBase& tensor);
+
+/// Write a packed tensor to a ttb stream.
+void writeTTB(std::ostream& stream, const TensorBase& tensor);
+
+}
+
+#endif
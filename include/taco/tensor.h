@@ -8,6 +8,8 @@
 #include <utility>
 #include <array>
 #include <mutex>
+#include <future>
+#include <unordered_map>
 
 #include "taco/type.h"
 #include "taco/format.h"
@@ -125,7 +127,8 @@ public:
   /* --- Write Methods       --- */
 
   /// Insert a value into the tensor. The number of coordinates must match the
-  /// tensor order.
+  /// tensor order. Pattern tensors take `bool` values, which are ignored since
+  /// every inserted component is one.
   template <typename CType>
   void insert(const std::initializer_list<int>& coordinate, CType value);
 
@@ -147,6 +150,25 @@ public:
   template <typename InputIterators>
   void setFromComponents(const InputIterators& begin, const InputIterators& end);
 
+  /// Replace the tensor's components with `numComponents` components given as
+  /// struct-of-arrays COO buffers: one coordinate array per mode, in mode
+  /// order, and an array of values of the tensor's component type.
+  /// Duplicated coordinates are summed up.
+  ///
+  /// If `sorted` is true the caller promises that the components are sorted
+  /// lexicographically in the format's mode ordering.  They are then packed
+  /// directly from the caller's arrays, skipping the sort and the intermediate
+  /// copies that `insert` and `pack` make.  The arrays are not retained.
+  void setFromCOO(const std::vector<const int*>& coordinates,
+                  const void* values, size_t numComponents,
+                  bool sorted = false);
+
+  /// Replace the tensor's components with COO buffers. See above.
+  template <typename CType>
+  void setFromCOO(const std::vector<const int*>& coordinates,
+                  const CType* values, size_t numComponents,
+                  bool sorted = false);
+
   /* --- Read Methods        --- */
 
   template <typename CType>  
@@ -408,11 +430,27 @@ public:
   /// Pack tensor into the given format
   void pack();
 
+  /// Fuse the computation of operands that have not been computed yet into
+  /// the expression of this tensor, so that it compiles to a single kernel
+  /// that does not materialize them.  Operands whose expressions update their
+  /// values are still computed before this tensor.
+  void fuseOperands();
+
   /// Compile the tensor expression.
   void compile();
 
   void compile(IndexStmt stmt, bool assembleWhileCompute=false);
 
+  /// Compile the tensor expression in the background. The kernels are lowered
+  /// by the calling thread and then compiled by a pool of worker threads, whose
+  /// size can be set with the TACO_COMPILE_THREADS environment variable.
+  /// Assemble, compute and evaluate wait for the compilation to finish, so the
+  /// returned future only needs to be waited on to overlap other work.
+  std::shared_future<void> compileAsync();
+
+  std::shared_future<void> compileAsync(IndexStmt stmt,
+                                        bool assembleWhileCompute=false);
+
   /// Assemble the tensor storage, including index and value arrays.
   void assemble();
 
@@ -494,6 +532,12 @@ private:
                                  const std::shared_ptr<ir::Module> kernel);
 
   /* --- Compiler Methods --- */
+  IndexStmt makeDefaultStmt() const;
+  std::shared_future<void> compileKernels(IndexStmt stmt,
+                                          bool assembleWhileCompute,
+                                          bool async);
+  void waitForCompile();
+
   bool neverPacked();
 
   void unsetNeverPacked();
@@ -524,20 +568,36 @@ private:
   template <typename CType>
   void reinsertPackedComponents();
 
+  /// Returns true if components of type `CType` can be inserted into and read
+  /// from the tensor.  Pattern tensors are accessed as `bool`.
+  template <typename CType>
+  bool hasComponentType() const;
+
+  /// Pack components whose coordinates are sorted and listed in the order the
+  /// format stores the modes in.
+  void packSortedCoordinates(const std::vector<const int*>& coordinates,
+                             const void* values, size_t numCoordinates);
+
   struct Content;
   std::shared_ptr<Content> content;
 
+  /// Helper functions are compiled by the first thread that needs them, and
+  /// cached as futures that other threads wait on.
   typedef std::vector<std::tuple<Format,
                                  Datatype,
                                  std::vector<int>,
-                                 std::shared_ptr<ir::Module>>> HelperFuncsCache;
+                                 std::shared_future<std::shared_ptr<ir::Module>>>>
+      HelperFuncsCache;
   static HelperFuncsCache helperFunctions;
   static std::mutex helperFunctionsMutex;
 
-  typedef std::vector<std::pair<IndexStmt, 
-                                std::shared_ptr<ir::Module>>> KernelsCache;
+  /// Compiled kernels are bucketed by `isomorphicHash` of their statements.
+  /// The cache is guarded by a reader/writer lock defined in tensor.cpp.
+  typedef std::unordered_multimap<size_t,
+                                  std::pair<IndexStmt,
+                                            std::shared_ptr<ir::Module>>>
+          KernelsCache;
   static KernelsCache computeKernels;
-  static std::mutex computeKernelsMutex;
 };
 
 /// A reference to a tensor. Tensor object copies copies the reference, and
@@ -589,6 +649,17 @@ public:
   /// Returns a copy of the tensor without explicit zeros.
   Tensor<CType> removeExplicitZeros(Format format) const;
 
+  /// Packs a blocked copy of the tensor, for block sparse formats like BCSR.
+  /// Mode i of the tensor is split into blocks of blockDimensions[i]
+  /// components: the blocked tensor has twice the order, mode i indexes the
+  /// blocks and mode order+i indexes the components of a block.  Dimensions
+  /// that are not multiples of the block size are padded with zeros.
+  Tensor<CType> block(std::vector<int> blockDimensions, Format format) const;
+
+  /// Packs an unblocked copy of a tensor created by block, with the given
+  /// (unpadded) dimensions.
+  Tensor<CType> unblock(std::vector<int> dimensions, Format format) const;
+
   const_iterator<int,CType> begin() const;
   const_iterator<int,CType> begin();
 
@@ -676,7 +747,13 @@ enum class FileType {
   ttx,
 
   /// .rb  - The rutherford-boeing sparse matrix format.
-  rb
+  rb,
+
+  /// .ttb - The taco binary tensor format.  It stores the tensor's format,
+  ///        dimensions, index arrays and values exactly as laid out in memory,
+  ///        so files are memory-mapped rather than parsed when read.  A ttb
+  ///        file can only be read into the format it was written in.
+  ttb
 };
 
 /// Read a tensor from a file. The file format is inferred from the filename
@@ -716,6 +793,17 @@ void write(std::string filename, FileType filetype, const TensorBase& tensor);
 /// Write a tensor to a stream in the given file format.
 void write(std::ofstream& file, FileType filetype, const TensorBase& tensor);
 
+/// Set the number of bytes of unpacked components the tns and mtx readers may
+/// hold while reading and packing a file.  Larger files are parsed into sorted
+/// runs that are spilled to the temporary directory and then merged straight
+/// into the packed index and value arrays, as long as every mode of the format
+/// is dense or compressed.  A budget of zero, the default, reads every file in
+/// memory.
+void setReadMemoryBudget(size_t bytes);
+
+/// Get the number of bytes of unpacked components the file readers may hold.
+size_t getReadMemoryBudget();
+
 
 /// Factory function to construct a compressed sparse row (CSR) matrix. The
 /// arrays remain owned by the user and will not be freed by taco.
@@ -853,6 +941,7 @@ struct TensorBase::Content {
   ir::Stmt           computeFunc;
   bool               assembleWhileCompute;
   std::shared_ptr<ir::Module> module;
+  std::shared_future<void>    compileFuture;
 
   size_t             coordinateBufferUsed;
   size_t             coordinateSize;
@@ -886,7 +975,7 @@ template <typename CType>
 void TensorBase::insert(const std::initializer_list<int>& coordinate, CType value) {
   taco_uassert(coordinate.size() == (size_t)getOrder()) <<
   "Wrong number of indices";
-  taco_uassert(getComponentType() == type<CType>()) <<
+  taco_uassert(hasComponentType<CType>()) <<
   "Cannot insert a value of type '" << type<CType>() << "' " <<
   "into a tensor with component type " << getComponentType();
   syncDependentTensors();
@@ -897,8 +986,10 @@ void TensorBase::insert(const std::initializer_list<int>& coordinate, CType valu
   for (int idx : coordinate) {
     *(coordLoc++) = idx;
   }
-  TypedComponentPtr valLoc(getComponentType(), coordLoc);
-  *valLoc = TypedComponentVal(getComponentType(), &value);
+  if (!getComponentType().isPattern()) {
+    TypedComponentPtr valLoc(getComponentType(), coordLoc);
+    *valLoc = TypedComponentVal(getComponentType(), &value);
+  }
   content->coordinateBufferUsed += content->coordinateSize;
   setNeedsPack(true);
 }
@@ -914,7 +1005,7 @@ template <typename CType>
 void TensorBase::insertUnsynced(const std::vector<int>& coordinate, CType value) {
   taco_uassert(coordinate.size() == (size_t)getOrder()) <<
   "Wrong number of indices";
-  taco_uassert(getComponentType() == type<CType>()) <<
+  taco_uassert(hasComponentType<CType>()) <<
     "Cannot insert a value of type '" << type<CType>() << "' " <<
     "into a tensor with component type " << getComponentType();
   if ((content->coordinateBuffer->size() - content->coordinateBufferUsed) < content->coordinateSize) {
@@ -924,8 +1015,10 @@ void TensorBase::insertUnsynced(const std::vector<int>& coordinate, CType value)
   for (int idx : coordinate) {
     *(coordLoc++) = idx;
   }
-  TypedComponentPtr valLoc(getComponentType(), coordLoc);
-  *valLoc = TypedComponentVal(getComponentType(), &value);
+  if (!getComponentType().isPattern()) {
+    TypedComponentPtr valLoc(getComponentType(), coordLoc);
+    *valLoc = TypedComponentVal(getComponentType(), &value);
+  }
   content->coordinateBufferUsed += content->coordinateSize;
 }
   
@@ -940,11 +1033,19 @@ void TensorBase::insertUnchecked(
   for (size_t i = 0; i < coordinate.getOrder(); ++i) {
     *(coordLoc++) = coordinate[i];
   }
-  TypedComponentPtr valLoc(getComponentType(), coordLoc);
-  *valLoc = TypedComponentVal(getComponentType(), &value);
+  if (!getComponentType().isPattern()) {
+    TypedComponentPtr valLoc(getComponentType(), coordLoc);
+    *valLoc = TypedComponentVal(getComponentType(), &value);
+  }
   content->coordinateBufferUsed += content->coordinateSize;
 }
 
+template <typename CType>
+bool TensorBase::hasComponentType() const {
+  return getComponentType() == type<CType>() ||
+         (getComponentType().isPattern() && type<CType>() == Bool);
+}
+
 template <typename CType>
 void TensorBase::reinsertPackedComponents() {
   auto begin = iteratorPacked<CType>().begin();
@@ -975,11 +1076,22 @@ void TensorBase::setFromComponents(const InputIterators& begin, const InputItera
   }
 }
 
+template <typename CType>
+void TensorBase::setFromCOO(const std::vector<const int*>& coordinates,
+                            const CType* values, size_t numComponents,
+                            bool sorted) {
+  taco_uassert(hasComponentType<CType>()) <<
+    "Cannot set values of type '" << type<CType>() << "' " <<
+    "in a tensor with component type " << getComponentType();
+  setFromCOO(coordinates, static_cast<const void*>(values), numComponents,
+             sorted);
+}
+
 template <typename CType>
 CType TensorBase::at(const std::vector<int>& coordinate) {
   taco_uassert(coordinate.size() == (size_t)getOrder()) <<
     "Wrong number of indices";
-  taco_uassert(getComponentType() == type<CType>()) <<
+  taco_uassert(hasComponentType<CType>()) <<
     "Cannot get a value of type '" << type<CType>() << "' " <<
     "from a tensor with component type " << getComponentType();
   syncValues();
@@ -1049,7 +1161,8 @@ Tensor<CType>::Tensor(std::string name, std::vector<int> dimensions, Format form
 
 template <typename CType>
 Tensor<CType>::Tensor(const TensorBase& tensor) : TensorBase(tensor) {
-  taco_uassert(tensor.getComponentType() == type<CType>()) <<
+  taco_uassert(tensor.getComponentType() == type<CType>() ||
+               (tensor.getComponentType().isPattern() && type<CType>() == Bool)) <<
       "Assigning TensorBase with " << tensor.getComponentType() <<
       " components to a Tensor<" << type<CType>() << ">";
 }
@@ -1143,6 +1256,60 @@ Tensor<CType> Tensor<CType>::removeExplicitZeros(Format format) const {
   return newTensor;
 }
 
+template <typename CType>
+Tensor<CType> Tensor<CType>::block(std::vector<int> blockDimensions,
+                                   Format format) const {
+  const int order = getOrder();
+  taco_uassert(blockDimensions.size() == (size_t)order) <<
+      "Expected " << order << " block dimensions but got " <<
+      blockDimensions.size();
+  std::vector<int> newDimensions(2 * order);
+  for (int i = 0; i < order; ++i) {
+    taco_uassert(blockDimensions[i] > 0) << "Block dimensions must be positive";
+    newDimensions[i] = (getDimension(i) + blockDimensions[i] - 1) /
+                       blockDimensions[i];
+    newDimensions[order + i] = blockDimensions[i];
+  }
+
+  Tensor<CType> newTensor(newDimensions, format);
+  std::vector<int> newCoordinate(2 * order);
+  for (const auto& value : *this) {
+    for (int i = 0; i < order; ++i) {
+      newCoordinate[i] = value.first[i] / blockDimensions[i];
+      newCoordinate[order + i] = value.first[i] % blockDimensions[i];
+    }
+    newTensor.insert(newCoordinate, value.second);
+  }
+  newTensor.pack();
+  return newTensor;
+}
+
+template <typename CType>
+Tensor<CType> Tensor<CType>::unblock(std::vector<int> dimensions,
+                                     Format format) const {
+  const int order = (int)dimensions.size();
+  taco_uassert(getOrder() == 2 * order) <<
+      "A blocked tensor of order " << getOrder() << " cannot be unblocked " <<
+      "into " << order << " dimensions";
+
+  Tensor<CType> newTensor(dimensions, format);
+  std::vector<int> newCoordinate(order);
+  for (const auto& value : *this) {
+    bool inBounds = true;
+    for (int i = 0; i < order; ++i) {
+      newCoordinate[i] = value.first[i] * getDimension(order + i) +
+                         value.first[order + i];
+      inBounds &= newCoordinate[i] < dimensions[i];
+    }
+    // Skip the padding of partial blocks
+    if (inBounds) {
+      newTensor.insert(newCoordinate, value.second);
+    }
+  }
+  newTensor.pack();
+  return newTensor;
+}
+
 template <typename CType>
 TensorBase::const_iterator<int,CType> Tensor<CType>::begin() const {
   return TensorBase::iterator<CType>().begin();
@@ -1204,6 +1371,8 @@ void taco_get_parallel_schedule(ParallelSchedule *sched, int *chunk_size);
 
 /// Set maximum number of threads to use for parallel execution of tensor
 /// computations. This will be replaced by a scheduling language in the future.
+/// The limit also applies to pack(), which sorts and splits large coordinate
+/// buffers in parallel.
 void taco_set_num_threads(int num_threads);
 
 /// Get maximum number of threads to use for parallel execution of tensor 
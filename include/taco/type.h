@@ -12,7 +12,9 @@
 namespace taco {
 
 /// A basic taco type. These can be boolean, integer, unsigned integer, float
-/// or complex float at different precisions.
+/// or complex float at different precisions, or pattern.  Pattern tensors
+/// store only their sparsity structure: they have no values array and every
+/// stored component is implicitly one.
 class Datatype {
 public:
   /// The kind of type this object represents.
@@ -32,6 +34,7 @@ public:
     Float64,
     Complex64,
     Complex128,
+    Pattern,
     Undefined  /// Undefined type
   };
 
@@ -51,6 +54,7 @@ public:
   bool isFloat() const;
   bool isComplex() const;
   bool isBool() const;
+  bool isPattern() const;
   /// @}
 
   /// Returns the number of bytes required to store one element of this type.
@@ -87,6 +91,7 @@ extern Datatype Float64;
 Datatype Complex(int bits);
 extern Datatype Complex64;
 extern Datatype Complex128;
+extern Datatype Pattern;
 
 Datatype max_type(Datatype a, Datatype b);
 
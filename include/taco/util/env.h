@@ -3,6 +3,7 @@
 
 #include <string>
 #include <cstring>
+#include <mutex>
 #include <unistd.h>
 
 #include "taco/error.h"
@@ -12,6 +13,7 @@ namespace util {
 std::string getFromEnv(std::string flag, std::string dflt);
 std::string getTmpdir();
 extern std::string cachedtmpdir;
+extern std::mutex cachedtmpdirMutex;
 extern void cachedtmpdirCleanup(void);
 
 inline std::string getFromEnv(std::string flag, std::string dflt) {
@@ -24,6 +26,8 @@ inline std::string getFromEnv(std::string flag, std::string dflt) {
 }
 
 inline std::string getTmpdir() {
+  // Modules may be created on several threads at once
+  std::lock_guard<std::mutex> lock(cachedtmpdirMutex);
   if (cachedtmpdir == ""){
     // use posix logic for finding a temp dir
     auto tmpdir = getFromEnv("TMPDIR", "/tmp/");
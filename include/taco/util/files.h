@@ -4,6 +4,8 @@
 #include <string>
 #include <fstream>
 
+#include "taco/util/uncopyable.h"
+
 namespace taco {
 namespace util {
 
@@ -11,5 +13,23 @@ std::string sanitizePath(std::string path);
 
 void openStream(std::fstream& stream, std::string path, std::fstream::openmode mode);
 
+/// A file mapped into memory.  The mapping is copy-on-write: writes to it are
+/// private to the process and are never written back to the file.
+class MappedFile : Uncopyable {
+public:
+  explicit MappedFile(std::string path);
+  ~MappedFile();
+
+  /// Returns the file contents, or nullptr if the file is empty.
+  char* getData() const;
+
+  /// Returns the size of the file in bytes.
+  size_t getSize() const;
+
+private:
+  char* data;
+  size_t size;
+};
+
 }}
 #endif
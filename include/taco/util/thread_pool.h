@@ -0,0 +1,49 @@
+#ifndef TACO_UTIL_THREAD_POOL_H
+#define TACO_UTIL_THREAD_POOL_H
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <future>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+
+#include "taco/util/uncopyable.h"
+
+namespace taco {
+namespace util {
+
+/// A fixed-size pool of worker threads that run submitted tasks in FIFO order.
+class ThreadPool : Uncopyable {
+public:
+  /// Create a pool with `numThreads` workers (at least one).
+  explicit ThreadPool(size_t numThreads);
+
+  /// Wait for all submitted tasks to finish and join the workers.
+  ~ThreadPool();
+
+  /// Submit a task to the pool. The returned future becomes ready when the
+  /// task has run, and rethrows any exception the task threw.
+  std::future<void> submit(std::function<void()> task);
+
+  /// Returns the number of worker threads.
+  size_t getNumThreads() const;
+
+private:
+  void work();
+
+  std::vector<std::thread> workers;
+  std::deque<std::packaged_task<void()>> tasks;
+  std::mutex tasksMutex;
+  std::condition_variable condition;
+  bool stopping;
+};
+
+/// Split [0, n) into `numThreads` contiguous ranges and call `body` on each
+/// range in its own thread. The calling thread handles the first range.
+void parallelFor(size_t n, size_t numThreads,
+                 const std::function<void(size_t,size_t)>& body);
+
+}}
+#endif
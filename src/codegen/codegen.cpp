@@ -70,7 +70,13 @@ bool CodeGen::checkForAlloc(const Function *func) {
 // helper to translate from taco type to C type
 string CodeGen::printCType(Datatype type, bool is_ptr) {
   stringstream ret;
-  ret << type;
+  // Pattern values arrays are never read or written, so any type will do
+  if (type.isPattern()) {
+    ret << Bool;
+  }
+  else {
+    ret << type;
+  }
 
   if (is_ptr) {
     ret << "*";
@@ -194,6 +200,11 @@ string CodeGen::printContextDeclAndInit(map<Expr, string, ExprCompare> varMap,
   return ret.str();
 }
 
+string CodeGen::printIndexType(Datatype type) {
+  // 32-bit index arrays keep the plain int type the runtime helpers expect
+  return (type == Int32) ? "int" : printType(type, false);
+}
+
 string CodeGen::printTensorProperty(string varname, const GetProperty* op, bool is_ptr) {
   stringstream ret;
   string star = is_ptr ? "*" : "";
@@ -208,7 +219,7 @@ string CodeGen::printTensorProperty(string varname, const GetProperty* op, bool
     ret << " " << varname;
     return ret.str();
   } else if (op->property == TensorProperty::ValuesSize) {
-    ret << "int" << star << " " << varname;
+    ret << "int64_t" << star << " " << varname;
     return ret.str();
   }
 
@@ -222,7 +233,7 @@ string CodeGen::printTensorProperty(string varname, const GetProperty* op, bool
     ret << tp << " " << varname;
   } else {
     taco_iassert(op->property == TensorProperty::Indices);
-    tp = "int*" + star;
+    tp = printIndexType(op->type) + "*" + star;
     ret << tp << " " << varname;
   }
 
@@ -242,7 +253,7 @@ string CodeGen::unpackTensorProperty(string varname, const GetProperty* op,
     ret << tensor->name << "->vals);\n";
     return ret.str();
   } else if (op->property == TensorProperty::ValuesSize) {
-    ret << "int " << varname << " = " << tensor->name << "->vals_size;\n";
+    ret << "int64_t " << varname << " = " << tensor->name << "->vals_size;\n";
     return ret.str();
   }
 
@@ -257,10 +268,10 @@ string CodeGen::unpackTensorProperty(string varname, const GetProperty* op,
         << "->dimensions[" << op->mode << "]);\n";
   } else {
     taco_iassert(op->property == TensorProperty::Indices);
-    tp = "int*";
+    tp = printIndexType(op->type) + "*";
     auto nm = op->index;
     ret << tp << " " << restrictKeyword() << " " << varname << " = ";
-    ret << "(int*)(" << tensor->name << "->indices[" << op->mode;
+    ret << "(" << tp << ")(" << tensor->name << "->indices[" << op->mode;
     ret << "][" << nm << "]);\n";
   }
 
@@ -423,59 +434,50 @@ string CodeGen::printPack(map<tuple<Expr, TensorProperty, int, int>,
 
 // seed the unique names with all C99 keywords
 // from: http://en.cppreference.com/w/c/keyword
-map<string, int> uniqueNameCounters;
-
 void CodeGen::resetUniqueNameCounters() {
-  uniqueNameCounters =
-          {{"auto", 0},
-           {"break", 0},
-           {"case", 0},
-           {"char", 0},
-           {"const", 0},
-           {"continue", 0},
-           {"default", 0},
-           {"do", 0},
-           {"double", 0},
-           {"else", 0},
-           {"enum", 0},
-           {"extern", 0},
-           {"float", 0},
-           {"for", 0},
-           {"goto", 0},
-           {"if", 0},
-           {"inline", 0},
-           {"int", 0},
-           {"long", 0},
-           {"register", 0},
-           {"restrict", 0},
-           {restrictKeyword(), 0},
-           {"return", 0},
-           {"short", 0},
-           {"signed", 0},
-           {"sizeof", 0},
-           {"static", 0},
-           {"struct", 0},
-           {"switch", 0},
-           {"typedef", 0},
-           {"union", 0},
-           {"unsigned", 0},
-           {"void", 0},
-           {"volatile", 0},
-           {"while", 0},
-           {"bool", 0},
-           {"complex", 0},
-           {"imaginary", 0}};
+  uniqueNameGenerator = util::NameGenerator(
+          {"auto",
+           "break",
+           "case",
+           "char",
+           "const",
+           "continue",
+           "default",
+           "do",
+           "double",
+           "else",
+           "enum",
+           "extern",
+           "float",
+           "for",
+           "goto",
+           "if",
+           "inline",
+           "int",
+           "long",
+           "register",
+           "restrict",
+           restrictKeyword(),
+           "return",
+           "short",
+           "signed",
+           "sizeof",
+           "static",
+           "struct",
+           "switch",
+           "typedef",
+           "union",
+           "unsigned",
+           "void",
+           "volatile",
+           "while",
+           "bool",
+           "complex",
+           "imaginary"});
 }
 
 string CodeGen::genUniqueName(string name) {
-  stringstream os;
-  os << name;
-  if (uniqueNameCounters.count(name) > 0) {
-    os << uniqueNameCounters[name]++;
-  } else {
-    uniqueNameCounters[name] = 0;
-  }
-  return os.str();
+  return uniqueNameGenerator.getUniqueName(name);
 }
 
 static vector<const GetProperty*> sortProps(std::map<Expr, std::string, ExprCompare> map) {
@@ -4,6 +4,7 @@
 #include <memory>
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_printer.h"
+#include "taco/util/name_generator.h"
 
 namespace taco {
 namespace ir {
@@ -61,6 +62,11 @@ protected:
 private:
   virtual std::string restrictKeyword() const { return ""; }
 
+  /// Unique names are generated per code generator, so that kernels can be
+  /// generated concurrently
+  util::NameGenerator uniqueNameGenerator;
+
+  std::string printIndexType(Datatype type);
   std::string printTensorProperty(std::string varname, const GetProperty* op, bool is_ptr);
   std::string unpackTensorProperty(std::string varname, const GetProperty* op,
                               bool is_output_prop);
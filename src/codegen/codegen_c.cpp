@@ -37,6 +37,18 @@ const string cHeaders =
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
+  "#define taco_bitmapWord(_p) ((_p) >> 6)\n"
+  "#define taco_bitmapMask(_p) ((uint64_t)1 << ((_p) & 63))\n"
+  "#define taco_bitmapTest(_b,_p) (((_b)[taco_bitmapWord(_p)] & taco_bitmapMask(_p)) != 0)\n"
+  "#define taco_ctz(_w) __builtin_ctzll(_w)\n"
+  "#ifdef _OPENMP\n"
+  "#include <omp.h>\n"
+  "#define taco_threadNum() omp_get_thread_num()\n"
+  "#define taco_numThreads() omp_get_max_threads()\n"
+  "#else\n"
+  "#define taco_threadNum() 0\n"
+  "#define taco_numThreads() 1\n"
+  "#endif\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
   "typedef enum { taco_mode_dense, taco_mode_sparse } taco_mode_t;\n"
@@ -48,53 +60,92 @@ const string cHeaders =
   "  taco_mode_t* mode_types;    // mode storage types\n"
   "  uint8_t***   indices;       // tensor index data (per mode)\n"
   "  uint8_t*     vals;          // tensor values\n"
-  "  int32_t      vals_size;     // values array size\n"
+  "  int64_t      vals_size;     // values array size\n"
   "} taco_tensor_t;\n"
   "#endif\n"
   "int cmp(const void *a, const void *b) {\n"
   "  return *((const int*)a) - *((const int*)b);\n"
   "}\n"
-  "int taco_binarySearchAfter(int *array, int arrayStart, int arrayEnd, int target) {\n"
-  "  if (array[arrayStart] >= target) {\n"
-  "    return arrayStart;\n"
-  "  }\n"
-  "  int lowerBound = arrayStart; // always < target\n"
-  "  int upperBound = arrayEnd; // always >= target\n"
-  "  while (upperBound - lowerBound > 1) {\n"
-  "    int mid = (upperBound + lowerBound) / 2;\n"
-  "    int midValue = array[mid];\n"
-  "    if (midValue < target) {\n"
-  "      lowerBound = mid;\n"
-  "    }\n"
-  "    else if (midValue > target) {\n"
-  "      upperBound = mid;\n"
-  "    }\n"
-  "    else {\n"
-  "      return mid;\n"
-  "    }\n"
+  "uint64_t taco_bitmapBits(const uint64_t *bitmap, int64_t p, int64_t n) {\n"
+  "  uint64_t bits = bitmap[p >> 6] >> (p & 63);\n"
+  "  if ((p & 63) + n > 64) {\n"
+  "    bits |= bitmap[(p >> 6) + 1] << (64 - (p & 63));\n"
   "  }\n"
-  "  return upperBound;\n"
+  "  return (n < 64) ? (bits & (((uint64_t)1 << n) - 1)) : bits;\n"
   "}\n"
-  "int taco_binarySearchBefore(int *array, int arrayStart, int arrayEnd, int target) {\n"
-  "  if (array[arrayEnd] <= target) {\n"
-  "    return arrayEnd;\n"
-  "  }\n"
-  "  int lowerBound = arrayStart; // always <= target\n"
-  "  int upperBound = arrayEnd; // always > target\n"
-  "  while (upperBound - lowerBound > 1) {\n"
-  "    int mid = (upperBound + lowerBound) / 2;\n"
-  "    int midValue = array[mid];\n"
-  "    if (midValue < target) {\n"
-  "      lowerBound = mid;\n"
-  "    }\n"
-  "    else if (midValue > target) {\n"
-  "      upperBound = mid;\n"
+  "#define TACO_DEFINE_BINARY_SEARCH(T) \\\n"
+  "int64_t taco_binarySearchAfter_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayStart] >= target) { \\\n"
+  "    return arrayStart; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; \\\n"
+  "  int64_t upperBound = arrayEnd; \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    int64_t midValue = array[mid]; \\\n"
+  "    if (midValue < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } \\\n"
+  "    else if (midValue > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } \\\n"
+  "    else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return upperBound; \\\n"
+  "} \\\n"
+  "int64_t taco_binarySearchBefore_##T(T *array, int64_t arrayStart, int64_t arrayEnd, int64_t target) { \\\n"
+  "  if (array[arrayEnd] <= target) { \\\n"
+  "    return arrayEnd; \\\n"
+  "  } \\\n"
+  "  int64_t lowerBound = arrayStart; \\\n"
+  "  int64_t upperBound = arrayEnd; \\\n"
+  "  while (upperBound - lowerBound > 1) { \\\n"
+  "    int64_t mid = (upperBound + lowerBound) / 2; \\\n"
+  "    int64_t midValue = array[mid]; \\\n"
+  "    if (midValue < target) { \\\n"
+  "      lowerBound = mid; \\\n"
+  "    } \\\n"
+  "    else if (midValue > target) { \\\n"
+  "      upperBound = mid; \\\n"
+  "    } \\\n"
+  "    else { \\\n"
+  "      return mid; \\\n"
+  "    } \\\n"
+  "  } \\\n"
+  "  return lowerBound; \\\n"
+  "}\n"
+  "TACO_DEFINE_BINARY_SEARCH(uint8_t)\n"
+  "TACO_DEFINE_BINARY_SEARCH(uint16_t)\n"
+  "TACO_DEFINE_BINARY_SEARCH(int32_t)\n"
+  "TACO_DEFINE_BINARY_SEARCH(int64_t)\n"
+  "// Binary searches dispatch on the type of the searched index array\n"
+  "#define taco_binarySearchAfter(array, ...) _Generic((array), \\\n"
+  "  uint8_t*: taco_binarySearchAfter_uint8_t, \\\n"
+  "  uint16_t*: taco_binarySearchAfter_uint16_t, \\\n"
+  "  int64_t*: taco_binarySearchAfter_int64_t, \\\n"
+  "  default: taco_binarySearchAfter_int32_t)(array, __VA_ARGS__)\n"
+  "#define taco_binarySearchBefore(array, ...) _Generic((array), \\\n"
+  "  uint8_t*: taco_binarySearchBefore_uint8_t, \\\n"
+  "  uint16_t*: taco_binarySearchBefore_uint16_t, \\\n"
+  "  int64_t*: taco_binarySearchBefore_int64_t, \\\n"
+  "  default: taco_binarySearchBefore_int32_t)(array, __VA_ARGS__)\n"
+  "// Returns the run in [runsStart, runsEnd) of a run-length encoded level\n"
+  "// whose [start, end) coordinates contain target, or runsEnd if none does\n"
+  "int32_t taco_runSearch(int32_t *runs, int32_t runsStart, int32_t runsEnd, int32_t target) {\n"
+  "  int32_t lowerBound = runsStart;\n"
+  "  int32_t upperBound = runsEnd;\n"
+  "  while (lowerBound < upperBound) {\n"
+  "    int32_t mid = lowerBound + (upperBound - lowerBound) / 2;\n"
+  "    if (runs[2 * mid + 1] <= target) {\n"
+  "      lowerBound = mid + 1;\n"
   "    }\n"
   "    else {\n"
-  "      return mid;\n"
+  "      upperBound = mid;\n"
   "    }\n"
   "  }\n"
-  "  return lowerBound;\n"
+  "  return (lowerBound < runsEnd && runs[2 * lowerBound] <= target) ? lowerBound : runsEnd;\n"
   "}\n"
   "taco_tensor_t* init_taco_tensor_t(int32_t order, int32_t csize,\n"
   "                                  int32_t* dimensions, int32_t* mode_ordering,\n"
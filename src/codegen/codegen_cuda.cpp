@@ -38,6 +38,17 @@ const string cHeaders =
   "#define TACO_MIN(_a,_b) ((_a) < (_b) ? (_a) : (_b))\n"
   "#define TACO_MAX(_a,_b) ((_a) > (_b) ? (_a) : (_b))\n"
   "#define TACO_DEREF(_a) (((___context___*)(*__ctx__))->_a)\n"
+  "#define taco_bitmapWord(_p) ((_p) >> 6)\n"
+  "#define taco_bitmapMask(_p) ((uint64_t)1 << ((_p) & 63))\n"
+  "#define taco_bitmapTest(_b,_p) (((_b)[taco_bitmapWord(_p)] & taco_bitmapMask(_p)) != 0)\n"
+  "#define taco_ctz(_w) (__ffsll(_w) - 1)\n"
+  "__device__ __host__ inline uint64_t taco_bitmapBits(const uint64_t *bitmap, int64_t p, int64_t n) {\n"
+  "  uint64_t bits = bitmap[p >> 6] >> (p & 63);\n"
+  "  if ((p & 63) + n > 64) {\n"
+  "    bits |= bitmap[(p >> 6) + 1] << (64 - (p & 63));\n"
+  "  }\n"
+  "  return (n < 64) ? (bits & (((uint64_t)1 << n) - 1)) : bits;\n"
+  "}\n"
   "#ifndef TACO_TENSOR_T_DEFINED\n"
   "#define TACO_TENSOR_T_DEFINED\n"
   "typedef enum { taco_mode_dense, taco_mode_sparse } taco_mode_t;\n"
@@ -49,7 +60,7 @@ const string cHeaders =
   "  taco_mode_t* mode_types;    // mode storage types\n"
   "  uint8_t***   indices;       // tensor index data (per mode)\n"
   "  uint8_t*     vals;          // tensor values\n"
-  "  int32_t      vals_size;     // values array size\n"
+  "  int64_t      vals_size;     // values array size\n"
   "} taco_tensor_t;\n"
   "#endif\n"
   "#endif\n\n"; // // https://stackoverflow.com/questions/14038589/what-is-the-canonical-way-to-check-for-errors-using-the-cuda-runtime-api
@@ -106,6 +117,20 @@ const string gpuAssertMacro =
   "  }\n"
   "  return lowerBound;\n"
   "}\n"
+  "__device__ __host__ int32_t taco_runSearch(int32_t *runs, int32_t runsStart, int32_t runsEnd, int32_t target) {\n"
+  "  int32_t lowerBound = runsStart;\n"
+  "  int32_t upperBound = runsEnd;\n"
+  "  while (lowerBound < upperBound) {\n"
+  "    int32_t mid = lowerBound + (upperBound - lowerBound) / 2;\n"
+  "    if (runs[2 * mid + 1] <= target) {\n"
+  "      lowerBound = mid + 1;\n"
+  "    }\n"
+  "    else {\n"
+  "      upperBound = mid;\n"
+  "    }\n"
+  "  }\n"
+  "  return (lowerBound < runsEnd && runs[2 * lowerBound] <= target) ? lowerBound : runsEnd;\n"
+  "}\n"
   "__global__ void taco_binarySearchBeforeBlock(int * __restrict__ array, int * __restrict__ results, int arrayStart, int arrayEnd, int values_per_block, int num_blocks) {\n"
   "  int thread = threadIdx.x;\n"
   "  int block = blockIdx.x;\n"
@@ -0,0 +1,1240 @@
+#include "codegen_llvm.h"
+
+#include "taco/llvm.h"
+#include "taco/error.h"
+
+#if LLVM_BUILT
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <dlfcn.h>
+
+#include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/JITTargetMachineBuilder.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Passes/PassBuilder.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Target/TargetMachine.h>
+
+#include "taco/ir/ir_visitor.h"
+#include "taco/ir/simplify.h"
+#include "taco/util/collections.h"
+#endif
+
+using namespace std;
+
+namespace taco {
+namespace ir {
+
+#if LLVM_BUILT
+namespace {
+
+// Host implementations of the runtime helpers that CodeGen_C emits at the top
+// of every generated source file.  They are linked into the JIT'd code under
+// their C names.
+int binarySearchAfter(int* array, int arrayStart, int arrayEnd, int target) {
+  if (array[arrayStart] >= target) {
+    return arrayStart;
+  }
+  int lowerBound = arrayStart; // always < target
+  int upperBound = arrayEnd; // always >= target
+  while (upperBound - lowerBound > 1) {
+    int mid = (upperBound + lowerBound) / 2;
+    int midValue = array[mid];
+    if (midValue < target) {
+      lowerBound = mid;
+    }
+    else if (midValue > target) {
+      upperBound = mid;
+    }
+    else {
+      return mid;
+    }
+  }
+  return upperBound;
+}
+
+int binarySearchBefore(int* array, int arrayStart, int arrayEnd, int target) {
+  if (array[arrayEnd] <= target) {
+    return arrayEnd;
+  }
+  int lowerBound = arrayStart; // always <= target
+  int upperBound = arrayEnd; // always > target
+  while (upperBound - lowerBound > 1) {
+    int mid = (upperBound + lowerBound) / 2;
+    int midValue = array[mid];
+    if (midValue < target) {
+      lowerBound = mid;
+    }
+    else if (midValue > target) {
+      upperBound = mid;
+    }
+    else {
+      return mid;
+    }
+  }
+  return lowerBound;
+}
+
+const map<string,void*> runtimeHelpers = {
+  {"taco_binarySearchAfter",  reinterpret_cast<void*>(&binarySearchAfter)},
+  {"taco_binarySearchBefore", reinterpret_cast<void*>(&binarySearchBefore)}
+};
+
+template <typename T>
+T check(llvm::Expected<T> value) {
+  if (!value) {
+    taco_uerror << "LLVM JIT error: " << llvm::toString(value.takeError());
+  }
+  return std::move(*value);
+}
+
+void check(llvm::Error error) {
+  if (error) {
+    taco_uerror << "LLVM JIT error: " << llvm::toString(std::move(error));
+  }
+}
+
+bool isSupportedType(Datatype type) {
+  switch (type.getKind()) {
+    case Datatype::Bool:
+    case Datatype::UInt8:
+    case Datatype::UInt16:
+    case Datatype::UInt32:
+    case Datatype::UInt64:
+    case Datatype::Int8:
+    case Datatype::Int16:
+    case Datatype::Int32:
+    case Datatype::Int64:
+    case Datatype::Float32:
+    case Datatype::Float64:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Decides whether every construct in a function can be compiled in-process
+class CheckSupported : public IRVisitor {
+public:
+  bool supported = true;
+
+protected:
+  using IRVisitor::visit;
+
+  void visit(const Function* op) {
+    if (op->getReturnType().second != Datatype()) {
+      supported = false;
+    }
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Literal* op) {
+    supported &= isSupportedType(op->type);
+  }
+
+  void visit(const Var* op) {
+    supported &= isSupportedType(op->type) && !op->is_parameter;
+  }
+
+  void visit(const Cast* op) {
+    supported &= isSupportedType(op->type);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Load* op) {
+    supported &= isSupportedType(op->type);
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Call* op) {
+    supported &= isSupportedType(op->type);
+    if (runtimeHelpers.count(op->func) == 0 &&
+        dlsym(RTLD_DEFAULT, op->func.c_str()) == nullptr) {
+      supported = false;
+    }
+    IRVisitor::visit(op);
+  }
+
+  void visit(const GetProperty* op) {
+    switch (op->property) {
+      case TensorProperty::Indices:
+        // Index arrays are loaded and searched as 32-bit integers, so kernels
+        // over wider or narrower positions and coordinates stay on the C backend
+        supported &= (op->type == Int32);
+        break;
+      case TensorProperty::Dimension:
+      case TensorProperty::Values:
+      case TensorProperty::ValuesSize:
+        break;
+      default:
+        supported = false;
+        break;
+    }
+    IRVisitor::visit(op);
+  }
+
+  void visit(const For* op) {
+#if USE_OPENMP
+    // Keep parallel loops on the C backend, which runs them with OpenMP
+    if (op->kind != LoopKind::Serial && op->kind != LoopKind::Vectorized) {
+      supported = false;
+    }
+#endif
+    IRVisitor::visit(op);
+  }
+
+  void visit(const Yield* op) {
+    supported = false;
+  }
+};
+
+class CheckForAlloc : public IRVisitor {
+public:
+  bool hasAlloc = false;
+
+protected:
+  using IRVisitor::visit;
+
+  void visit(const Allocate* op) {
+    hasAlloc = true;
+  }
+};
+
+// Undo the C escape sequences a printf format string is written with
+string unescape(const string& str) {
+  string result;
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] != '\\' || i + 1 == str.size()) {
+      result += str[i];
+      continue;
+    }
+    switch (str[++i]) {
+      case 'n': result += '\n'; break;
+      case 't': result += '\t'; break;
+      default:  result += str[i]; break;
+    }
+  }
+  return result;
+}
+
+/// Emits LLVM IR for lowered functions.  Expressions evaluate to registers
+/// whose types follow the C99 types CodeGen_C would declare (with booleans
+/// held as i1), and variables and unpacked tensor properties live in stack
+/// slots that LLVM promotes to registers.
+class FunctionGen : public IRVisitorStrict {
+public:
+  explicit FunctionGen(llvm::Module* module)
+      : module(module), context(module->getContext()), builder(context) {
+    // mirror the -ffast-math the C backend compiles with
+    llvm::FastMathFlags fastMath;
+    fastMath.setFast();
+    builder.setFastMathFlags(fastMath);
+
+    // This *must* be kept in sync with taco_tensor_t.h
+    llvm::Type* i32 = builder.getInt32Ty();
+    llvm::Type* i8ptr = builder.getInt8PtrTy();
+    tensorType = llvm::StructType::create(context, {
+      i32,                                           // order
+      i32->getPointerTo(),                           // dimensions
+      i32,                                           // csize
+      i32->getPointerTo(),                           // mode_ordering
+      i32->getPointerTo(),                           // mode_types
+      i8ptr->getPointerTo()->getPointerTo(),         // indices
+      i8ptr,                                         // vals
+      builder.getInt64Ty()                           // vals_size
+    }, "taco_tensor_t");
+  }
+
+  /// Emit a function with the same signature as CodeGen_C's.
+  void compile(const Function* func) {
+    vector<Expr> params = func->outputs;
+    params.insert(params.end(), func->inputs.begin(), func->inputs.end());
+
+    vector<llvm::Type*> paramTypes;
+    for (auto& param : params) {
+      paramTypes.push_back(getVarType(param.as<Var>()));
+    }
+    llvm::Function* function =
+        llvm::Function::Create(llvm::FunctionType::get(builder.getInt32Ty(),
+                                                       paramTypes, false),
+                               llvm::Function::ExternalLinkage, func->name,
+                               module);
+
+    varSlots.clear();
+    propertySlots.clear();
+    entry = llvm::BasicBlock::Create(context, "entry", function);
+    llvm::BasicBlock* body = llvm::BasicBlock::Create(context, "body",
+                                                      function);
+
+    llvm::IRBuilder<> entryBuilder(entry);
+    for (size_t i = 0; i < params.size(); ++i) {
+      const Var* var = params[i].as<Var>();
+      function->getArg(i)->setName(var->name);
+      entryBuilder.CreateStore(function->getArg(i), getVar(var).addr);
+    }
+
+    // generate the same simplified body CodeGen_C prints
+    builder.SetInsertPoint(body);
+    codegen(simplify(func->body));
+
+    // write back the properties of output tensors, as CodeGen_C's printPack
+    CheckForAlloc allocChecker;
+    func->body.accept(&allocChecker);
+    if (allocChecker.hasAlloc) {
+      for (auto& property : propertySlots) {
+        if (util::contains(func->outputs, get<0>(property.first))) {
+          pack(get<0>(property.first), get<1>(property.first),
+               get<2>(property.first), get<3>(property.first),
+               load(property.second));
+        }
+      }
+    }
+    builder.CreateRet(builder.getInt32(0));
+
+    llvm::IRBuilder<>(entry).CreateBr(body);
+  }
+
+  /// Emit a function that unpacks an array of pointers representing a mix of
+  /// taco_tensor_t* and scalars into a call, as CodeGen_C::generateShim.
+  void compileShim(const Function* func) {
+    llvm::Function* function = module->getFunction(func->name);
+    llvm::FunctionType* type = function->getFunctionType();
+    llvm::Type* voidptr = builder.getInt8PtrTy();
+
+    llvm::Function* shim =
+        llvm::Function::Create(llvm::FunctionType::get(builder.getInt32Ty(),
+                                   {voidptr->getPointerTo()}, false),
+                               llvm::Function::ExternalLinkage,
+                               "_shim_" + func->name, module);
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "entry", shim));
+
+    llvm::Value* parameterPack = shim->getArg(0);
+    vector<llvm::Value*> args;
+    for (unsigned i = 0; i < type->getNumParams(); ++i) {
+      llvm::Value* arg = builder.CreateLoad(voidptr,
+          builder.CreateConstInBoundsGEP1_64(voidptr, parameterPack, i));
+      llvm::Type* paramType = type->getParamType(i);
+      taco_iassert(paramType->isPointerTy() || paramType->isIntegerTy())
+          << "Cannot pass a floating point scalar through a parameter pack";
+      args.push_back(paramType->isPointerTy()
+                     ? builder.CreateBitCast(arg, paramType)
+                     : builder.CreatePtrToInt(arg, paramType));
+    }
+    builder.CreateRet(builder.CreateCall(function, args));
+  }
+
+protected:
+  using IRVisitorStrict::visit;
+
+  /// A stack slot holding a variable or an unpacked tensor property.
+  struct Slot {
+    llvm::Value* addr;
+    llvm::Type* memType;
+    Datatype type;
+    bool isPtr;
+  };
+
+  typedef tuple<Expr,TensorProperty,int,int> PropertyKey;
+
+  struct PropertyKeyCompare {
+    bool operator()(const PropertyKey& a, const PropertyKey& b) const {
+      return make_tuple(get<0>(a).ptr, get<1>(a), get<2>(a), get<3>(a)) <
+             make_tuple(get<0>(b).ptr, get<1>(b), get<2>(b), get<3>(b));
+    }
+  };
+
+  llvm::Module* module;
+  llvm::LLVMContext& context;
+  llvm::IRBuilder<> builder;
+  llvm::StructType* tensorType;
+
+  llvm::BasicBlock* entry = nullptr;
+  map<const Var*, Slot> varSlots;
+  map<PropertyKey, Slot, PropertyKeyCompare> propertySlots;
+
+  /// Where a Break statement (emitted as `continue` in C) jumps to
+  vector<llvm::BasicBlock*> continueTargets;
+
+  /// The result of the last expression visited
+  llvm::Value* value = nullptr;
+
+  llvm::Value* codegen(Expr expr) {
+    value = nullptr;
+    expr.accept(this);
+    taco_iassert(value) << "LLVM codegen produced no value for " << expr;
+    return value;
+  }
+
+  void codegen(Stmt stmt) {
+    stmt.accept(this);
+  }
+
+  /// The type values of `type` are stored with in memory
+  llvm::Type* llvmType(Datatype type) {
+    switch (type.getKind()) {
+      case Datatype::Bool:  // C99 stores _Bool in a byte
+      case Datatype::UInt8:
+      case Datatype::Int8:
+        return builder.getInt8Ty();
+      case Datatype::UInt16:
+      case Datatype::Int16:
+        return builder.getInt16Ty();
+      case Datatype::UInt32:
+      case Datatype::Int32:
+        return builder.getInt32Ty();
+      case Datatype::UInt64:
+      case Datatype::Int64:
+        return builder.getInt64Ty();
+      case Datatype::Float32:
+        return builder.getFloatTy();
+      case Datatype::Float64:
+        return builder.getDoubleTy();
+      default:
+        taco_ierror << "LLVM codegen does not support " << type;
+        return nullptr;
+    }
+  }
+
+  /// The type values of `type` are held in registers with
+  llvm::Type* registerType(Datatype type) {
+    return type.isBool() ? builder.getInt1Ty() : llvmType(type);
+  }
+
+  llvm::Type* getVarType(const Var* var) {
+    if (var->is_tensor) {
+      return tensorType->getPointerTo();
+    }
+    llvm::Type* type = llvmType(var->type);
+    return var->is_ptr ? type->getPointerTo() : type;
+  }
+
+  llvm::Value* createSlot(llvm::Type* type, string name) {
+    return llvm::IRBuilder<>(entry).CreateAlloca(type, nullptr, name);
+  }
+
+  Slot getVar(const Var* var) {
+    if (varSlots.count(var) == 0) {
+      llvm::Type* type = getVarType(var);
+      varSlots[var] = {createSlot(type, var->name), type, var->type,
+                       var->is_ptr || var->is_tensor};
+    }
+    return varSlots.at(var);
+  }
+
+  /// Get the slot of a tensor property, unpacking it from the tensor at the
+  /// start of the function the first time it is used (as CodeGen_C's
+  /// printDecls does for every property).
+  Slot getProperty(const GetProperty* op) {
+    PropertyKey key(op->tensor, op->property, op->mode, op->index);
+    if (propertySlots.count(key)) {
+      return propertySlots.at(key);
+    }
+
+    const Var* tensorVar = op->tensor.as<Var>();
+    taco_iassert(tensorVar && varSlots.count(tensorVar))
+        << "Properties can only be unpacked from input and output tensors";
+
+    llvm::IRBuilder<> entryBuilder(entry);
+    llvm::Value* tensor = entryBuilder.CreateLoad(tensorType->getPointerTo(),
+                                                  varSlots.at(tensorVar).addr);
+    llvm::Type* i32 = entryBuilder.getInt32Ty();
+    llvm::Type* i8ptr = entryBuilder.getInt8PtrTy();
+    Slot slot;
+    llvm::Value* property = nullptr;
+    switch (op->property) {
+      case TensorProperty::Dimension: {
+        llvm::Value* dimensions = entryBuilder.CreateLoad(i32->getPointerTo(),
+            entryBuilder.CreateStructGEP(tensorType, tensor, 1));
+        property = entryBuilder.CreateLoad(i32,
+            entryBuilder.CreateConstInBoundsGEP1_32(i32, dimensions, op->mode));
+        slot = {nullptr, i32, Int32, false};
+        break;
+      }
+      case TensorProperty::Indices: {
+        llvm::Value* indices = entryBuilder.CreateLoad(
+            i8ptr->getPointerTo()->getPointerTo(),
+            entryBuilder.CreateStructGEP(tensorType, tensor, 5));
+        llvm::Value* modeIndices = entryBuilder.CreateLoad(
+            i8ptr->getPointerTo(),
+            entryBuilder.CreateConstInBoundsGEP1_32(i8ptr->getPointerTo(),
+                                                    indices, op->mode));
+        property = entryBuilder.CreateLoad(i8ptr,
+            entryBuilder.CreateConstInBoundsGEP1_32(i8ptr, modeIndices,
+                                                    op->index));
+        property = entryBuilder.CreateBitCast(property, i32->getPointerTo());
+        slot = {nullptr, i32->getPointerTo(), Int32, true};
+        break;
+      }
+      case TensorProperty::Values: {
+        llvm::Type* type = llvmType(tensorVar->type)->getPointerTo();
+        property = entryBuilder.CreateLoad(i8ptr,
+            entryBuilder.CreateStructGEP(tensorType, tensor, 6));
+        property = entryBuilder.CreateBitCast(property, type);
+        slot = {nullptr, type, tensorVar->type, true};
+        break;
+      }
+      case TensorProperty::ValuesSize: {
+        llvm::Type* i64 = builder.getInt64Ty();
+        property = entryBuilder.CreateLoad(i64,
+            entryBuilder.CreateStructGEP(tensorType, tensor, 7));
+        slot = {nullptr, i64, Int64, false};
+        break;
+      }
+      default:
+        taco_ierror << "LLVM codegen cannot unpack " << op->name;
+        break;
+    }
+    slot.addr = createSlot(slot.memType, op->name);
+    entryBuilder.CreateStore(property, slot.addr);
+    propertySlots.insert({key, slot});
+    return slot;
+  }
+
+  /// Store a property of an output tensor back into the tensor
+  void pack(Expr tensorExpr, TensorProperty property, int mode, int index,
+            llvm::Value* value) {
+    llvm::Value* tensor = load(getVar(tensorExpr.as<Var>()));
+    llvm::Type* i8ptr = builder.getInt8PtrTy();
+    switch (property) {
+      case TensorProperty::Values:
+        builder.CreateStore(builder.CreateBitCast(value, i8ptr),
+                            builder.CreateStructGEP(tensorType, tensor, 6));
+        break;
+      case TensorProperty::ValuesSize:
+        builder.CreateStore(value,
+                            builder.CreateStructGEP(tensorType, tensor, 7));
+        break;
+      case TensorProperty::Indices: {
+        llvm::Value* indices = builder.CreateLoad(
+            i8ptr->getPointerTo()->getPointerTo(),
+            builder.CreateStructGEP(tensorType, tensor, 5));
+        llvm::Value* modeIndices = builder.CreateLoad(i8ptr->getPointerTo(),
+            builder.CreateConstInBoundsGEP1_32(i8ptr->getPointerTo(), indices,
+                                               mode));
+        builder.CreateStore(builder.CreateBitCast(value, i8ptr),
+            builder.CreateConstInBoundsGEP1_32(i8ptr, modeIndices, index));
+        break;
+      }
+      default:
+        break;
+    }
+  }
+
+  /// Get the slot an assignable expression refers to
+  Slot getLValue(Expr expr) {
+    if (expr.as<Var>()) {
+      return getVar(expr.as<Var>());
+    }
+    else if (expr.as<GetProperty>()) {
+      return getProperty(expr.as<GetProperty>());
+    }
+    const Load* load = expr.as<Load>();
+    taco_iassert(load) << "Cannot assign to " << expr;
+    llvm::Type* type = llvmType(load->type);
+    return {builder.CreateInBoundsGEP(type, codegen(load->arr),
+                                      index(load->loc)),
+            type, load->type, false};
+  }
+
+  llvm::Value* load(const Slot& slot) {
+    llvm::Value* result = builder.CreateLoad(slot.memType, slot.addr);
+    if (!slot.isPtr && slot.type.isBool()) {
+      result = builder.CreateICmpNE(result,
+                                    llvm::ConstantInt::get(slot.memType, 0));
+    }
+    return result;
+  }
+
+  void store(const Slot& slot, llvm::Value* value, Datatype valueType) {
+    if (slot.isPtr) {
+      value = value->getType()->isPointerTy()
+              ? builder.CreateBitCast(value, slot.memType)
+              : builder.CreateIntToPtr(value, slot.memType);
+    }
+    else {
+      value = cast(value, valueType, slot.type);
+      if (slot.type.isBool()) {
+        value = builder.CreateZExt(value, slot.memType);
+      }
+    }
+    builder.CreateStore(value, slot.addr);
+  }
+
+  /// Convert a register of type `from` to type `to` as C99 does.  Pointers
+  /// are returned unchanged.
+  llvm::Value* cast(llvm::Value* value, Datatype from, Datatype to) {
+    llvm::Type* type = registerType(to);
+    if (value->getType()->isPointerTy() || value->getType() == type) {
+      return value;
+    }
+    if (to.isBool()) {
+      return value->getType()->isFloatingPointTy()
+             ? builder.CreateFCmpUNE(value,
+                                     llvm::ConstantFP::get(value->getType(), 0))
+             : builder.CreateICmpNE(value,
+                                    llvm::ConstantInt::get(value->getType(), 0));
+    }
+    if (value->getType()->isIntegerTy()) {
+      bool isSigned = from.isInt();
+      if (type->isIntegerTy()) {
+        return builder.CreateIntCast(value, type, isSigned);
+      }
+      return isSigned ? builder.CreateSIToFP(value, type)
+                      : builder.CreateUIToFP(value, type);
+    }
+    if (type->isIntegerTy()) {
+      return to.isUInt() ? builder.CreateFPToUI(value, type)
+                         : builder.CreateFPToSI(value, type);
+    }
+    return builder.CreateFPCast(value, type);
+  }
+
+  llvm::Value* toBool(Expr expr) {
+    return cast(codegen(expr), expr.type(), Bool);
+  }
+
+  /// Evaluate an array offset as a 64-bit integer
+  llvm::Value* index(Expr loc) {
+    return cast(codegen(loc), loc.type(), Int64);
+  }
+
+  llvm::Value* compare(Expr a, Expr b, llvm::CmpInst::Predicate signedPred,
+                       llvm::CmpInst::Predicate unsignedPred,
+                       llvm::CmpInst::Predicate floatPred) {
+    llvm::Value* valueA = codegen(a);
+    llvm::Value* valueB = codegen(b);
+    if (valueA->getType()->isPointerTy() || valueB->getType()->isPointerTy()) {
+      llvm::Type* type = valueA->getType()->isPointerTy() ? valueA->getType()
+                                                          : valueB->getType();
+      valueA = valueA->getType()->isPointerTy()
+               ? builder.CreateBitCast(valueA, type)
+               : builder.CreateIntToPtr(valueA, type);
+      valueB = valueB->getType()->isPointerTy()
+               ? builder.CreateBitCast(valueB, type)
+               : builder.CreateIntToPtr(valueB, type);
+      return builder.CreateICmp(unsignedPred, valueA, valueB);
+    }
+    Datatype type = max_type(a.type(), b.type());
+    valueA = cast(valueA, a.type(), type);
+    valueB = cast(valueB, b.type(), type);
+    if (type.isFloat()) {
+      return builder.CreateFCmp(floatPred, valueA, valueB);
+    }
+    return builder.CreateICmp(type.isInt() ? signedPred : unsignedPred,
+                              valueA, valueB);
+  }
+
+  /// Evaluate the operands of an arithmetic node, converted to its type
+  pair<llvm::Value*,llvm::Value*> operands(Expr a, Expr b, Datatype type) {
+    llvm::Value* valueA = cast(codegen(a), a.type(), type);
+    llvm::Value* valueB = cast(codegen(b), b.type(), type);
+    return {valueA, valueB};
+  }
+
+  llvm::FunctionCallee getRuntimeFunction(string name, llvm::Type* result,
+                                          vector<llvm::Type*> params,
+                                          bool isVarArg=false) {
+    return module->getOrInsertFunction(name,
+        llvm::FunctionType::get(result, params, isVarArg));
+  }
+
+  void branchTo(llvm::BasicBlock* block) {
+    builder.CreateBr(block);
+    llvm::Function* function = builder.GetInsertBlock()->getParent();
+    builder.SetInsertPoint(llvm::BasicBlock::Create(context, "", function));
+  }
+
+  llvm::BasicBlock* newBlock(string name) {
+    return llvm::BasicBlock::Create(context, name,
+                                    builder.GetInsertBlock()->getParent());
+  }
+
+  void visit(const Literal* op) {
+    llvm::Type* type = registerType(op->type);
+    if (op->type.isBool()) {
+      value = builder.getInt1(op->getBoolValue());
+    }
+    else if (op->type.isInt()) {
+      value = llvm::ConstantInt::get(type, op->getIntValue(), true);
+    }
+    else if (op->type.isUInt()) {
+      value = llvm::ConstantInt::get(type, op->getUIntValue());
+    }
+    else {
+      value = llvm::ConstantFP::get(type, op->getFloatValue());
+    }
+  }
+
+  void visit(const Var* op) {
+    value = load(getVar(op));
+  }
+
+  void visit(const Neg* op) {
+    llvm::Value* a = codegen(op->a);
+    value = a->getType()->isFloatingPointTy() ? builder.CreateFNeg(a)
+                                              : builder.CreateNeg(a);
+  }
+
+  void visit(const Sqrt* op) {
+    value = builder.CreateUnaryIntrinsic(llvm::Intrinsic::sqrt,
+        cast(codegen(op->a), op->a.type(), op->type));
+  }
+
+  void visit(const Add* op) {
+    llvm::Value* a = codegen(op->a);
+    if (a->getType()->isPointerTy()) {
+      value = builder.CreateInBoundsGEP(llvmType(op->a.type()), a,
+                                        index(op->b));
+      return;
+    }
+    auto values = operands(op->a, op->b, op->type);
+    value = op->type.isFloat()
+            ? builder.CreateFAdd(values.first, values.second)
+            : builder.CreateAdd(values.first, values.second);
+  }
+
+  void visit(const Sub* op) {
+    auto values = operands(op->a, op->b, op->type);
+    value = op->type.isFloat()
+            ? builder.CreateFSub(values.first, values.second)
+            : builder.CreateSub(values.first, values.second);
+  }
+
+  void visit(const Mul* op) {
+    auto values = operands(op->a, op->b, op->type);
+    value = op->type.isFloat()
+            ? builder.CreateFMul(values.first, values.second)
+            : builder.CreateMul(values.first, values.second);
+  }
+
+  void visit(const Div* op) {
+    auto values = operands(op->a, op->b, op->type);
+    value = op->type.isFloat() ? builder.CreateFDiv(values.first, values.second)
+          : op->type.isUInt()  ? builder.CreateUDiv(values.first, values.second)
+          :                      builder.CreateSDiv(values.first, values.second);
+  }
+
+  void visit(const Rem* op) {
+    auto values = operands(op->a, op->b, op->type);
+    value = op->type.isFloat() ? builder.CreateFRem(values.first, values.second)
+          : op->type.isUInt()  ? builder.CreateURem(values.first, values.second)
+          :                      builder.CreateSRem(values.first, values.second);
+  }
+
+  /// Fold the operands of a Min or Max as nested TACO_MIN/TACO_MAX macros do
+  llvm::Value* minmax(const vector<Expr>& operands, Datatype type, bool isMin) {
+    llvm::Value* result = cast(codegen(operands.back()),
+                               operands.back().type(), type);
+    for (size_t i = operands.size() - 1; i-- > 0;) {
+      llvm::Value* operand = cast(codegen(operands[i]), operands[i].type(),
+                                  type);
+      llvm::Value* cond;
+      if (type.isFloat()) {
+        cond = isMin ? builder.CreateFCmpOLT(operand, result)
+                     : builder.CreateFCmpOGT(operand, result);
+      }
+      else if (type.isInt()) {
+        cond = isMin ? builder.CreateICmpSLT(operand, result)
+                     : builder.CreateICmpSGT(operand, result);
+      }
+      else {
+        cond = isMin ? builder.CreateICmpULT(operand, result)
+                     : builder.CreateICmpUGT(operand, result);
+      }
+      result = builder.CreateSelect(cond, operand, result);
+    }
+    return result;
+  }
+
+  void visit(const Min* op) {
+    value = minmax(op->operands, op->type, true);
+  }
+
+  void visit(const Max* op) {
+    value = minmax(op->operands, op->type, false);
+  }
+
+  void visit(const BitAnd* op) {
+    auto values = operands(op->a, op->b, max_type(op->a.type(), op->b.type()));
+    value = builder.CreateAnd(values.first, values.second);
+  }
+
+  void visit(const BitOr* op) {
+    auto values = operands(op->a, op->b, max_type(op->a.type(), op->b.type()));
+    value = builder.CreateOr(values.first, values.second);
+  }
+
+  void visit(const Eq* op) {
+    value = compare(op->a, op->b, llvm::CmpInst::ICMP_EQ,
+                    llvm::CmpInst::ICMP_EQ, llvm::CmpInst::FCMP_OEQ);
+  }
+
+  void visit(const Neq* op) {
+    value = compare(op->a, op->b, llvm::CmpInst::ICMP_NE,
+                    llvm::CmpInst::ICMP_NE, llvm::CmpInst::FCMP_UNE);
+  }
+
+  void visit(const Gt* op) {
+    value = compare(op->a, op->b, llvm::CmpInst::ICMP_SGT,
+                    llvm::CmpInst::ICMP_UGT, llvm::CmpInst::FCMP_OGT);
+  }
+
+  void visit(const Lt* op) {
+    value = compare(op->a, op->b, llvm::CmpInst::ICMP_SLT,
+                    llvm::CmpInst::ICMP_ULT, llvm::CmpInst::FCMP_OLT);
+  }
+
+  void visit(const Gte* op) {
+    value = compare(op->a, op->b, llvm::CmpInst::ICMP_SGE,
+                    llvm::CmpInst::ICMP_UGE, llvm::CmpInst::FCMP_OGE);
+  }
+
+  void visit(const Lte* op) {
+    value = compare(op->a, op->b, llvm::CmpInst::ICMP_SLE,
+                    llvm::CmpInst::ICMP_ULE, llvm::CmpInst::FCMP_OLE);
+  }
+
+  /// Short-circuit a && b or a || b
+  llvm::Value* logical(Expr a, Expr b, bool isAnd) {
+    llvm::Value* valueA = toBool(a);
+    llvm::BasicBlock* start = builder.GetInsertBlock();
+    llvm::BasicBlock* rhs = newBlock(isAnd ? "and_rhs" : "or_rhs");
+    llvm::BasicBlock* done = newBlock(isAnd ? "and_done" : "or_done");
+    if (isAnd) {
+      builder.CreateCondBr(valueA, rhs, done);
+    }
+    else {
+      builder.CreateCondBr(valueA, done, rhs);
+    }
+    builder.SetInsertPoint(rhs);
+    llvm::Value* valueB = toBool(b);
+    llvm::BasicBlock* rhsEnd = builder.GetInsertBlock();
+    builder.CreateBr(done);
+
+    builder.SetInsertPoint(done);
+    llvm::PHINode* result = builder.CreatePHI(builder.getInt1Ty(), 2);
+    result->addIncoming(builder.getInt1(!isAnd), start);
+    result->addIncoming(valueB, rhsEnd);
+    return result;
+  }
+
+  void visit(const And* op) {
+    value = logical(op->a, op->b, true);
+  }
+
+  void visit(const Or* op) {
+    value = logical(op->a, op->b, false);
+  }
+
+  void visit(const Cast* op) {
+    llvm::Value* a = codegen(op->a);
+    if (a->getType()->isPointerTy() && !op->type.isBool()) {
+      value = builder.CreatePtrToInt(a, registerType(op->type));
+    }
+    else {
+      value = cast(a, op->a.type(), op->type);
+    }
+  }
+
+  void visit(const Call* op) {
+    llvm::Type* int32 = builder.getInt32Ty();
+    vector<llvm::Value*> args;
+    if (runtimeHelpers.count(op->func)) {
+      // int taco_binarySearch*(int *array, int start, int end, int target)
+      taco_iassert(op->args.size() == 4);
+      args.push_back(builder.CreateBitCast(codegen(op->args[0]),
+                                           int32->getPointerTo()));
+      for (size_t i = 1; i < op->args.size(); ++i) {
+        args.push_back(cast(codegen(op->args[i]), op->args[i].type(), Int32));
+      }
+      value = builder.CreateCall(getRuntimeFunction(op->func, int32,
+          {int32->getPointerTo(), int32, int32, int32}), args);
+      value = cast(value, Int32, op->type);
+      return;
+    }
+
+    // the libm and libc functions kernels call take arguments of their
+    // result type (e.g. fabs, pow, abs, labs)
+    llvm::Type* type = registerType(op->type);
+    for (auto& arg : op->args) {
+      args.push_back(cast(codegen(arg), arg.type(), op->type));
+    }
+    vector<llvm::Type*> params(args.size(), type);
+    value = builder.CreateCall(getRuntimeFunction(op->func, type, params),
+                               args);
+  }
+
+  void visit(const IfThenElse* op) {
+    llvm::Value* cond = toBool(op->cond);
+    llvm::BasicBlock* then = newBlock("then");
+    llvm::BasicBlock* otherwise = op->otherwise.defined()
+                                  ? newBlock("else") : nullptr;
+    llvm::BasicBlock* done = newBlock("endif");
+    builder.CreateCondBr(cond, then, otherwise ? otherwise : done);
+
+    builder.SetInsertPoint(then);
+    codegen(op->then);
+    builder.CreateBr(done);
+
+    if (otherwise) {
+      builder.SetInsertPoint(otherwise);
+      codegen(op->otherwise);
+      builder.CreateBr(done);
+    }
+    builder.SetInsertPoint(done);
+  }
+
+  void visit(const Case* op) {
+    llvm::BasicBlock* done = newBlock("endcase");
+    for (size_t i = 0; i < op->clauses.size(); ++i) {
+      auto& clause = op->clauses[i];
+      if (i == op->clauses.size() - 1 && op->alwaysMatch && i != 0) {
+        codegen(clause.second);
+        builder.CreateBr(done);
+        builder.SetInsertPoint(done);
+        return;
+      }
+      llvm::Value* cond = toBool(clause.first);
+      llvm::BasicBlock* then = newBlock("case");
+      llvm::BasicBlock* next = newBlock("nextcase");
+      builder.CreateCondBr(cond, then, next);
+      builder.SetInsertPoint(then);
+      codegen(clause.second);
+      builder.CreateBr(done);
+      builder.SetInsertPoint(next);
+    }
+    builder.CreateBr(done);
+    builder.SetInsertPoint(done);
+  }
+
+  void visit(const Switch* op) {
+    llvm::Value* control = codegen(op->controlExpr);
+    llvm::BasicBlock* done = newBlock("endswitch");
+    llvm::SwitchInst* switchInst = builder.CreateSwitch(control, done,
+                                                        op->cases.size());
+    for (auto& switchCase : op->cases) {
+      llvm::BasicBlock* block = newBlock("switchcase");
+      llvm::Value* caseValue = cast(codegen(switchCase.first),
+                                    switchCase.first.type(),
+                                    op->controlExpr.type());
+      taco_iassert(llvm::isa<llvm::ConstantInt>(caseValue))
+          << "Switch cases must be integer literals";
+      switchInst->addCase(llvm::cast<llvm::ConstantInt>(caseValue), block);
+      builder.SetInsertPoint(block);
+      codegen(switchCase.second);
+      builder.CreateBr(done);
+    }
+    builder.SetInsertPoint(done);
+  }
+
+  void visit(const Load* op) {
+    llvm::Type* type = llvmType(op->type);
+    llvm::Value* addr = builder.CreateInBoundsGEP(type, codegen(op->arr),
+                                                  index(op->loc));
+    value = load({addr, type, op->type, false});
+  }
+
+  void visit(const Malloc* op) {
+    value = builder.CreateCall(getRuntimeFunction("malloc",
+        builder.getInt8PtrTy(), {builder.getInt64Ty()}),
+        {cast(codegen(op->size), op->size.type(), UInt64)});
+  }
+
+  void visit(const Sizeof* op) {
+    value = builder.getInt64(op->sizeofType.getDataType().getNumBytes());
+  }
+
+  void visit(const Store* op) {
+    llvm::Type* type = llvmType(op->arr.type());
+    llvm::Value* addr = builder.CreateInBoundsGEP(type, codegen(op->arr),
+                                                  index(op->loc));
+    store({addr, type, op->arr.type(), false}, codegen(op->data),
+          op->data.type());
+  }
+
+  void visit(const For* op) {
+    Slot var = getLValue(op->var);
+    store(var, codegen(op->start), op->start.type());
+
+    llvm::BasicBlock* cond = newBlock("for_cond");
+    llvm::BasicBlock* body = newBlock("for_body");
+    llvm::BasicBlock* increment = newBlock("for_inc");
+    llvm::BasicBlock* done = newBlock("for_end");
+    builder.CreateBr(cond);
+
+    builder.SetInsertPoint(cond);
+    builder.CreateCondBr(compare(op->var, op->end, llvm::CmpInst::ICMP_SLT,
+                                 llvm::CmpInst::ICMP_ULT,
+                                 llvm::CmpInst::FCMP_OLT), body, done);
+
+    builder.SetInsertPoint(body);
+    continueTargets.push_back(increment);
+    codegen(op->contents);
+    continueTargets.pop_back();
+    builder.CreateBr(increment);
+
+    builder.SetInsertPoint(increment);
+    auto values = operands(op->var, op->increment, op->var.type());
+    store(var, op->var.type().isFloat()
+               ? builder.CreateFAdd(values.first, values.second)
+               : builder.CreateAdd(values.first, values.second),
+          op->var.type());
+    builder.CreateBr(cond);
+
+    builder.SetInsertPoint(done);
+  }
+
+  void visit(const While* op) {
+    llvm::BasicBlock* cond = newBlock("while_cond");
+    llvm::BasicBlock* body = newBlock("while_body");
+    llvm::BasicBlock* done = newBlock("while_end");
+    builder.CreateBr(cond);
+
+    builder.SetInsertPoint(cond);
+    builder.CreateCondBr(toBool(op->cond), body, done);
+
+    builder.SetInsertPoint(body);
+    continueTargets.push_back(cond);
+    codegen(op->contents);
+    continueTargets.pop_back();
+    builder.CreateBr(cond);
+
+    builder.SetInsertPoint(done);
+  }
+
+  void visit(const Block* op) {
+    for (auto& stmt : op->contents) {
+      codegen(stmt);
+    }
+  }
+
+  void visit(const Scope* op) {
+    codegen(op->scopedStmt);
+  }
+
+  void visit(const Function* op) {
+    taco_ierror << "Nested functions are not supported";
+  }
+
+  void visit(const VarDecl* op) {
+    store(getLValue(op->var), codegen(op->rhs), op->rhs.type());
+  }
+
+  void visit(const Assign* op) {
+    Slot lhs = getLValue(op->lhs);
+    store(lhs, codegen(op->rhs), op->rhs.type());
+  }
+
+  void visit(const Yield* op) {
+    taco_ierror << "LLVM codegen does not support coroutines";
+  }
+
+  void visit(const Allocate* op) {
+    Slot slot = getLValue(op->var);
+    llvm::Type* voidptr = builder.getInt8PtrTy();
+    llvm::Type* int64 = builder.getInt64Ty();
+    llvm::Value* size = builder.CreateMul(
+        builder.getInt64(op->var.type().getNumBytes()),
+        index(op->num_elements));
+    llvm::Value* memory;
+    if (op->is_realloc) {
+      memory = builder.CreateCall(
+          getRuntimeFunction("realloc", voidptr, {voidptr, int64}),
+          {builder.CreateBitCast(load(slot), voidptr), size});
+    }
+    else {
+      memory = builder.CreateCall(
+          getRuntimeFunction("malloc", voidptr, {int64}), {size});
+    }
+    store(slot, memory, op->var.type());
+  }
+
+  void visit(const Free* op) {
+    llvm::Type* voidptr = builder.getInt8PtrTy();
+    builder.CreateCall(getRuntimeFunction("free", builder.getVoidTy(),
+                                          {voidptr}),
+                       {builder.CreateBitCast(codegen(op->var), voidptr)});
+  }
+
+  void visit(const Comment*) {
+  }
+
+  void visit(const BlankLine*) {
+  }
+
+  void visit(const Break*) {
+    // The C backend prints Break as `continue`
+    taco_iassert(!continueTargets.empty()) << "Break outside of a loop";
+    branchTo(continueTargets.back());
+  }
+
+  void visit(const Print* op) {
+    vector<llvm::Value*> args = {builder.CreateGlobalStringPtr(unescape(op->fmt))};
+    for (auto& param : op->params) {
+      llvm::Value* arg = codegen(param);
+      // default argument promotions
+      if (arg->getType()->isFloatTy()) {
+        arg = builder.CreateFPExt(arg, builder.getDoubleTy());
+      }
+      else if (arg->getType()->isIntegerTy() &&
+               arg->getType()->getIntegerBitWidth() < 32) {
+        arg = cast(arg, param.type(), Int32);
+      }
+      args.push_back(arg);
+    }
+    builder.CreateCall(getRuntimeFunction("printf", builder.getInt32Ty(),
+                                          {builder.getInt8PtrTy()}, true),
+                       args);
+  }
+
+  void visit(const GetProperty* op) {
+    value = load(getProperty(op));
+  }
+};
+
+void initializeLLVM() {
+  static once_flag initialized;
+  call_once(initialized, []() {
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+  });
+}
+
+void optimize(llvm::Module& module, llvm::TargetMachine* targetMachine) {
+  llvm::LoopAnalysisManager loopAnalyses;
+  llvm::FunctionAnalysisManager functionAnalyses;
+  llvm::CGSCCAnalysisManager cgsccAnalyses;
+  llvm::ModuleAnalysisManager moduleAnalyses;
+
+  // C compilers do not interleave (unroll) vectorized reductions at -O3
+  llvm::PipelineTuningOptions tuning;
+  tuning.LoopInterleaving = false;
+  llvm::PassBuilder passBuilder(targetMachine, tuning);
+  passBuilder.registerModuleAnalyses(moduleAnalyses);
+  passBuilder.registerCGSCCAnalyses(cgsccAnalyses);
+  passBuilder.registerFunctionAnalyses(functionAnalyses);
+  passBuilder.registerLoopAnalyses(loopAnalyses);
+  passBuilder.crossRegisterProxies(loopAnalyses, functionAnalyses,
+                                   cgsccAnalyses, moduleAnalyses);
+
+  llvm::ModulePassManager passes =
+      passBuilder.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+  passes.run(module, moduleAnalyses);
+}
+
+} // anonymous namespace
+
+struct CodeGen_LLVM::Content {
+  std::unique_ptr<llvm::orc::LLJIT> jit;
+};
+
+CodeGen_LLVM::CodeGen_LLVM() : content(new Content) {
+}
+
+CodeGen_LLVM::~CodeGen_LLVM() {
+}
+
+bool CodeGen_LLVM::supports(const vector<Stmt>& funcs) {
+  CheckSupported checker;
+  for (auto& func : funcs) {
+    func.accept(&checker);
+  }
+  return checker.supported;
+}
+
+void CodeGen_LLVM::compile(const vector<Stmt>& funcs) {
+  initializeLLVM();
+
+  // Target the generic CPU of the host triple, as `cc -O3` does without
+  // -march, so that (fast-math) floating point results match the C backend.
+  llvm::orc::JITTargetMachineBuilder targetMachineBuilder(
+      llvm::Triple(llvm::sys::getProcessTriple()));
+  targetMachineBuilder.setCodeGenOptLevel(llvm::CodeGenOpt::Aggressive);
+  auto targetMachine = check(targetMachineBuilder.createTargetMachine());
+
+  auto context = std::make_unique<llvm::LLVMContext>();
+  auto module = std::make_unique<llvm::Module>("taco", *context);
+  module->setDataLayout(targetMachine->createDataLayout());
+  module->setTargetTriple(targetMachine->getTargetTriple().str());
+
+  FunctionGen codegen(module.get());
+  for (auto& func : funcs) {
+    codegen.compile(func.as<Function>());
+    codegen.compileShim(func.as<Function>());
+  }
+
+  string errors;
+  llvm::raw_string_ostream errorStream(errors);
+  taco_iassert(!llvm::verifyModule(*module, &errorStream))
+      << "LLVM codegen produced an invalid module:\n" << errorStream.str();
+
+  optimize(*module, targetMachine.get());
+
+  content->jit = check(llvm::orc::LLJITBuilder()
+      .setJITTargetMachineBuilder(std::move(targetMachineBuilder))
+      .create());
+  llvm::orc::JITDylib& library = content->jit->getMainJITDylib();
+  library.addGenerator(
+      check(llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(
+          content->jit->getDataLayout().getGlobalPrefix())));
+  llvm::orc::SymbolMap helpers;
+  for (auto& helper : runtimeHelpers) {
+    helpers[content->jit->mangleAndIntern(helper.first)] =
+        llvm::JITEvaluatedSymbol(llvm::pointerToJITTargetAddress(helper.second),
+                                 llvm::JITSymbolFlags::Exported);
+  }
+  check(library.define(llvm::orc::absoluteSymbols(std::move(helpers))));
+  check(content->jit->addIRModule(
+      llvm::orc::ThreadSafeModule(std::move(module), std::move(context))));
+
+  // materialize the code now, rather than on the first call
+  for (auto& func : funcs) {
+    taco_iassert(getFuncPtr("_shim_" + func.as<Function>()->name));
+  }
+}
+
+void* CodeGen_LLVM::getFuncPtr(string name) {
+  if (!content->jit) {
+    return nullptr;
+  }
+  auto symbol = content->jit->lookup(name);
+  if (!symbol) {
+    llvm::consumeError(symbol.takeError());
+    return nullptr;
+  }
+  return llvm::jitTargetAddressToPointer<void*>(symbol->getAddress());
+}
+
+#else
+
+struct CodeGen_LLVM::Content {
+};
+
+CodeGen_LLVM::CodeGen_LLVM() : content(new Content) {
+}
+
+CodeGen_LLVM::~CodeGen_LLVM() {
+}
+
+bool CodeGen_LLVM::supports(const vector<Stmt>& funcs) {
+  return false;
+}
+
+void CodeGen_LLVM::compile(const vector<Stmt>& funcs) {
+  taco_ierror << "taco was built without LLVM support";
+}
+
+void* CodeGen_LLVM::getFuncPtr(string name) {
+  return nullptr;
+}
+
+#endif
+
+} // namespace ir
+} // namespace taco
@@ -0,0 +1,41 @@
+#ifndef TACO_BACKEND_LLVM_H
+#define TACO_BACKEND_LLVM_H
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "taco/ir/ir.h"
+#include "taco/util/uncopyable.h"
+
+namespace taco {
+namespace ir {
+
+/// Generates LLVM IR for lowered functions and compiles it to native code
+/// in-process with the LLVM ORC JIT, so kernels run without writing source
+/// files or invoking an external C compiler.  The generated code follows the
+/// semantics of the C99 code CodeGen_C emits for the same functions,
+/// including the `_shim_` wrappers that unpack a parameter pack.
+class CodeGen_LLVM : util::Uncopyable {
+public:
+  CodeGen_LLVM();
+  ~CodeGen_LLVM();
+
+  /// Returns true if this backend can compile every function.  Coroutines,
+  /// complex-valued code, GPU code and (when built with OpenMP) parallel loops
+  /// are left to the C backend.
+  static bool supports(const std::vector<Stmt>& funcs);
+
+  /// Compile the functions and their shims to native code.
+  void compile(const std::vector<Stmt>& funcs);
+
+  /// Get a pointer to a compiled function, or nullptr if there is none.
+  void* getFuncPtr(std::string name);
+
+private:
+  struct Content;
+  std::unique_ptr<Content> content;
+};
+
+} // namespace ir
+} // namespace taco
+#endif
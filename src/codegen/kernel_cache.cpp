@@ -0,0 +1,200 @@
+#include "taco/codegen/kernel_cache.h"
+
+#include <mutex>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <dirent.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
+
+#include "taco/error.h"
+#include "taco/util/env.h"
+
+using namespace std;
+
+namespace taco {
+namespace ir {
+
+static std::mutex kernelCacheMutex;
+static KernelCacheStats kernelCacheStats;
+
+static const size_t defaultKernelCacheMaxSize = size_t(1) << 30;
+
+static void makeDirectories(const string& path) {
+  for (size_t pos = path.find('/', 1); pos != string::npos;
+       pos = path.find('/', pos + 1)) {
+    string prefix = path.substr(0, pos);
+    if (mkdir(prefix.c_str(), 0755) != 0) {
+      taco_uassert(errno == EEXIST) <<
+          "Unable to create kernel cache directory " << prefix;
+    }
+  }
+}
+
+bool isKernelCacheEnabled() {
+  return getKernelCacheDir() != "";
+}
+
+string getKernelCacheDir() {
+  string dir = util::getFromEnv("TACO_KERNEL_CACHE_DIR", "");
+  if (dir == "") {
+    return dir;
+  }
+  if (dir.back() != '/') {
+    dir += '/';
+  }
+  taco_uassert(dir.front() == '/') <<
+      "The TACO_KERNEL_CACHE_DIR environment variable must be an absolute path";
+  return dir;
+}
+
+size_t getKernelCacheMaxSize() {
+  string size = util::getFromEnv("TACO_KERNEL_CACHE_MAX_SIZE", "");
+  if (size == "") {
+    return defaultKernelCacheMaxSize;
+  }
+  char* end;
+  size_t bytes = strtoull(size.c_str(), &end, 10);
+  switch (*end) {
+    case 'k': case 'K': bytes <<= 10; break;
+    case 'm': case 'M': bytes <<= 20; break;
+    case 'g': case 'G': bytes <<= 30; break;
+    case '\0': break;
+    default:
+      taco_uerror << "Invalid TACO_KERNEL_CACHE_MAX_SIZE: " << size;
+  }
+  return bytes;
+}
+
+KernelCacheStats getKernelCacheStats() {
+  std::lock_guard<std::mutex> lock(kernelCacheMutex);
+  return kernelCacheStats;
+}
+
+void resetKernelCacheStats() {
+  std::lock_guard<std::mutex> lock(kernelCacheMutex);
+  kernelCacheStats = KernelCacheStats();
+}
+
+string getKernelCacheKey(const string& source, const string& compileCommand) {
+  // 64-bit FNV-1a, which is stable across processes and platforms
+  uint64_t hash = 14695981039346656037ull;
+  auto combine = [&hash](const string& str) {
+    for (unsigned char c : str) {
+      hash ^= c;
+      hash *= 1099511628211ull;
+    }
+    hash ^= 0xff;
+    hash *= 1099511628211ull;
+  };
+  combine(source);
+  combine(compileCommand);
+
+  stringstream key;
+  key << "taco_" << hex << setw(16) << setfill('0') << hash;
+  return key.str();
+}
+
+string lookupKernelCache(const string& key) {
+  string path = getKernelCacheDir() + key + ".so";
+  std::lock_guard<std::mutex> lock(kernelCacheMutex);
+  if (access(path.c_str(), R_OK) != 0) {
+    kernelCacheStats.misses++;
+    return "";
+  }
+  // Mark the library as recently used for the LRU eviction policy
+  utime(path.c_str(), nullptr);
+  kernelCacheStats.hits++;
+  return path;
+}
+
+namespace {
+struct CacheEntry {
+  string path;
+  size_t size;
+  time_t lastUsed;
+};
+}
+
+static void evict(const string& dir, const string& keep) {
+  DIR* handle = opendir(dir.c_str());
+  if (!handle) {
+    return;
+  }
+  vector<CacheEntry> entries;
+  size_t totalSize = 0;
+  while (struct dirent* entry = readdir(handle)) {
+    string name = entry->d_name;
+    if (name.size() < 3 || name.compare(name.size() - 3, 3, ".so") != 0) {
+      continue;
+    }
+    struct stat info;
+    string path = dir + name;
+    if (stat(path.c_str(), &info) != 0) {
+      continue;
+    }
+    totalSize += info.st_size;
+    entries.push_back({path, (size_t)info.st_size, info.st_mtime});
+  }
+  closedir(handle);
+
+  const size_t maxSize = getKernelCacheMaxSize();
+  if (totalSize <= maxSize) {
+    return;
+  }
+  sort(entries.begin(), entries.end(),
+       [](const CacheEntry& a, const CacheEntry& b) {
+         return a.lastUsed < b.lastUsed;
+       });
+  for (auto& entry : entries) {
+    if (totalSize <= maxSize) {
+      break;
+    }
+    if (entry.path == keep || unlink(entry.path.c_str()) != 0) {
+      continue;
+    }
+    totalSize -= entry.size;
+    kernelCacheStats.evictions++;
+    kernelCacheStats.evictedBytes += entry.size;
+  }
+}
+
+string storeKernelCache(const string& key, const string& libpath) {
+  string dir = getKernelCacheDir();
+  makeDirectories(dir);
+
+  // Write to a temporary file and rename it so that concurrent processes
+  // never observe a partially written library.
+  string tmppath = dir + key + ".XXXXXX";
+  vector<char> tmpname(tmppath.begin(), tmppath.end());
+  tmpname.push_back('\0');
+  int fd = mkstemp(tmpname.data());
+  taco_uassert(fd != -1) << "Unable to write to kernel cache directory " << dir;
+  close(fd);
+  tmppath = tmpname.data();
+  {
+    ifstream src(libpath, ios::binary);
+    ofstream dst(tmppath, ios::binary | ios::trunc);
+    dst << src.rdbuf();
+  }
+  chmod(tmppath.c_str(), 0755);
+
+  string path = dir + key + ".so";
+  std::lock_guard<std::mutex> lock(kernelCacheMutex);
+  if (rename(tmppath.c_str(), path.c_str()) != 0) {
+    unlink(tmppath.c_str());
+    return libpath;
+  }
+  kernelCacheStats.stores++;
+  evict(dir, path);
+  return path;
+}
+
+}}
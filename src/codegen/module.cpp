@@ -12,9 +12,12 @@
 #include "taco/error.h"
 #include "taco/util/strings.h"
 #include "taco/util/env.h"
+#include "taco/codegen/kernel_cache.h"
 #include "codegen/codegen_c.h"
 #include "codegen/codegen_cuda.h"
+#include "codegen/codegen_llvm.h"
 #include "taco/cuda.h"
+#include "taco/llvm.h"
 
 using namespace std;
 
@@ -45,30 +48,35 @@ void Module::addFunction(Stmt func) {
   funcs.push_back(func);
 }
 
-void Module::compileToSource(string path, string prefix) {
-  if (!moduleFromUserSource) {
-  
-    // create a codegen instance and add all the funcs
-    bool didGenRuntime = false;
-    
-    header.str("");
-    header.clear();
-    source.str("");
-    source.clear();
-
-    taco_tassert(target.arch == Target::C99) <<
-        "Only C99 codegen supported currently";
-    std::shared_ptr<CodeGen> sourcegen =
-        CodeGen::init_default(source, CodeGen::ImplementationGen);
-    std::shared_ptr<CodeGen> headergen =
-            CodeGen::init_default(header, CodeGen::HeaderGen);
-
-    for (auto func: funcs) {
-      sourcegen->compile(func, !didGenRuntime);
-      headergen->compile(func, !didGenRuntime);
-      didGenRuntime = true;
-    }
+void Module::generateSource() {
+  if (moduleFromUserSource) {
+    return;
+  }
+
+  // create a codegen instance and add all the funcs
+  bool didGenRuntime = false;
+
+  header.str("");
+  header.clear();
+  source.str("");
+  source.clear();
+
+  taco_tassert(target.arch == Target::C99) <<
+      "Only C99 codegen supported currently";
+  std::shared_ptr<CodeGen> sourcegen =
+      CodeGen::init_default(source, CodeGen::ImplementationGen);
+  std::shared_ptr<CodeGen> headergen =
+          CodeGen::init_default(header, CodeGen::HeaderGen);
+
+  for (auto func: funcs) {
+    sourcegen->compile(func, !didGenRuntime);
+    headergen->compile(func, !didGenRuntime);
+    didGenRuntime = true;
   }
+}
+
+void Module::compileToSource(string path, string prefix) {
+  generateSource();
 
   ofstream source_file;
   string file_ending = should_use_CUDA_codegen() ? ".cu" : ".c";
@@ -88,7 +96,7 @@ void Module::compileToStaticLibrary(string path, string prefix) {
   
 namespace {
 
-void writeShims(vector<Stmt> funcs, string path, string prefix) {
+string writeShims(vector<Stmt> funcs, string path, string prefix) {
   stringstream shims;
   for (auto func: funcs) {
     if (should_use_CUDA_codegen()) {
@@ -109,11 +117,23 @@ void writeShims(vector<Stmt> funcs, string path, string prefix) {
   shims_file << "#include \"" << path << prefix << ".h\"\n";
   shims_file << shims.str();
   shims_file.close();
+  return shims.str();
 }
 
 } // anonymous namespace
 
 string Module::compile() {
+  // compile in-process, without writing files or forking a compiler, when
+  // the LLVM backend supports every function
+  llvmCodeGen = nullptr;
+  if (should_use_LLVM_codegen() && !should_use_CUDA_codegen() &&
+      !moduleFromUserSource && CodeGen_LLVM::supports(funcs)) {
+    generateSource();
+    llvmCodeGen = make_shared<CodeGen_LLVM>();
+    llvmCodeGen->compile(funcs);
+    return "";
+  }
+
   string prefix = tmpdir+libname;
   string fullpath = prefix + ".so";
   
@@ -131,7 +151,7 @@ string Module::compile() {
   else {
     cc = util::getFromEnv(target.compiler_env, target.compiler);
     cflags = util::getFromEnv("TACO_CFLAGS",
-    "-O3 -ffast-math -std=c99") + " -shared -fPIC";
+    "-O3 -ffast-math -std=c11") + " -shared -fPIC";
 #if USE_OPENMP
     cflags += " -fopenmp";
 #endif
@@ -147,13 +167,34 @@ string Module::compile() {
   compileToSource(tmpdir, libname);
   
   // write out the shims
-  writeShims(funcs, tmpdir, libname);
+  string shims = writeShims(funcs, tmpdir, libname);
+
+  // reuse a library that an earlier process compiled from identical source
+  string cacheKey;
+  if (isKernelCacheEnabled()) {
+    cacheKey = getKernelCacheKey(header.str() + source.str() + shims,
+                                 cc + " " + cflags);
+    string cachedpath = lookupKernelCache(cacheKey);
+    if (cachedpath != "") {
+      if (lib_handle) {
+        dlclose(lib_handle);
+      }
+      lib_handle = dlopen(cachedpath.data(), RTLD_NOW | RTLD_LOCAL);
+      if (lib_handle) {
+        return cachedpath;
+      }
+    }
+  }
   
   // now compile it
   int err = system(cmd.data());
   taco_uassert(err == 0) << "Compilation command failed:\n" << cmd
     << "\nreturned " << err;
 
+  if (cacheKey != "") {
+    storeKernelCache(cacheKey, fullpath);
+  }
+
   // use dlsym() to open the compiled library
   if (lib_handle) {
     dlclose(lib_handle);
@@ -174,6 +215,9 @@ string Module::getSource() {
 }
 
 void* Module::getFuncPtr(std::string name) {
+  if (llvmCodeGen) {
+    return llvmCodeGen->getFuncPtr(name);
+  }
   return dlsym(lib_handle, name.data());
 }
 
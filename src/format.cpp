@@ -9,6 +9,10 @@
 #include "taco/lower/mode_format_dense.h"
 #include "taco/lower/mode_format_compressed.h"
 #include "taco/lower/mode_format_singleton.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_bitmap.h"
+#include "taco/lower/mode_format_rle.h"
+#include "taco/lower/mode_format_sell.h"
 
 #include "taco/error.h"
 #include "taco/util/strings.h"
@@ -95,10 +99,79 @@ Datatype Format::getCoordinateTypeIdx(size_t level) const {
   return levelArrayTypes[level][1];
 }
 
+Datatype Format::getPositionType() const {
+  Datatype posType = Int32;
+  for (int i = 0; i < getOrder(); ++i) {
+    if (getModeFormats()[i].getName() != Dense.getName()) {
+      posType = max_type(posType, getCoordinateTypePos(i));
+    }
+  }
+  return posType;
+}
+
 void Format::setLevelArrayTypes(std::vector<std::vector<Datatype>> levelArrayTypes) {
   this->levelArrayTypes = levelArrayTypes;
 }
 
+void Format::setCoordinateTypes(Datatype posType, Datatype idxType) {
+  taco_uassert(posType == Int32 || posType == Int64) <<
+      "Positions must be Int32 or Int64, not " << posType;
+  taco_uassert(idxType == UInt8 || idxType == UInt16 ||
+               idxType == Int32 || idxType == Int64) <<
+      "Coordinates must be UInt8, UInt16, Int32 or Int64, not " << idxType;
+  levelArrayTypes.clear();
+  for (auto& modeFormat : getModeFormats()) {
+    if (modeFormat.getName() == Dense.getName()) {
+      levelArrayTypes.push_back({Int32});
+    } else if (modeFormat.getName() == Hashed.getName()) {
+      // Hash tables mark empty slots with coordinate -1
+      levelArrayTypes.push_back({Int32, Int32});
+    } else if (modeFormat.getName() == Bitmap.getName()) {
+      levelArrayTypes.push_back({Int32, UInt64});
+    } else if (modeFormat.getName() == RLE.getName()) {
+      // Runs are searched with int32 coordinates
+      levelArrayTypes.push_back({Int32, Int32});
+    } else if (modeFormat.getName() == Sell.getName()) {
+      // SELL padding has coordinate -1
+      levelArrayTypes.push_back({Int32, Int32, Int32});
+    } else {
+      levelArrayTypes.push_back({posType, idxType});
+    }
+  }
+}
+
+void Format::narrowCoordinateTypes(const std::vector<int>& dimensions) {
+  taco_uassert(dimensions.size() == (size_t)getOrder()) <<
+      "Expected " << getOrder() << " dimensions but got " << dimensions.size();
+  std::vector<std::vector<Datatype>> arrayTypes;
+  for (int i = 0; i < getOrder(); ++i) {
+    if (getModeFormats()[i].getName() == Dense.getName()) {
+      arrayTypes.push_back({Int32});
+      continue;
+    }
+    if (getModeFormats()[i].getName() == Hashed.getName()) {
+      arrayTypes.push_back({Int32, Int32});
+      continue;
+    }
+    if (getModeFormats()[i].getName() == Bitmap.getName()) {
+      arrayTypes.push_back({Int32, UInt64});
+      continue;
+    }
+    if (getModeFormats()[i].getName() == RLE.getName()) {
+      arrayTypes.push_back({Int32, Int32});
+      continue;
+    }
+    if (getModeFormats()[i].getName() == Sell.getName()) {
+      arrayTypes.push_back({Int32, Int32, Int32});
+      continue;
+    }
+    const int dimension = dimensions[getModeOrdering()[i]];
+    Datatype idxType = (dimension <= (1 << 8))  ? UInt8  :
+                       (dimension <= (1 << 16)) ? UInt16 : Int32;
+    arrayTypes.push_back({getCoordinateTypePos(i), idxType});
+  }
+  levelArrayTypes = arrayTypes;
+}
 
 bool operator==(const Format& a, const Format& b){
   const auto aModeTypePacks = a.getModeFormatPacks();
@@ -120,6 +193,12 @@ bool operator==(const Format& a, const Format& b){
       return false;
     }
   } 
+  for (int i = 0; i < a.getOrder(); ++i) {
+    if (a.getCoordinateTypePos(i) != b.getCoordinateTypePos(i) ||
+        a.getCoordinateTypeIdx(i) != b.getCoordinateTypeIdx(i)) {
+      return false;
+    }
+  }
   return true;
 }
 
@@ -262,6 +341,16 @@ bool ModeFormat::hasAppend() const {
   return impl->hasAppend;
 }
 
+bool ModeFormat::hasRunIter() const {
+  taco_iassert(defined());
+  return impl->hasRunIter;
+}
+
+bool ModeFormat::hasWordIter() const {
+  taco_iassert(defined());
+  return impl->hasWordIter;
+}
+
 bool ModeFormat::defined() const {
   return impl != nullptr;
 }
@@ -332,27 +421,57 @@ ModeFormat ModeFormat::Dense(std::make_shared<DenseModeFormat>());
 ModeFormat ModeFormat::Compressed(std::make_shared<CompressedModeFormat>());
 ModeFormat ModeFormat::Sparse = ModeFormat::Compressed;
 ModeFormat ModeFormat::Singleton(std::make_shared<SingletonModeFormat>());
+ModeFormat ModeFormat::Hashed(std::make_shared<HashedModeFormat>());
+ModeFormat ModeFormat::Bitmap(std::make_shared<BitmapModeFormat>());
+ModeFormat ModeFormat::RLE(std::make_shared<RunLengthModeFormat>());
+ModeFormat ModeFormat::Sell(std::make_shared<SellModeFormat>());
 
 ModeFormat ModeFormat::dense = ModeFormat::Dense;
 ModeFormat ModeFormat::compressed = ModeFormat::Compressed;
 ModeFormat ModeFormat::sparse = ModeFormat::Compressed;
 ModeFormat ModeFormat::singleton = ModeFormat::Singleton;
+ModeFormat ModeFormat::hashed = ModeFormat::Hashed;
+ModeFormat ModeFormat::bitmap = ModeFormat::Bitmap;
+ModeFormat ModeFormat::rle = ModeFormat::RLE;
+ModeFormat ModeFormat::sell = ModeFormat::Sell;
 
 const ModeFormat Dense = ModeFormat::Dense;
 const ModeFormat Compressed = ModeFormat::Compressed;
 const ModeFormat Sparse = ModeFormat::Compressed;
 const ModeFormat Singleton = ModeFormat::Singleton;
+const ModeFormat Hashed = ModeFormat::Hashed;
+const ModeFormat Bitmap = ModeFormat::Bitmap;
+const ModeFormat RLE = ModeFormat::RLE;
+const ModeFormat Sell = ModeFormat::Sell;
 
 const ModeFormat dense = ModeFormat::Dense;
 const ModeFormat compressed = ModeFormat::Compressed;
 const ModeFormat sparse = ModeFormat::Compressed;
 const ModeFormat singleton = ModeFormat::Singleton;
+const ModeFormat hashed = ModeFormat::Hashed;
+const ModeFormat bitmap = ModeFormat::Bitmap;
+const ModeFormat rle = ModeFormat::RLE;
+const ModeFormat sell = ModeFormat::Sell;
 
 const Format CSR({Dense, Sparse}, {0,1});
 const Format CSC({Dense, Sparse}, {1,0});
 const Format DCSR({Sparse, Sparse}, {0,1});
 const Format DCSC({Sparse, Sparse}, {1,0});
 
+const Format BCSR({Dense, Sparse, Dense, Dense}, {0,1,2,3});
+
+const Format SELL(int sliceHeight, int sortingScope) {
+  return Format({Dense, ModeFormat(std::make_shared<SellModeFormat>(
+                            sliceHeight, sortingScope))});
+}
+
+const Format BCSF(int order) {
+  taco_uassert(order > 0) << "Blocked formats need at least one mode";
+  std::vector<ModeFormatPack> modeTypes(order, Sparse);
+  modeTypes.insert(modeTypes.end(), order, Dense);
+  return Format(modeTypes);
+}
+
 const Format COO(int order, bool isUnique, bool isOrdered, bool isAoS, 
                  const std::vector<int>& modeOrdering) {
   taco_uassert(order > 0);
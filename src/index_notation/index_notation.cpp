@@ -6,6 +6,9 @@
 #include <vector>
 #include <utility>
 #include <set>
+#include <map>
+#include <functional>
+#include <typeinfo>
 #include <taco/ir/simplify.h>
 #include "lower/mode_access.h"
 
@@ -434,6 +437,221 @@ bool isomorphic(IndexStmt a, IndexStmt b) {
   return Isomorphic().check(a,b);
 }
 
+struct IsomorphicHash : public IndexNotationVisitorStrict {
+  size_t hash = 0;
+  std::map<TensorVar,size_t> tensorIds;
+  std::map<IndexVar,size_t> indexVarIds;
+
+  void combine(size_t value) {
+    hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  }
+
+  // Nodes are identified by the type of the node class
+  template <class T>
+  void combineNode(const T*) {
+    combine(typeid(T).hash_code());
+  }
+
+  void combine(const Type& type) {
+    combine(type.getDataType().getKind());
+    combine(type.getOrder());
+    for (auto& dimension : type.getShape()) {
+      combine(dimension.isFixed() ? dimension.getSize() + 1 : 0);
+    }
+  }
+
+  void combine(const Format& format) {
+    for (auto& modeFormat : format.getModeFormats()) {
+      combine(std::hash<std::string>()(modeFormat.getName()));
+      combine(modeFormat.isFull());
+      combine(modeFormat.isOrdered());
+      combine(modeFormat.isUnique());
+      combine(modeFormat.isBranchless());
+      combine(modeFormat.isCompact());
+    }
+    for (int mode : format.getModeOrdering()) {
+      combine(mode);
+    }
+  }
+
+  // Tensor and index variables are identified by the order in which they are
+  // first encountered, which is what makes the hash invariant under renaming.
+  void combine(const TensorVar& tensorVar) {
+    if (!util::contains(tensorIds, tensorVar)) {
+      size_t id = tensorIds.size();
+      tensorIds.insert({tensorVar, id});
+      combine(tensorVar.getType());
+      combine(tensorVar.getFormat());
+    }
+    combine(tensorIds.at(tensorVar));
+  }
+
+  void combine(const IndexVar& indexVar) {
+    if (!util::contains(indexVarIds, indexVar)) {
+      size_t id = indexVarIds.size();
+      indexVarIds.insert({indexVar, id});
+    }
+    combine(indexVarIds.at(indexVar));
+  }
+
+  void combine(IndexExpr expr) {
+    if (!expr.defined()) {
+      combine(0);
+      return;
+    }
+    expr.accept(this);
+  }
+
+  void combine(IndexStmt stmt) {
+    if (!stmt.defined()) {
+      combine(0);
+      return;
+    }
+    stmt.accept(this);
+  }
+
+  using IndexNotationVisitorStrict::visit;
+
+  void visit(const AccessNode* node) {
+    combineNode(node);
+    combine(node->tensorVar);
+    combine(node->indexVars.size());
+    for (auto& indexVar : node->indexVars) {
+      combine(indexVar);
+    }
+  }
+
+  void visit(const LiteralNode* node) {
+    combineNode(node);
+    combine(node->getDataType().getKind());
+    const char* val = static_cast<const char*>(node->val);
+    combine(std::hash<std::string>()(
+        std::string(val, node->getDataType().getNumBytes())));
+  }
+
+  template <class T>
+  void unaryHash(const T* node) {
+    combineNode(node);
+    combine(node->a);
+  }
+
+  void visit(const NegNode* node) {
+    unaryHash(node);
+  }
+
+  void visit(const SqrtNode* node) {
+    unaryHash(node);
+  }
+
+  template <class T>
+  void binaryHash(const T* node) {
+    combineNode(node);
+    combine(node->a);
+    combine(node->b);
+  }
+
+  void visit(const AddNode* node) {
+    binaryHash(node);
+  }
+
+  void visit(const SubNode* node) {
+    binaryHash(node);
+  }
+
+  void visit(const MulNode* node) {
+    binaryHash(node);
+  }
+
+  void visit(const DivNode* node) {
+    binaryHash(node);
+  }
+
+  void visit(const CastNode* node) {
+    combineNode(node);
+    combine(node->getDataType().getKind());
+    combine(node->a);
+  }
+
+  void visit(const CallIntrinsicNode* node) {
+    combineNode(node);
+    combine(std::hash<std::string>()(node->func->getName()));
+    combine(node->args.size());
+    for (auto& arg : node->args) {
+      combine(arg);
+    }
+  }
+
+  void visit(const ReductionNode* node) {
+    combineNode(node);
+    combine(node->op);
+    combine(node->var);
+    combine(node->a);
+  }
+
+  void visit(const AssignmentNode* node) {
+    combineNode(node);
+    combine(node->lhs);
+    combine(node->rhs);
+    combine(node->op);
+  }
+
+  void visit(const YieldNode* node) {
+    combineNode(node);
+    combine(node->indexVars.size());
+    for (auto& indexVar : node->indexVars) {
+      combine(indexVar);
+    }
+    combine(node->expr);
+  }
+
+  void visit(const ForallNode* node) {
+    combineNode(node);
+    combine(node->indexVar);
+    combine(node->stmt);
+    combine((size_t)node->parallel_unit);
+    combine((size_t)node->output_race_strategy);
+    combine(node->unrollFactor);
+  }
+
+  void visit(const WhereNode* node) {
+    combineNode(node);
+    combine(node->consumer);
+    combine(node->producer);
+  }
+
+  void visit(const SequenceNode* node) {
+    combineNode(node);
+    combine(node->definition);
+    combine(node->mutation);
+  }
+
+  void visit(const MultiNode* node) {
+    combineNode(node);
+    combine(node->stmt1);
+    combine(node->stmt2);
+  }
+
+  void visit(const SuchThatNode* node) {
+    // Predicates are compared by identity by `isomorphic`, so only their
+    // number contributes to the hash.
+    combineNode(node);
+    combine(node->stmt);
+    combine(node->predicate.size());
+  }
+};
+
+size_t isomorphicHash(IndexExpr expr) {
+  IsomorphicHash hasher;
+  hasher.combine(expr);
+  return hasher.hash;
+}
+
+size_t isomorphicHash(IndexStmt stmt) {
+  IsomorphicHash hasher;
+  hasher.combine(stmt);
+  return hasher.hash;
+}
+
 struct Equals : public IndexNotationVisitorStrict {
   bool eq = false;
   IndexExpr bExpr;
@@ -1395,6 +1613,37 @@ IndexStmt IndexStmt::precompute(IndexExpr expr, IndexVar i, IndexVar iw, TensorV
   return transformed;
 }
 
+IndexStmt IndexStmt::precompute(IndexExpr expr, std::vector<IndexVar> i,
+                                std::vector<IndexVar> iw,
+                                TensorVar workspace) const {
+  taco_uassert(!i.empty() && i.size() == iw.size()) <<
+      "Expected the same number of index variables for the consumer and " <<
+      "the producer of the workspace";
+  taco_uassert((int)i.size() == workspace.getOrder()) <<
+      "Expected " << workspace.getOrder() << " index variables for " <<
+      workspace.getName();
+  IndexStmt transformed = *this;
+  string reason;
+  vector<IndexVarRel> rels;
+  for (size_t k = 0; k < i.size(); k++) {
+    if (i[k] != iw[k]) {
+      rels.push_back(IndexVarRel(new PrecomputeRelNode(i[k], iw[k])));
+    }
+  }
+  if (!rels.empty()) {
+    transformed = Transformation(AddSuchThatPredicates(rels)).apply(transformed, &reason);
+    if (!transformed.defined()) {
+      taco_uerror << reason;
+    }
+  }
+
+  transformed = Transformation(Precompute(expr, i, iw, workspace)).apply(transformed, &reason);
+  if (!transformed.defined()) {
+    taco_uerror << reason;
+  }
+  return transformed;
+}
+
 IndexStmt IndexStmt::reorder(taco::IndexVar i, taco::IndexVar j) const {
   string reason;
   IndexStmt transformed = Reorder(i, j).apply(*this, &reason);
@@ -2217,6 +2466,100 @@ IndexStmt makeReductionNotation(IndexStmt stmt) {
   return makeReductionNotation(to<Assignment>(stmt));
 }
 
+/// Computes the reductions nested in the right-hand side of a loop nest into
+/// scalar temporaries under the loops whose index variables they use, and moves
+/// the other loops inside, so that the reductions are not recomputed in every
+/// iteration of those loops (e.g. the sampled products of an SDDMM fused into
+/// an SpMM).  The nest is left alone if this would iterate over the result or a
+/// sparse operand out of order.
+static IndexStmt hoistNestedReductions(IndexStmt nest) {
+  vector<IndexVar> loopVars;
+  IndexStmt stmt = nest;
+  while (isa<Forall>(stmt)) {
+    loopVars.push_back(to<Forall>(stmt).getIndexVar());
+    stmt = to<Forall>(stmt).getStmt();
+  }
+  if (!isa<Assignment>(stmt)) {
+    return nest;
+  }
+  Assignment assignment = to<Assignment>(stmt);
+
+  struct ReplaceReductionsWithTemporaries : IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+
+    vector<pair<TensorVar,Reduction>> temporaries;
+
+    void visit(const ReductionNode* node) {
+      TensorVar t("t" + util::toString(node->var), node->getDataType());
+      temporaries.push_back({t, node});
+      expr = t;
+    }
+  };
+  ReplaceReductionsWithTemporaries replaceReductions;
+  IndexExpr rhs = replaceReductions.rewrite(assignment.getRhs());
+
+  set<IndexVar> usedVars;
+  for (auto& temporary : replaceReductions.temporaries) {
+    for (auto& var : getIndexVars(temporary.second)) {
+      usedVars.insert(var);
+    }
+  }
+  vector<IndexVar> outerVars;
+  vector<IndexVar> innerVars;
+  for (auto& var : loopVars) {
+    if (util::contains(usedVars, var)) {
+      outerVars.push_back(var);
+    }
+    else {
+      innerVars.push_back(var);
+    }
+  }
+  if (replaceReductions.temporaries.empty() || innerVars.empty()) {
+    return nest;
+  }
+
+  // Moving a reduction loop outside of the result's loops accumulates into
+  // the result out of order, and moving a loop inside of the loops of the
+  // modes below it iterates over an operand out of order
+  vector<IndexVar> resultVars = assignment.getLhs().getIndexVars();
+  bool isHoistable = isDense(assignment.getLhs().getTensorVar().getFormat()) ||
+      std::all_of(outerVars.begin(), outerVars.end(), [&](IndexVar var) {
+        return util::contains(resultVars, var);
+      });
+  match(assignment.getRhs(),
+    std::function<void(const AccessNode*)>([&](const AccessNode* op) {
+      if (isDense(op->tensorVar.getFormat())) {
+        return;
+      }
+      bool hasInnerVar = false;
+      for (auto& var : op->indexVars) {
+        hasInnerVar |= util::contains(innerVars, var);
+        if (hasInnerVar && util::contains(outerVars, var)) {
+          isHoistable = false;
+        }
+      }
+    })
+  );
+  if (!isHoistable) {
+    return nest;
+  }
+
+  stmt = Assignment(assignment.getLhs(), rhs, assignment.getOperator());
+  for (auto& var : util::reverse(innerVars)) {
+    stmt = forall(var, stmt);
+  }
+  for (auto& temporary : replaceReductions.temporaries) {
+    Reduction reduction = temporary.second;
+    stmt = where(stmt, forall(reduction.getVar(),
+                              Assignment(temporary.first, reduction.getExpr(),
+                                         reduction.getOp())));
+  }
+  for (auto& var : util::reverse(outerVars)) {
+    stmt = forall(var, stmt);
+  }
+  return stmt;
+}
+
 IndexStmt makeConcreteNotation(IndexStmt stmt) {
   std::string reason;
   taco_iassert(isReductionNotation(stmt, &reason))
@@ -2256,6 +2599,7 @@ IndexStmt makeConcreteNotation(IndexStmt stmt) {
   for (auto& i : util::reverse(freeVars)) {
     stmt = forall(i, stmt);
   }
+  stmt = hoistNestedReductions(stmt);
 
   // Replace other reductions with where and forall statements
   struct ReplaceReductionsWithWheres : IndexNotationRewriter {
@@ -2302,6 +2646,88 @@ IndexStmt makeConcreteNotation(IndexStmt stmt) {
 }
 
 
+Assignment fuse(Assignment consumer, const vector<Assignment>& producers) {
+  consumer = makeReductionNotation(consumer);
+  map<TensorVar,Assignment> producerOf;
+  for (auto& producer : producers) {
+    std::string reason;
+    taco_uassert(isReductionNotation(producer, &reason))
+        << "Cannot fuse " << producer << " since it is not in reduction "
+        << "notation: " << reason;
+    taco_uassert(!producer.getOperator().defined())
+        << "Cannot fuse " << producer << " since it updates its result";
+    vector<IndexVar> lhsVars = producer.getLhs().getIndexVars();
+    taco_uassert(set<IndexVar>(lhsVars.begin(), lhsVars.end()).size() ==
+                 lhsVars.size())
+        << "Cannot fuse " << producer << " since it accesses its result "
+        << "with repeated index variables";
+    producerOf.insert({producer.getLhs().getTensorVar(), producer});
+  }
+  taco_uassert(!util::contains(producerOf, consumer.getLhs().getTensorVar()))
+      << "Cannot fuse the producer of " << consumer.getLhs().getTensorVar()
+      << " into itself";
+
+  struct InlineProducers : IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+
+    InlineProducers(const map<TensorVar,Assignment>& producerOf)
+        : producerOf(producerOf) {}
+
+    const map<TensorVar,Assignment>& producerOf;
+
+    // The producers being inlined and the renaming of their index variables
+    vector<TensorVar> inlined;
+    map<IndexVar,IndexVar> renamed;
+
+    void visit(const AccessNode* op) {
+      vector<IndexVar> indexVars;
+      for (auto& indexVar : op->indexVars) {
+        indexVars.push_back(util::contains(renamed, indexVar)
+                            ? renamed.at(indexVar) : indexVar);
+      }
+
+      if (!util::contains(producerOf, op->tensorVar)) {
+        expr = (indexVars == op->indexVars)
+               ? IndexExpr(op) : new AccessNode(op->tensorVar, indexVars);
+        return;
+      }
+
+      taco_uassert(!util::contains(inlined, op->tensorVar))
+          << "Cannot fuse the producer of " << op->tensorVar
+          << " since it depends on its own result";
+      Assignment producer = producerOf.at(op->tensorVar);
+      vector<IndexVar> lhsVars = producer.getLhs().getIndexVars();
+
+      map<IndexVar,IndexVar> consumerRenamed = renamed;
+      renamed.clear();
+      for (size_t i = 0; i < lhsVars.size(); i++) {
+        renamed.insert({lhsVars[i], indexVars[i]});
+      }
+      inlined.push_back(op->tensorVar);
+      expr = rewrite(producer.getRhs());
+      inlined.pop_back();
+      renamed = consumerRenamed;
+    }
+
+    void visit(const ReductionNode* op) {
+      if (inlined.empty()) {
+        IndexNotationRewriter::visit(op);
+        return;
+      }
+
+      // Reduction variables of producers may clash with consumer variables
+      IndexVar var(util::uniqueName(op->var.getName()));
+      map<IndexVar,IndexVar> outerRenamed = renamed;
+      renamed[op->var] = var;
+      IndexExpr a = rewrite(op->a);
+      renamed = outerRenamed;
+      expr = new ReductionNode(op->op, var, a);
+    }
+  };
+  IndexExpr rhs = InlineProducers(producerOf).rewrite(consumer.getRhs());
+  return Assignment(consumer.getLhs(), rhs, consumer.getOperator());
+}
+
 vector<TensorVar> getResults(IndexStmt stmt) {
   vector<TensorVar> result;
   set<TensorVar> collected;
@@ -2737,11 +3163,69 @@ private:
   }
 
   void visit(const SequenceNode* op) {
-    taco_not_supported_yet;
+    IndexStmt definition = rewrite(op->definition);
+    IndexStmt mutation = rewrite(op->mutation);
+    if (!definition.defined() && !mutation.defined()) {
+      stmt = IndexStmt();
+      return;
+    }
+
+    if (!definition.defined()) {
+      // A zeroed compound definition does nothing, but a zeroed assignment
+      // still sets its result to zero before the mutation updates it.
+      taco_uassert(isa<Assignment>(op->definition))
+          << "Sequences whose definitions are not assignments cannot be "
+          << "zeroed yet";
+      Assignment assignment = to<Assignment>(op->definition);
+      if (assignment.getOperator().defined()) {
+        stmt = mutation;
+      }
+      else if (isa<Assignment>(mutation) &&
+               equals(to<Assignment>(mutation).getLhs(), assignment.getLhs()) &&
+               isa<Add>(to<Assignment>(mutation).getOperator())) {
+        stmt = new AssignmentNode(assignment.getLhs(),
+                                  to<Assignment>(mutation).getRhs(),
+                                  IndexExpr());
+      }
+      else {
+        Datatype type = assignment.getLhs().getDataType();
+        stmt = new SequenceNode(new AssignmentNode(assignment.getLhs(),
+                                                   Literal::zero(type),
+                                                   IndexExpr()),
+                                mutation);
+      }
+    }
+    else if (!mutation.defined()) {
+      stmt = definition;
+    }
+    else if (definition == op->definition && mutation == op->mutation) {
+      stmt = op;
+    }
+    else {
+      stmt = new SequenceNode(definition, mutation);
+    }
+
+    // The result of the sequence is not zero if either statement remains
+    for (auto& result : getResults(op)) {
+      zeroedVars.erase(result);
+    }
   }
 
   void visit(const MultiNode* op) {
-    taco_not_supported_yet;
+    IndexStmt stmt1 = rewrite(op->stmt1);
+    IndexStmt stmt2 = rewrite(op->stmt2);
+    if (!stmt1.defined()) {
+      stmt = stmt2;
+    }
+    else if (!stmt2.defined()) {
+      stmt = stmt1;
+    }
+    else if (stmt1 == op->stmt1 && stmt2 == op->stmt2) {
+      stmt = op;
+    }
+    else {
+      stmt = new MultiNode(stmt1, stmt2);
+    }
   }
 
   void visit(const SuchThatNode* op) {
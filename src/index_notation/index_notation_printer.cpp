@@ -72,6 +72,7 @@ void IndexNotationPrinter::visit(const LiteralNode* op) {
     case Datatype::Complex128:
       os << op->getVal<std::complex<double>>();
       break;
+    case Datatype::Pattern:
     case Datatype::Undefined:
       break;
   }
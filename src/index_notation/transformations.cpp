@@ -130,8 +130,8 @@ std::ostream& operator<<(std::ostream& os, const Reorder& reorder) {
 // class Precompute
 struct Precompute::Content {
   IndexExpr expr;
-  IndexVar i;
-  IndexVar iw;
+  std::vector<IndexVar> i;
+  std::vector<IndexVar> iw;
   TensorVar workspace;
 };
 
@@ -139,7 +139,15 @@ Precompute::Precompute() : content(nullptr) {
 }
 
 Precompute::Precompute(IndexExpr expr, IndexVar i, IndexVar iw,
-                     TensorVar workspace) : content(new Content) {
+                     TensorVar workspace)
+    : Precompute(expr, std::vector<IndexVar>({i}),
+                 std::vector<IndexVar>({iw}), workspace) {
+}
+
+Precompute::Precompute(IndexExpr expr, std::vector<IndexVar> i,
+                       std::vector<IndexVar> iw, TensorVar workspace)
+    : content(new Content) {
+  taco_iassert(!i.empty() && i.size() == iw.size());
   content->expr = expr;
   content->i = i;
   content->iw = iw;
@@ -151,10 +159,18 @@ IndexExpr Precompute::getExpr() const {
 }
 
 IndexVar Precompute::geti() const {
-  return content->i;
+  return content->i.front();
 }
 
 IndexVar Precompute::getiw() const {
+  return content->iw.front();
+}
+
+const std::vector<IndexVar>& Precompute::getIVars() const {
+  return content->i;
+}
+
+const std::vector<IndexVar>& Precompute::getIWVars() const {
   return content->iw;
 }
 
@@ -235,10 +251,19 @@ IndexStmt Precompute::apply(IndexStmt stmt, std::string* reason) const {
         IndexStmt s = foralli.getStmt();
         TensorVar ws = precompute.getWorkspace();
         IndexExpr e = precompute.getExpr();
-        IndexVar iw = precompute.getiw();
+        const vector<IndexVar>& ivars = precompute.getIVars();
+        const vector<IndexVar>& iwvars = precompute.getIWVars();
 
-        IndexStmt consumer = forall(i, replace(s, {{e, ws(i)}}));
-        IndexStmt producer = forall(iw, ws(iw) = replace(e, {{i,iw}}));
+        map<IndexVar,IndexVar> substitutions;
+        for (size_t k = 0; k < ivars.size(); k++) {
+          substitutions.insert({ivars[k], iwvars[k]});
+        }
+
+        IndexStmt consumer = forall(i, replace(s, {{e, ws(ivars)}}));
+        IndexStmt producer = ws(iwvars) = replace(e, substitutions);
+        for (auto iw = iwvars.rbegin(); iw != iwvars.rend(); ++iw) {
+          producer = forall(*iw, producer);
+        }
         Where where(consumer, producer);
 
         stmt = where;
@@ -254,8 +279,14 @@ IndexStmt Precompute::apply(IndexStmt stmt, std::string* reason) const {
 }
 
 void Precompute::print(std::ostream& os) const {
-  os << "precompute(" << getExpr() << ", " << geti() << ", "
-     << getiw() << ", " << getWorkspace() << ")";
+  if (getIVars().size() == 1) {
+    os << "precompute(" << getExpr() << ", " << geti() << ", "
+       << getiw() << ", " << getWorkspace() << ")";
+  }
+  else {
+    os << "precompute(" << getExpr() << ", {" << util::join(getIVars())
+       << "}, {" << util::join(getIWVars()) << "}, " << getWorkspace() << ")";
+  }
 }
 
 bool Precompute::defined() const {
@@ -905,6 +936,30 @@ IndexStmt reorderLoopsTopologically(IndexStmt stmt) {
   return rewriter.rewrite(stmt);
 }
 
+/// Returns true if the forall and the forall nested in it iterate over the
+/// rows and columns of a SELL matrix, which are lowered to loops over its
+/// slices with the rows of a slice innermost.
+static bool iteratesSlices(Forall forall) {
+  if (!isa<Forall>(forall.getStmt())) {
+    return false;
+  }
+  vector<IndexVar> indexVars = {forall.getIndexVar(),
+                                to<Forall>(forall.getStmt()).getIndexVar()};
+  bool iteratesSlices = false;
+  match(forall,
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      const Format& format = op->tensorVar.getFormat();
+      if (format.getOrder() == 2 &&
+          format.getModeFormats()[1].getName() == Sell.getName()) {
+        iteratesSlices |=
+            (indexVars[0] == op->indexVars[format.getModeOrdering()[0]] &&
+             indexVars[1] == op->indexVars[format.getModeOrdering()[1]]);
+      }
+    })
+  );
+  return iteratesSlices;
+}
+
 IndexStmt scalarPromote(IndexStmt stmt, ProvenanceGraph provGraph, 
                         bool isWholeStmt, bool promoteScalar) {
   std::map<Access,const ForallNode*> hoistLevel;
@@ -917,6 +972,7 @@ IndexStmt scalarPromote(IndexStmt stmt, ProvenanceGraph provGraph,
     std::map<Access,std::set<IndexVar>> hoistIndices;
     std::set<IndexVar> derivedIndices;
     std::set<IndexVar> indices;
+    std::set<const ForallNode*> slicedForalls;
     const ProvenanceGraph& provGraph;
     const bool isWholeStmt;
     const bool promoteScalar;
@@ -941,9 +997,18 @@ IndexStmt scalarPromote(IndexStmt stmt, ProvenanceGraph provGraph,
         return;
       }
 
+      // The rows of a SELL slice are iterated over innermost, so their results
+      // cannot be accumulated in scalars
+      if (iteratesSlices(foralli)) {
+        slicedForalls.insert(to<ForallNode>(foralli.getStmt().ptr));
+      }
+
       std::vector<Access> resultAccesses;
       std::tie(resultAccesses, std::ignore) = getResultAccesses(foralli);
       for (const auto& resultAccess : resultAccesses) {
+        if (util::contains(slicedForalls, node)) {
+          break;
+        }
         if (!promoteScalar && resultAccess.getIndexVars().empty()) {
           continue;
         }
@@ -97,6 +97,7 @@ Expr Literal::zero(Datatype datatype) {
     case Datatype::Complex128:
       zero = Literal::make(std::complex<double>());
       break;
+    case Datatype::Pattern:
     case Datatype::Undefined:
       taco_ierror;
       break;
@@ -234,6 +235,7 @@ bool Literal::equalsScalar(double scalar) const {
     case Datatype::Complex128:
       return compare<std::complex<double>>(this, scalar);
     break;
+    case Datatype::Pattern:
     case Datatype::Undefined:
       taco_not_supported_yet;
     break;
@@ -800,7 +802,7 @@ Stmt Print::make(std::string fmt, std::vector<Expr> params) {
 }
   
 Expr GetProperty::make(Expr tensor, TensorProperty property, int mode,
-                       int index, std::string name) {
+                       int index, std::string name, Datatype type) {
   GetProperty* gp = new GetProperty;
   gp->tensor = tensor;
   gp->property = property;
@@ -812,7 +814,7 @@ Expr GetProperty::make(Expr tensor, TensorProperty property, int mode,
   if (property == TensorProperty::Values)
     gp->type = tensor.type();
   else
-    gp->type = Int();
+    gp->type = type;
   
   return gp;
 }
@@ -828,6 +830,8 @@ Expr GetProperty::make(Expr tensor, TensorProperty property, int mode) {
   //TODO: deal with the fact that these are pointers.
   if (property == TensorProperty::Values)
     gp->type = tensor.type();
+  else if (property == TensorProperty::ValuesSize)
+    gp->type = Int64;
   else
     gp->type = Int();
   
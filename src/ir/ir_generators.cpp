@@ -37,7 +37,7 @@ Stmt doubleSizeIfFull(Expr a, Expr size, Expr needed) {
 }
 
 Stmt atLeastDoubleSizeIfFull(Expr a, Expr size, Expr needed) {
-  Expr newSizeVar = Var::make(util::toString(a) + "_new_size", Int());
+  Expr newSizeVar = Var::make(util::toString(a) + "_new_size", size.type());
   Expr newSize = Max::make(Mul::make(size, 2), Add::make(needed, 1));
   Stmt computeNewSize = VarDecl::make(newSizeVar, newSize);
   Stmt realloc = Allocate::make(a, newSizeVar, true, size);
@@ -111,6 +111,7 @@ void IRPrinter::visit(const Literal* op) {
       stream << val.real() << " + I*" << val.imag();
     }
     break;
+    case Datatype::Pattern:
     case Datatype::Undefined:
       taco_ierror << "Undefined type in IR";
     break;
@@ -0,0 +1,18 @@
+#include "taco/llvm.h"
+#include "taco/error.h"
+
+using namespace std;
+namespace taco {
+/// Functions used by taco to select the in-process LLVM JIT backend
+static bool LLVM_codegen_enabled = LLVM_BUILT;
+bool should_use_LLVM_codegen() {
+  return LLVM_codegen_enabled;
+}
+
+void set_LLVM_codegen_enabled(bool enabled) {
+  taco_uassert(!enabled || LLVM_BUILT)
+      << "taco was built without LLVM support (configure with -DLLVM=ON)";
+  LLVM_codegen_enabled = enabled;
+}
+
+}
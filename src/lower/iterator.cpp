@@ -69,12 +69,14 @@ Iterator::Iterator(IndexVar indexVar, Expr tensor, Mode mode, Iterator parent,
   if (useNameForPos) {
     posNamePrefix = name;
   }
-  content->posVar   = Var::make(name,            Int());
-  content->endVar   = Var::make("p" + modeName + "_end",   Int());
-  content->beginVar = Var::make("p" + modeName + "_begin", Int());
+
+  const Datatype posType = mode.getModePack().getPosType();
+  content->posVar   = Var::make(name,            posType);
+  content->endVar   = Var::make("p" + modeName + "_end",   posType);
+  content->beginVar = Var::make("p" + modeName + "_begin", posType);
 
   content->coordVar = Var::make(name, Int());
-  content->segendVar = Var::make(modeName + "_segend", Int());
+  content->segendVar = Var::make(modeName + "_segend", posType);
   content->validVar = Var::make("v" + modeName, Bool);
 }
 
@@ -221,6 +223,18 @@ bool Iterator::hasAppend() const {
   return getMode().defined() && getMode().getModeFormat().hasAppend();
 }
 
+bool Iterator::hasRunIter() const {
+  taco_iassert(defined());
+  if (isDimensionIterator()) return false;
+  return getMode().defined() && getMode().getModeFormat().hasRunIter();
+}
+
+bool Iterator::hasWordIter() const {
+  taco_iassert(defined());
+  if (isDimensionIterator()) return false;
+  return getMode().defined() && getMode().getModeFormat().hasWordIter();
+}
+
 ModeFunction Iterator::coordBounds(const std::vector<ir::Expr>& coords) const {
   taco_iassert(defined() && content->mode.defined());
   return getMode().getModeFormat().impl->coordIterBounds(coords, getMode());
@@ -248,6 +262,27 @@ ModeFunction Iterator::posAccess(const ir::Expr& pos,
   return getMode().getModeFormat().impl->posIterAccess(pos, coords, getMode());
 }
 
+ModeFunction Iterator::runBounds(const ir::Expr& parentPos) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->runIterBounds(parentPos, getMode());
+}
+
+ModeFunction Iterator::runAccess(const ir::Expr& pos) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->runIterAccess(pos, getMode());
+}
+
+ModeFunction Iterator::wordBounds(const ir::Expr& parentPos) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->wordIterBounds(parentPos, getMode());
+}
+
+ModeFunction Iterator::wordAccess(const ir::Expr& word) const {
+  taco_iassert(defined() && content->mode.defined());
+  return getMode().getModeFormat().impl->wordIterAccess(getParent().getPosVar(),
+                                                        word, getMode());
+}
+
 ModeFunction Iterator::locate(const std::vector<ir::Expr>& coords) const {
   taco_iassert(defined() && content->mode.defined());
   return getMode().getModeFormat().impl->locate(getParent().getPosVar(),
@@ -411,7 +446,9 @@ Iterators::Iterators(IndexStmt stmt, const map<TensorVar, Expr>& tensorVars)
     })
   );
 
-  // Create access iterators
+  // Create access iterators.  Statements that write the same result access,
+  // such as the definition and mutation of a sequence, share its iterators.
+  vector<Access> resultAccesses;
   match(stmt,
     function<void(const AccessNode*)>([&](auto n) {
       taco_iassert(util::contains(tensorVars, n->tensorVar));
@@ -421,7 +458,18 @@ Iterators::Iterators(IndexStmt stmt, const map<TensorVar, Expr>& tensorVars)
     }),
     function<void(const AssignmentNode*, Matcher*)>([&](auto n, auto m) {
       m->match(n->rhs);
+      Access lhs = n->lhs;
+      for (auto& resultAccess : resultAccesses) {
+        if (equals(lhs, resultAccess)) {
+          for (int level = 0; level <= lhs.getTensorVar().getOrder(); level++) {
+            content->levelIterators.insert(
+                {{lhs, level}, content->levelIterators.at({resultAccess, level})});
+          }
+          return;
+        }
+      }
       m->match(n->lhs);
+      resultAccesses.push_back(lhs);
     })
   );
 
@@ -450,9 +498,14 @@ Iterators::createAccessIterators(Access access, Format format, Expr tensorIR, Pr
     taco_iassert(modeTypePack.getModeFormats().size() > 0);
 
     int modeNumber = format.getModeOrdering()[level-1];
+    vector<Datatype> arrayTypes;
+    if ((size_t)(level-1) < format.getLevelArrayTypes().size()) {
+      arrayTypes = format.getLevelArrayTypes()[level-1];
+    }
     ModePack modePack(modeTypePack.getModeFormats().size(),
                       modeTypePack.getModeFormats()[0], tensorIR,
-                      modeNumber, level);
+                      modeNumber, level, arrayTypes,
+                      format.getPositionType());
 
     int pos = 0;
     for (auto& modeType : modeTypePack.getModeFormats()) {
@@ -7,9 +7,12 @@
 #include "taco/ir/ir.h"
 #include "ir/ir_generators.h"
 #include "taco/ir/ir_visitor.h"
+#include "taco/ir/ir_rewriter.h"
 #include "taco/ir/simplify.h"
 #include "taco/lower/iterator.h"
 #include "taco/lower/merge_lattice.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_sell.h"
 #include "mode_access.h"
 #include "taco/util/collections.h"
 
@@ -69,7 +72,8 @@ static void createCapacityVars(const map<TensorVar, Expr>& tensorVars,
                                map<Expr, Expr>* capacityVars) {
   for (auto& tensorVar : tensorVars) {
     Expr tensor = tensorVar.second;
-    Expr capacityVar = Var::make(util::toString(tensor) + "_capacity", Int());
+    Expr capacityVar = Var::make(util::toString(tensor) + "_capacity",
+                                 tensorVar.first.getFormat().getPositionType());
     capacityVars->insert({tensor, capacityVar});
   }
 }
@@ -84,6 +88,71 @@ static void createReducedValueVars(const vector<Access>& inputAccesses,
   }
 }
 
+/// Returns true iff `var` is a pattern tensor, whose components are all one
+/// and which therefore has no values array to load from or store to.
+static bool isPattern(TensorVar var) {
+  return var.getType().getDataType().isPattern();
+}
+
+/// Returns true iff `mode` of `var` is a dense block of a blocked format: a
+/// dense level of small constant size stored below a sparse level.
+static bool isDenseBlockMode(TensorVar var, int mode) {
+  const size_t maxBlockSize = 16;
+  const Format& format = var.getFormat();
+  const Dimension& size = var.getType().getShape().getDimension(mode);
+  if (!size.isFixed() || size.getSize() > maxBlockSize) {
+    return false;
+  }
+  bool belowSparseLevel = false;
+  for (int level = 0; level < format.getOrder(); ++level) {
+    const bool isDense =
+        format.getModeFormats()[level].getName() == Dense.getName();
+    if (format.getModeOrdering()[level] == mode) {
+      return isDense && belowSparseLevel;
+    }
+    belowSparseLevel |= !isDense;
+  }
+  return false;
+}
+
+/// Rewrites `stmt` to replace the dimensions and index arrays of the temporary
+/// `tensor`, which has no tensor struct to read them from, with `dimensions`
+/// and with the arrays in `indexArrays`, keyed by level and array.
+static Stmt replaceTemporaryProperties(
+    Stmt stmt, Expr tensor, const vector<Expr>& dimensions,
+    const map<pair<int,int>, Expr>& indexArrays) {
+  struct ReplaceProperties : IRRewriter {
+    Expr tensor;
+    vector<Expr> dimensions;
+    map<pair<int,int>, Expr> indexArrays;
+
+    using IRRewriter::visit;
+
+    void visit(const GetProperty* op) {
+      if (op->tensor == tensor && op->property == TensorProperty::Dimension) {
+        taco_iassert(op->mode < (int)dimensions.size());
+        expr = dimensions[op->mode];
+      }
+      else if (op->tensor == tensor &&
+               op->property == TensorProperty::Indices) {
+        taco_iassert(indexArrays.count({op->mode, op->index}));
+        expr = indexArrays.at({op->mode, op->index});
+      }
+      else {
+        expr = op;
+      }
+    }
+  };
+  if (!stmt.defined()) {
+    return stmt;
+  }
+  ReplaceProperties rewriter;
+  rewriter.tensor = tensor;
+  rewriter.dimensions = dimensions;
+  rewriter.indexArrays = indexArrays;
+  return rewriter.rewrite(stmt);
+}
+
 /// Returns true iff `stmt` modifies an array
 static bool hasStores(Stmt stmt) {
   struct FindStores : IRVisitor {
@@ -104,6 +173,40 @@ static bool hasStores(Stmt stmt) {
   return stmt.defined() && FindStores().hasStores(stmt);
 }
 
+/// Returns true if `expr` reads only literals and tensor properties, which are
+/// available before any loop and so do not change between loop iterations.
+static bool isLoopInvariant(Expr expr) {
+  struct FindVariables : IRVisitor {
+    bool hasVariable;
+
+    using IRVisitor::visit;
+
+    void visit(const Var* op) {
+      hasVariable = true;
+    }
+
+    void visit(const Load* op) {
+      hasVariable = true;
+    }
+
+    void visit(const GetProperty* op) {
+    }
+
+    bool hasVariables(Expr expr) {
+      hasVariable = false;
+      expr.accept(this);
+      return hasVariable;
+    }
+  };
+  return !FindVariables().hasVariables(expr);
+}
+
+/// Returns true if the positions of the fibers `iterator` iterates over are
+/// strided, like those of a SELL mode.
+static bool isStrided(Iterator iterator) {
+  return iterator.hasPosIter() && iterator.posBounds(0).numResults() > 2;
+}
+
 Stmt
 LowererImpl::lower(IndexStmt stmt, string name, 
                    bool assemble, bool compute, bool pack, bool unpack)
@@ -165,6 +268,7 @@ LowererImpl::lower(IndexStmt stmt, string name,
   vector<IndexVar> indexVars = getIndexVars(stmt);
   for (auto& indexVar : indexVars) {
     Expr dimension;
+    Expr blockDimension;
     match(stmt,
       function<void(const AssignmentNode*, Matcher*)>([&](
           const AssignmentNode* n, Matcher* m) {
@@ -188,10 +292,19 @@ LowererImpl::lower(IndexStmt stmt, string name,
           if(!util::contains(temporariesSet, n->tensorVar)) {
             dimension = GetProperty::make(tensorVars.at(n->tensorVar),
                                           TensorProperty::Dimension, loc);
+            if (isDenseBlockMode(n->tensorVar, loc)) {
+              blockDimension = ir::Literal::make((int)n->tensorVar.getType()
+                  .getShape().getDimension(loc).getSize());
+            }
           }
         }
       })
     );
+    // Loops over dense blocks get constant bounds, so that the C compiler can
+    // fully unroll and vectorize them
+    if (blockDimension.defined()) {
+      dimension = blockDimension;
+    }
     dimensions.insert({indexVar, dimension});
     underivedBounds.insert({indexVar, {ir::Literal::make(0), dimension}});
   }
@@ -269,6 +382,11 @@ Stmt LowererImpl::lowerAssignment(Assignment assignment)
     Expr var = getTensorVar(result);
     Expr rhs = lower(assignment.getRhs());
 
+    // Reductions over a run add its value once per coordinate of the run
+    if (runLength.defined()) {
+      rhs = ir::Mul::make(rhs, ir::Cast::make(runLength, rhs.type()));
+    }
+
     // Assignment to scalar variables.
     if (isScalar(result.getType())) {
       if (!assignment.getOperator().defined()) {
@@ -280,6 +398,10 @@ Stmt LowererImpl::lowerAssignment(Assignment assignment)
         return compoundAssign(var, rhs, markAssignsAtomicDepth > 0 && !util::contains(whereTemps, result), atomicParallelUnit);
       }
     }
+    // Pattern results only store coordinates, so there is no value to store.
+    else if (isPattern(result)) {
+      return Stmt();
+    }
     // Assignments to tensor variables (non-scalar).
     else {
       Expr values = getValuesArray(result);
@@ -317,6 +439,10 @@ Stmt LowererImpl::lowerYield(Yield yield) {
     coords.push_back(getCoordinateVar(indexVar));
   }
   Expr val = lower(yield.getExpr());
+  // Components of pattern tensors are yielded as bools
+  if (yield.getExpr().getDataType().isPattern()) {
+    val = ir::Cast::make(val, Bool);
+  }
   return ir::Yield::make(coords, val);
 }
 
@@ -328,8 +454,9 @@ splitAppenderAndInserters(const vector<Iterator>& results) {
 
   // TODO: Choose insert when the current forall is nested inside a reduction
   for (auto& result : results) {
-    taco_iassert(result.hasAppend() || result.hasInsert())
-        << "Results must support append or insert";
+    taco_uassert(result.hasAppend() || result.hasInsert())
+        << "Results must support append or insert, which "
+        << result.getMode().getModeFormat() << " modes do not";
 
     if (result.hasAppend()) {
       appenders.push_back(result);
@@ -415,8 +542,20 @@ Stmt LowererImpl::lowerForall(Forall forall)
                                         reducedAccesses);
 
   Stmt loops;
+  Iterator sellIterator;
+  // Emit loops over the slices of a SELL mode, and over their fibers
+  if (canIterateSlices(forall, lattice, &sellIterator)) {
+    vector<Iterator> appenders;
+    vector<Iterator> inserters;
+    tie(appenders, inserters) =
+        splitAppenderAndInserters(lattice.points()[0].results());
+    loops = lowerForallSlices(forall, sellIterator,
+                              lattice.points()[0].locators(), inserters,
+                              reducedAccesses, recoveryStmt);
+  }
   // Emit a loop that iterates over over a single iterator (optimization)
-  if (lattice.iterators().size() == 1 && lattice.iterators()[0].isUnique()) {
+  else if (lattice.iterators().size() == 1 &&
+           lattice.iterators()[0].isUnique()) {
     taco_iassert(lattice.points().size() == 1);
 
     MergePoint point = lattice.points()[0];
@@ -460,13 +599,36 @@ Stmt LowererImpl::lowerForall(Forall forall)
       loops = lowerForallPosition(forall, iterator, locators,
                                     inserters, appenders, reducedAccesses, recoveryStmt);
     }
+    // Emit word iteration loops
+    else if (iterator.hasWordIter() && canIterateWords(forall)) {
+      loops = lowerForallWords(forall, {iterator}, locators, inserters,
+                               appenders, reducedAccesses, recoveryStmt);
+    }
+    // Emit run iteration loops
+    else if (iterator.hasRunIter() &&
+             provGraph.isUnderived(forall.getIndexVar()) &&
+             (iterator.getParent().isRoot() || iterator.getParent().isUnique())) {
+      loops = lowerForallRuns(forall, iterator, locators,
+                              inserters, appenders, reducedAccesses, recoveryStmt);
+    }
     // Emit coordinate iteration loop
     else {
       taco_iassert(iterator.hasCoordIter());
-//      taco_not_supported_yet
-      loops = Stmt();
+      loops = lowerForallCoordinate(forall, iterator, locators,
+                                    inserters, appenders, reducedAccesses, recoveryStmt);
     }
   }
+  // Emit a loop over the union of the words of multiple iterators
+  else if (util::all(lattice.iterators(),
+                     [](Iterator iterator) { return iterator.hasWordIter(); }) &&
+           canIterateWords(forall)) {
+    vector<Iterator> appenders;
+    vector<Iterator> inserters;
+    tie(appenders, inserters) = splitAppenderAndInserters(lattice.results());
+    loops = lowerForallWords(forall, lattice.iterators(),
+                             lattice.points()[0].locators(), inserters,
+                             appenders, reducedAccesses, recoveryStmt);
+  }
   // Emit general loops to merge multiple iterators
   else {
     std::vector<IndexVar> underivedAncestors = provGraph.getUnderivedAncestors(forall.getIndexVar());
@@ -481,6 +643,16 @@ Stmt LowererImpl::lowerForall(Forall forall)
     // omitted.
     loops = Stmt();
   }
+
+  // Allocate the per-thread workspaces of nested where statements around the
+  // outermost parallel loop
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel &&
+      inParallelLoopDepth == 1 && !hoistedAllocations.empty()) {
+    loops = Block::make(Block::make(hoistedAllocations), loops,
+                        Block::make(hoistedFrees));
+    hoistedAllocations.clear();
+    hoistedFrees.clear();
+  }
   definedIndexVars.erase(forall.getIndexVar());
   definedIndexVarsOrdered.pop_back();
   if (forall.getParallelUnit() != ParallelUnit::NotParallel) {
@@ -831,8 +1003,393 @@ Stmt LowererImpl::lowerForallCoordinate(Forall forall, Iterator iterator,
                                         vector<Iterator> appenders,
                                         set<Access> reducedAccesses,
                                         ir::Stmt recoveryStmt) {
-  taco_not_supported_yet;
-  return Stmt();
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+
+  // Access the position of the coordinate, which the mode may not store
+  ModeFunction coordAccess = iterator.coordAccess(coordinates(iterator));
+  Stmt declarePosVar = VarDecl::make(iterator.getPosVar(), coordAccess[0]);
+  Expr found = coordAccess[1];
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth++;
+    atomicParallelUnit = forall.getParallelUnit();
+  }
+
+  Stmt body = lowerForallBody(coordinate, forall.getStmt(),
+                              locators, inserters, appenders, reducedAccesses);
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth--;
+  }
+
+  if (!isValue(found, true)) {
+    body = IfThenElse::make(found, body);
+  }
+  body = Block::make(recoveryStmt, coordAccess.compute(), declarePosVar, body);
+
+  Stmt posAppend = generateAppendPositions(appenders);
+
+  // Code to compute iteration bounds
+  Stmt boundsCompute;
+  Expr startBound, endBound;
+  if (!provGraph.isUnderived(forall.getIndexVar())) {
+    vector<Expr> bounds = provGraph.deriveIterBounds(forall.getIndexVar(), definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
+    startBound = bounds[0];
+    endBound = bounds[1];
+  }
+  else {
+    vector<Expr> parentCoords = coordinates(iterator);
+    parentCoords.pop_back();
+    ModeFunction bounds = iterator.coordBounds(parentCoords);
+    boundsCompute = bounds.compute();
+    startBound = bounds[0];
+    endBound = bounds[1];
+  }
+
+  LoopKind kind = LoopKind::Serial;
+  if (forall.getParallelUnit() == ParallelUnit::CPUVector && !ignoreVectorize) {
+    kind = LoopKind::Vectorized;
+  }
+  else if (forall.getParallelUnit() != ParallelUnit::NotParallel
+           && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
+    kind = LoopKind::Runtime;
+  }
+  // Loop with preamble and postamble
+  return Block::blanks(boundsCompute,
+                       For::make(coordinate, startBound, endBound, 1, body,
+                                 kind,
+                                 ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), ignoreVectorize ? 0 : forall.getUnrollFactor()),
+                       posAppend);
+}
+
+Stmt LowererImpl::lowerForallRuns(Forall forall, Iterator iterator,
+                                  vector<Iterator> locators,
+                                  vector<Iterator> inserters,
+                                  vector<Iterator> appenders,
+                                  set<Access> reducedAccesses,
+                                  ir::Stmt recoveryStmt) {
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+  ModeFunction runAccess = iterator.runAccess(iterator.getPosVar());
+  Expr runBegin = runAccess[0];
+  Expr runEnd = runAccess[1];
+
+  // A reduction whose operands do not depend on the coordinate, other than
+  // through the run, adds the same value for every coordinate of the run
+  bool reduceRuns = false;
+  if (isa<Assignment>(forall.getStmt()) && inserters.empty() &&
+      appenders.empty() && provGraph.getChildren(forall.getIndexVar()).empty()) {
+    Assignment assignment = to<Assignment>(forall.getStmt());
+    reduceRuns = assignment.getOperator().defined() &&
+                 isa<taco::Add>(assignment.getOperator()) &&
+                 !util::contains(assignment.getLhs().getIndexVars(),
+                                 forall.getIndexVar());
+    match(assignment.getRhs(),
+      std::function<void(const AccessNode*)>([&](const AccessNode* node) {
+        Access access(node);
+        if (util::contains(access.getIndexVars(), forall.getIndexVar()) &&
+            !util::contains(getIterators(access), iterator)) {
+          reduceRuns = false;
+        }
+      })
+    );
+  }
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth++;
+    atomicParallelUnit = forall.getParallelUnit();
+  }
+
+  Stmt body;
+  if (reduceRuns) {
+    runLength = ir::Sub::make(runEnd, runBegin);
+    body = lowerForallBody(coordinate, forall.getStmt(),
+                           locators, inserters, appenders, reducedAccesses);
+    runLength = Expr();
+  }
+  else {
+    body = lowerForallBody(coordinate, forall.getStmt(),
+                           locators, inserters, appenders, reducedAccesses);
+    body = For::make(coordinate, runBegin, runEnd, 1,
+                     Block::make(recoveryStmt, body));
+  }
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth--;
+  }
+
+  Stmt posAppend = generateAppendPositions(appenders);
+
+  ModeFunction bounds = iterator.runBounds(iterator.getParent().getPosVar());
+
+  LoopKind kind = LoopKind::Serial;
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel
+      && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
+    kind = LoopKind::Runtime;
+  }
+  // Loop over runs, with the coordinates of every run in an inner loop
+  return Block::blanks(bounds.compute(),
+                       For::make(iterator.getPosVar(), bounds[0], bounds[1], 1,
+                                 Block::make(runAccess.compute(), body),
+                                 kind,
+                                 ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), ignoreVectorize ? 0 : forall.getUnrollFactor()),
+                       posAppend);
+}
+
+Stmt LowererImpl::lowerForallWords(Forall forall, vector<Iterator> iterators,
+                                   vector<Iterator> locators,
+                                   vector<Iterator> inserters,
+                                   vector<Iterator> appenders,
+                                   set<Access> reducedAccesses,
+                                   ir::Stmt recoveryStmt) {
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+  Expr word = Var::make(util::toString(coordinate) + "_word", Int());
+  Expr bits = Var::make(util::toString(coordinate) + "_bits", UInt64);
+
+  // The loop visits the union of the coordinates of the iterators, so their
+  // words are or-ed.  Located operands whose zeros zero the statement limit it
+  // to their own coordinates, so their words are and-ed in.
+  vector<Stmt> wordAccesses;
+  Expr wordBits;
+  for (auto& iterator : iterators) {
+    ModeFunction wordAccess = iterator.wordAccess(word);
+    wordAccesses.push_back(wordAccess.compute());
+    wordBits = wordBits.defined() ? BitOr::make(wordBits, wordAccess[0])
+                                  : wordAccess[0];
+  }
+  for (auto& locator : locators) {
+    if (!locator.hasWordIter() ||
+        zero(forall.getStmt(),
+             {this->iterators.modeAccess(locator).getAccess()}).defined()) {
+      continue;
+    }
+    ModeFunction wordAccess = locator.wordAccess(word);
+    wordAccesses.push_back(wordAccess.compute());
+    wordBits = BitAnd::make(wordBits, wordAccess[0]);
+  }
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth++;
+    atomicParallelUnit = forall.getParallelUnit();
+  }
+
+  // The iterators are located into, like the other operands, once the bits
+  // give the coordinate
+  vector<Iterator> bodyLocators = locators;
+  bodyLocators.insert(bodyLocators.end(), iterators.begin(), iterators.end());
+  Stmt body = lowerForallBody(coordinate, forall.getStmt(),
+                              bodyLocators, inserters, appenders,
+                              reducedAccesses);
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth--;
+  }
+
+  // Visit the set bits lowest first, clearing each one as it is visited
+  Expr bit = Call::make("taco_ctz", {bits}, Int());
+  Stmt nextBit = Block::make(
+      VarDecl::make(coordinate, ir::Add::make(ir::Mul::make(word, 64), bit)),
+      Assign::make(bits, BitAnd::make(bits, ir::Sub::make(bits,
+                                          ir::Literal::make((uint64_t)1)))),
+      recoveryStmt, body);
+  Stmt visitBits = While::make(Neq::make(bits, ir::Literal::zero(UInt64)),
+                               nextBit);
+
+  Stmt posAppend = generateAppendPositions(appenders);
+
+  ModeFunction bounds =
+      iterators[0].wordBounds(iterators[0].getParent().getPosVar());
+
+  LoopKind kind = LoopKind::Serial;
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel
+      && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
+    kind = LoopKind::Runtime;
+  }
+  // Loop over words, with the set bits of every word in an inner loop
+  return Block::blanks(bounds.compute(),
+                       For::make(word, bounds[0], bounds[1], 1,
+                                 Block::make(Block::make(wordAccesses),
+                                             VarDecl::make(bits, wordBits),
+                                             visitBits),
+                                 kind,
+                                 ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit()),
+                       posAppend);
+}
+
+bool LowererImpl::canIterateWords(Forall forall) const {
+  return provGraph.isUnderived(forall.getIndexVar()) &&
+         !should_use_CUDA_codegen() &&
+         (forall.getParallelUnit() == ParallelUnit::NotParallel ||
+          forall.getParallelUnit() == ParallelUnit::CPUThread);
+}
+
+const SellModeFormat* LowererImpl::getSellModeFormat(Iterator iterator) {
+  if (!iterator.isModeIterator()) {
+    return nullptr;
+  }
+  return dynamic_cast<const SellModeFormat*>(
+      iterator.getMode().getModeFormat().impl.get());
+}
+
+bool LowererImpl::canIterateSlices(Forall forall, MergeLattice lattice,
+                                   Iterator* iterator) const {
+  if (!isa<Forall>(forall.getStmt()) || should_use_CUDA_codegen() ||
+      lattice.points().size() != 1 ||
+      util::any(lattice.results(),
+                [](Iterator it) { return it.hasAppend(); })) {
+    return false;
+  }
+  Forall inner = to<Forall>(forall.getStmt());
+  if (!provGraph.isUnderived(forall.getIndexVar()) ||
+      !provGraph.isUnderived(inner.getIndexVar()) ||
+      (forall.getParallelUnit() != ParallelUnit::NotParallel &&
+       forall.getParallelUnit() != ParallelUnit::CPUThread) ||
+      inner.getParallelUnit() != ParallelUnit::NotParallel) {
+    return false;
+  }
+
+  bool hasSellOperand = false;
+  match(inner,
+    function<void(const AccessNode*)>([&](const AccessNode* op) {
+      for (auto& modeFormat : op->tensorVar.getFormat().getModeFormats()) {
+        hasSellOperand |= (modeFormat.getName() == Sell.getName());
+      }
+    })
+  );
+  if (!hasSellOperand) {
+    return false;
+  }
+
+  // The nested forall must iterate over a SELL mode alone, whose fibers are
+  // the rows of a dense level that the forall iterates over
+  set<IndexVar> innerDefinedIndexVars = definedIndexVars;
+  innerDefinedIndexVars.insert(inner.getIndexVar());
+  MergeLattice innerLattice = MergeLattice::make(inner, iterators, provGraph,
+                                                 innerDefinedIndexVars,
+                                                 whereTempsToResult);
+  if (innerLattice.iterators().size() != 1 ||
+      innerLattice.points().size() != 1 ||
+      util::any(innerLattice.results(),
+                [](Iterator it) { return it.hasAppend(); })) {
+    return false;
+  }
+  Iterator sellIterator = innerLattice.iterators()[0];
+  const SellModeFormat* sell = getSellModeFormat(sellIterator);
+  if (sell == nullptr ||
+      sellIterator.getParent().getIndexVar() != forall.getIndexVar() ||
+      !sellIterator.getParent().getParent().isRoot()) {
+    return false;
+  }
+
+  // Iterating over slices visits the fibers out of order, so strided
+  // iteration is kept for yields of fibers that are not sorted
+  bool hasYield = false;
+  match(inner,
+    function<void(const YieldNode*)>([&](const YieldNode*) {
+      hasYield = true;
+    })
+  );
+  if (hasYield && sell->getSortingScope() == 1) {
+    return false;
+  }
+
+  *iterator = sellIterator;
+  return true;
+}
+
+Stmt LowererImpl::lowerForallSlices(Forall forall, Iterator iterator,
+                                    vector<Iterator> locators,
+                                    vector<Iterator> inserters,
+                                    set<Access> reducedAccesses,
+                                    ir::Stmt recoveryStmt)
+{
+  const SellModeFormat* sell = getSellModeFormat(iterator);
+  const int sliceHeight = sell->getSliceHeight();
+  Iterator fiberIterator = iterator.getParent();
+  Forall inner = to<Forall>(forall.getStmt());
+  Expr coordinate = getCoordinateVar(forall.getIndexVar());
+  Expr innerCoordinate = getCoordinateVar(inner.getIndexVar());
+  Expr slice = Var::make(util::toString(coordinate) + "_slice", Int());
+  Expr lane = Var::make(util::toString(coordinate) + "_lane", Int());
+  Expr slot = Var::make(util::toString(iterator.getPosVar()) + "_slot", Int());
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth++;
+    atomicParallelUnit = forall.getParallelUnit();
+  }
+
+  // Lower the nested forall's body for the coordinate at the fiber's position
+  // in the slot
+  definedIndexVars.insert(inner.getIndexVar());
+  definedIndexVarsOrdered.push_back(inner.getIndexVar());
+  MergeLattice innerLattice = MergeLattice::make(inner, iterators, provGraph,
+                                                 definedIndexVars,
+                                                 whereTempsToResult);
+  MergePoint point = innerLattice.points()[0];
+  vector<Access> innerResultAccesses;
+  set<Access> innerReducedAccesses;
+  std::tie(innerResultAccesses, innerReducedAccesses) =
+      getResultAccesses(inner);
+  Stmt preInitValues = initResultArrays(inner.getIndexVar(),
+                                        innerResultAccesses,
+                                        getArgumentAccesses(inner),
+                                        innerReducedAccesses);
+  vector<Iterator> innerAppenders;
+  vector<Iterator> innerInserters;
+  tie(innerAppenders, innerInserters) =
+      splitAppenderAndInserters(point.results());
+  taco_iassert(innerAppenders.empty());
+
+  ModeFunction posAccess = iterator.posAccess(iterator.getPosVar(),
+                                              coordinates(iterator));
+  Stmt innerBody = lowerForallBody(innerCoordinate, inner.getStmt(),
+                                   point.locators(), innerInserters, {},
+                                   innerReducedAccesses);
+  innerBody = Block::make(VarDecl::make(iterator.getPosVar(),
+                                        ir::Add::make(slot, lane)),
+                          VarDecl::make(innerCoordinate,
+                                        posAccess.getResults()[0]),
+                          IfThenElse::make(posAccess.getResults()[1],
+                                           innerBody));
+  definedIndexVars.erase(inner.getIndexVar());
+  definedIndexVarsOrdered.pop_back();
+
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
+    markAssignsAtomicDepth--;
+  }
+
+  // The fibers of a slice are its lanes, whose coordinate is the fiber's row
+  // unless the fibers are sorted
+  accessibleIterators.insert(fiberIterator);
+  locators = filter(locators, [&](Iterator it) { return !(it == fiberIterator); });
+  Stmt declFiber = VarDecl::make(fiberIterator.getPosVar(),
+                                 ir::Add::make(ir::Mul::make(slice, sliceHeight),
+                                           lane));
+  Stmt declCoordinate = VarDecl::make(coordinate,
+      sell->fiberCoord(fiberIterator.getPosVar(), iterator.getMode()));
+  Stmt laneBody = Block::make(declFiber, declCoordinate, recoveryStmt,
+                              declLocatePosVars(inserters),
+                              insertCoordinates(inserters),
+                              declLocatePosVars(locators), preInitValues,
+                              innerBody);
+
+  // Emit the lane loop innermost, with a constant bound, so that it accesses
+  // the adjacent coordinates and values of a slot
+  ModeFunction sliceBounds = sell->sliceBounds(slice, iterator.getMode());
+  Stmt slotLoop = For::make(slot, sliceBounds[0], sliceBounds[1], sliceHeight,
+                            For::make(lane, 0, sliceHeight, 1, laneBody));
+
+  std::vector<ir::Expr> bounds = provGraph.deriveIterBounds(forall.getIndexVar(), definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
+  Expr numSlices = ir::Div::make(ir::Add::make(bounds[1], sliceHeight - 1),
+                             sliceHeight);
+
+  LoopKind kind = LoopKind::Serial;
+  if (forall.getParallelUnit() != ParallelUnit::NotParallel
+      && forall.getOutputRaceStrategy() != OutputRaceStrategy::ParallelReduction && !ignoreVectorize) {
+    kind = LoopKind::Runtime;
+  }
+  return For::make(slice, 0, numSlices, 1,
+                   Block::make(sliceBounds.compute(), slotLoop), kind,
+                   ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit());
 }
 
 Stmt LowererImpl::lowerForallPosition(Forall forall, Iterator iterator,
@@ -844,10 +1401,12 @@ Stmt LowererImpl::lowerForallPosition(Forall forall, Iterator iterator,
 {
   Expr coordinate = getCoordinateVar(forall.getIndexVar());
   Stmt declareCoordinate = Stmt();
+  Expr found;
   if (provGraph.isCoordVariable(forall.getIndexVar())) {
-    Expr coordinateArray = iterator.posAccess(iterator.getPosVar(),
-                                              coordinates(iterator)).getResults()[0];
-    declareCoordinate = VarDecl::make(coordinate, coordinateArray);
+    ModeFunction posAccess = iterator.posAccess(iterator.getPosVar(),
+                                                coordinates(iterator));
+    declareCoordinate = VarDecl::make(coordinate, posAccess.getResults()[0]);
+    found = posAccess.getResults()[1];
   }
   if (forall.getParallelUnit() != ParallelUnit::NotParallel && forall.getOutputRaceStrategy() == OutputRaceStrategy::Atomics) {
     markAssignsAtomicDepth++;
@@ -860,6 +1419,12 @@ Stmt LowererImpl::lowerForallPosition(Forall forall, Iterator iterator,
     markAssignsAtomicDepth--;
   }
 
+  // Skip positions that hold no coordinate, like the empty slots of a hashed
+  // mode
+  if (found.defined() && !isValue(found, true)) {
+    body = IfThenElse::make(found, body);
+  }
+
   body = Block::make(recoveryStmt, body);
 
   // Code to append positions
@@ -868,18 +1433,32 @@ Stmt LowererImpl::lowerForallPosition(Forall forall, Iterator iterator,
   // Code to compute iteration bounds
   Stmt boundsCompute;
   Expr startBound, endBound;
+  Expr stride = 1;
   Expr parentPos = iterator.getParent().getPosVar();
   if (!provGraph.isUnderived(iterator.getIndexVar())) {
+    taco_uassert(!isStrided(iterator)) << "The strided positions iterated "
+        << "over by " << forall.getIndexVar() << " cannot be split";
     vector<Expr> bounds = provGraph.deriveIterBounds(iterator.getIndexVar(), definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
     startBound = bounds[0];
     endBound = bounds[1];
   }
   else if (iterator.getParent().isRoot() || iterator.getParent().isUnique()) {
-    // E.g. a compressed mode without duplicates
+    const SellModeFormat* sell = getSellModeFormat(iterator);
+    taco_uassert(sell == nullptr || sell->getSortingScope() == 1)
+        << "The fibers of the SELL mode iterated over by "
+        << forall.getIndexVar() << " are sorted, so they can only be iterated "
+        << "over slice by slice, in a forall nested in a forall over their "
+        << "rows";
+
+    // E.g. a compressed mode without duplicates, or a SELL mode whose fibers
+    // are interleaved with stride
     ModeFunction bounds = iterator.posBounds(parentPos);
     boundsCompute = bounds.compute();
     startBound = bounds[0];
     endBound = bounds[1];
+    if (bounds.numResults() > 2) {
+      stride = bounds[2];
+    }
   } else {
     taco_iassert(iterator.isOrdered() && iterator.getParent().isOrdered());
     taco_iassert(iterator.isCompact() && iterator.getParent().isCompact());
@@ -903,8 +1482,8 @@ Stmt LowererImpl::lowerForallPosition(Forall forall, Iterator iterator,
   }
   // Loop with preamble and postamble
   return Block::blanks(boundsCompute,
-                       For::make(iterator.getPosVar(), startBound, endBound, 1,
-                                 Block::make(declareCoordinate, body),
+                       For::make(iterator.getPosVar(), startBound, endBound,
+                                 stride, Block::make(declareCoordinate, body),
                                  kind,
                                  ignoreVectorize ? ParallelUnit::NotParallel : forall.getParallelUnit(), ignoreVectorize ? 0 : forall.getUnrollFactor()),
                        posAppend);
@@ -918,6 +1497,8 @@ Stmt LowererImpl::lowerForallFusedPosition(Forall forall, Iterator iterator,
                                       set<Access> reducedAccesses,
                                       ir::Stmt recoveryStmt)
 {
+  taco_uassert(!isStrided(iterator)) << "The strided positions iterated "
+      << "over by " << forall.getIndexVar() << " cannot be fused";
   Expr coordinate = getCoordinateVar(forall.getIndexVar());
   Stmt declareCoordinate = Stmt();
   if (provGraph.isCoordVariable(forall.getIndexVar())) {
@@ -1078,6 +1659,10 @@ Stmt LowererImpl::lowerMergeLattice(MergeLattice lattice, IndexVar coordinateVar
   vector<Iterator> appenders = filter(lattice.results(),
                                       [](Iterator it){return it.hasAppend();});
 
+  taco_uassert(!util::any(lattice.iterators(), isStrided)) <<
+      "Modes with strided positions, like SELL modes, cannot be merged with "
+      "other operands";
+
   vector<Iterator> mergers = lattice.points()[0].mergers();
   Stmt iteratorVarInits = codeToInitializeIteratorVars(lattice.iterators(), lattice.points()[0].rangers(), mergers, coordinate, coordinateVar);
 
@@ -1129,6 +1714,9 @@ Stmt LowererImpl::lowerMergePoint(MergeLattice pointLattice,
   // Merge iterator coordinate variables
   Stmt resolvedCoordinate = resolveCoordinate(mergers, coordinate, !resolvedCoordDeclared);
 
+  // Access positions of coordinate iterators
+  Stmt loadCoordIterPosVars = codeToAccessCoordIterators(iterators);
+
   // Locate positions
   Stmt loadLocatorPosVars = declLocatePosVars(locators);
 
@@ -1150,6 +1738,7 @@ Stmt LowererImpl::lowerMergePoint(MergeLattice pointLattice,
   return While::make(checkThatNoneAreExhausted(rangers),
                      Block::make(loadPosIterCoordinates,
                                  resolvedCoordinate,
+                                 loadCoordIterPosVars,
                                  loadLocatorPosVars,
                                  deduplicationLoops,
                                  caseStmts,
@@ -1168,8 +1757,9 @@ Stmt LowererImpl::resolveCoordinate(std::vector<Iterator> mergers, ir::Expr coor
                          resolution);
     }
     else if (merger.hasCoordIter()) {
-      taco_not_supported_yet;
-      return Stmt();
+      // Just one coordinate iterator so its coordinate is the resolved one
+      return emitVarDecl ? VarDecl::make(coordinate, merger.getCoordVar())
+                         : Assign::make(coordinate, merger.getCoordVar());
     }
     else if (merger.isDimensionIterator()) {
       // Just one dimension iterator so resolved coordinate already exist and we
@@ -1206,9 +1796,21 @@ Stmt LowererImpl::lowerMergeCases(ir::Expr coordinate, IndexVar coordinateVar, I
   if (lattice.iterators().size() == 1) {
     Stmt body = lowerForallBody(coordinate, stmt, {}, inserters, 
                                 appenders, reducedAccesses);
+    Iterator iterator = lattice.iterators()[0];
+    if (iterator.hasCoordIter() &&
+        !isValue(coordIterAccess(iterator)[1], true)) {
+      body = IfThenElse::make(iterator.getValidVar(), body);
+    }
     result.push_back(body);
   }
   else {
+    // Coordinate iterators may visit coordinates the mode does not store, in
+    // which case none of the cases might apply
+    bool exact = lattice.exact() &&
+                 !any(lattice.iterators(), [&](Iterator it) {
+                   return it.hasCoordIter() &&
+                          !isValue(coordIterAccess(it)[1], true);
+                 });
     vector<pair<Expr,Stmt>> cases;
     for (MergePoint point : lattice.points()) {
 
@@ -1218,6 +1820,10 @@ Stmt LowererImpl::lowerMergeCases(ir::Expr coordinate, IndexVar coordinateVar, I
         if (!(provGraph.isCoordVariable(iterator.getIndexVar()) && provGraph.isDerivedFrom(iterator.getIndexVar(), coordinateVar))) {
           coordComparisons.push_back(Eq::make(iterator.getCoordVar(), coordinate));
         }
+        // Coordinate iterators may visit coordinates the mode does not store
+        if (iterator.hasCoordIter() && !isValue(coordIterAccess(iterator)[1], true)) {
+          coordComparisons.push_back(iterator.getValidVar());
+        }
       }
 
       // Construct case body
@@ -1232,7 +1838,7 @@ Stmt LowererImpl::lowerMergeCases(ir::Expr coordinate, IndexVar coordinateVar, I
       }
       cases.push_back({taco::ir::conjunction(coordComparisons), body});
     }
-    result.push_back(Case::make(cases, lattice.exact()));
+    result.push_back(Case::make(cases, exact));
   }
 
   return Block::make(result);
@@ -1257,16 +1863,18 @@ Stmt LowererImpl::lowerForallBody(Expr coordinate, IndexStmt stmt,
     captureNextLocatePos = false;
   }
 
+  // Code to insert coordinates
+  Stmt insertCoords = insertCoordinates(inserters);
+
   // Code of loop body statement
   Stmt body = lower(stmt);
 
   // Code to append coordinates
   Stmt appendCoords = appendCoordinate(appenders, coordinate);
 
-  // TODO: Emit code to insert coordinates
-
   return Block::make(initVals,
                      declInserterPosVars,
+                     insertCoords,
                      declLocatorPosVars,
                      body,
                      appendCoords);
@@ -1279,49 +1887,162 @@ Stmt LowererImpl::lowerWhere(Where where) {
   // Declare and initialize the where statement's temporary
   Stmt initializeTemporary = Stmt();
   Stmt freeTemporary = Stmt();
+  Stmt freeTables = Stmt();
+  vector<Expr> temporaryDimensions;
+  map<pair<int,int>, Expr> temporaryIndexArrays;
   if (isScalar(temporary.getType())) {
     initializeTemporary = defineScalarVariable(temporary, true);
   }
   else {
-    if (generateComputeCode()) {
-      Expr values = ir::Var::make(temporary.getName(),
-                                  temporary.getType().getDataType(),
-                                  true, false);
-      taco_iassert(temporary.getType().getOrder() == 1) << " Temporary order was " << temporary.getType().getOrder();  // TODO
-      Dimension temporarySize = temporary.getType().getShape().getDimension(0);
-      Expr size;
+    // Workspaces are dense, or have a hashed last mode for sparse fibers
+    const vector<ModeFormat> modeFormats =
+        temporary.getFormat().getModeFormats();
+    const bool isHashed = (modeFormats.back().getName() == Hashed.getName());
+    taco_uassert(std::all_of(modeFormats.begin(), modeFormats.end() - 1,
+                     [](ModeFormat modeFormat) {
+                       return modeFormat.getName() == Dense.getName();
+                     }) && (isHashed ||
+                            modeFormats.back().getName() == Dense.getName()))
+        << "Workspaces must be dense, or dense with a hashed last mode, but "
+        << temporary.getName() << " has format " << temporary.getFormat();
+
+    // The index variables the producer accesses the temporary with, which
+    // determine the size of modes that are not given a size
+    vector<IndexVar> temporaryIndexVars;
+    Assignment temporaryAssignment;
+    match(where.getProducer(),
+          std::function<void(const AssignmentNode*, Matcher*)>([&](
+              const AssignmentNode* op, Matcher* ctx) {
+            if (op->lhs.getTensorVar() == temporary &&
+                temporaryIndexVars.empty()) {
+              temporaryIndexVars = op->lhs.getIndexVars();
+              temporaryAssignment = Assignment(op);
+            }
+            ctx->match(op->rhs);
+          }),
+          std::function<void(const AccessNode*)>([&](const AccessNode* op) {
+            if (op->tensorVar == temporary && temporaryIndexVars.empty()) {
+              temporaryIndexVars = op->indexVars;
+            }
+          })
+    );
+
+    Expr size = 1;
+    Expr numTables = 1;
+    for (int mode = 0; mode < temporary.getOrder(); mode++) {
+      Dimension temporarySize =
+          temporary.getType().getShape().getDimension(mode);
+      Expr dimension;
       if (temporarySize.isFixed()) {
-        size = ir::Literal::make(temporarySize.getSize());
+        dimension = ir::Literal::make((int)temporarySize.getSize());
       }
       else if (temporarySize.isIndexVarSized()) {
         IndexVar var = temporarySize.getIndexVarSize();
         vector<Expr> bounds = provGraph.deriveIterBounds(var, definedIndexVarsOrdered, underivedBounds, indexVarToExprMap, iterators);
-        size = ir::Sub::make(bounds[1], bounds[0]);
+        dimension = ir::Sub::make(bounds[1], bounds[0]);
       }
       else {
-        taco_ierror; // TODO
+        taco_iassert(mode < (int)temporaryIndexVars.size());
+        IndexVar var = temporaryIndexVars[mode];
+        taco_uassert(util::contains(dimensions, var)) <<
+            "The size of mode " << mode << " of " << temporary.getName() <<
+            " cannot be inferred from " << var;
+        dimension = getDimension(var);
+      }
+      temporaryDimensions.push_back(dimension);
+      if (mode < temporary.getOrder() - 1) {
+        numTables = simplify(ir::Mul::make(numTables, dimension));
+      }
+      size = simplify(ir::Mul::make(size, dimension));
+    }
+
+    Expr values = ir::Var::make(temporary.getName(),
+                                temporary.getType().getDataType(),
+                                true, false);
+
+    // The tables of a hashed last mode start small and grow, together with
+    // the values when they are computed, as the producer inserts coordinates
+    // into them.  Assembly needs the tables as well, to iterate the fibers.
+    Stmt initializeTables;
+    if (isHashed) {
+      taco_iassert(temporaryAssignment.defined());
+      Iterator tables = getIterators(temporaryAssignment.getLhs()).back();
+      const int level = temporary.getOrder();
+      const string arraysName = temporary.getName() + to_string(level);
+      Expr widthArray = Var::make(arraysName + "_width", Int(), true, false);
+      Expr crdArray = Var::make(arraysName + "_crd", Int(), true, false);
+      temporaryIndexArrays = {{{level - 1, 0}, widthArray},
+                              {{level - 1, 1}, crdArray}};
+
+      const auto hashed = std::dynamic_pointer_cast<const HashedModeFormat>(
+          modeFormats.back().impl);
+      taco_iassert(hashed != nullptr);
+      if (generateComputeCode()) {
+        Mode mode = tables.getMode();
+        mode.setValuesArray(values);
       }
+      size = ir::Mul::make(numTables, Load::make(widthArray, 0));
+      initializeTables = Block::make({
+          VarDecl::make(widthArray, ir::Literal::make(0)),
+          Allocate::make(widthArray, 1),
+          Store::make(widthArray, 0, hashed->getTableWidth(0)),
+          VarDecl::make(crdArray, ir::Literal::make(0)),
+          tables.getInsertInitLevel(numTables, size),
+          tables.getInsertInitCoords(0, size)});
+      freeTables = Block::make(tables.getInsertFinalizeLevel(numTables, size),
+                               Free::make(crdArray), Free::make(widthArray));
+      initializeTemporary = initializeTables;
+    }
+
+    if (generateComputeCode()) {
+      // Workspaces whose size does not change between iterations of CPU
+      // parallel loops, such as a size given by the dimensions of the
+      // operands, are allocated once per thread, before the outermost parallel
+      // loop, instead of once per iteration.  Hashed workspaces reallocate
+      // their values as they grow, so each iteration allocates its own.
+      const bool hoistAllocation = inParallelLoopDepth > 0 &&
+                                   !should_use_CUDA_codegen() &&
+                                   isLoopInvariant(size) && !isHashed;
 
       // no decl needed for shared memory
       Stmt decl = Stmt();
-      if((isa<Forall>(where.getProducer()) && inParallelLoopDepth == 0) || !should_use_CUDA_codegen()) {
-        decl = VarDecl::make(values, ir::Literal::make(0));
+      Stmt allocate = Stmt();
+      if (hoistAllocation) {
+        Expr threadValues = ir::Var::make(temporary.getName() + "_all",
+                                          temporary.getType().getDataType(),
+                                          true, false);
+        Expr numThreads = Call::make("taco_numThreads", {}, Int());
+        hoistedAllocations.push_back(Block::make(
+            VarDecl::make(threadValues, ir::Literal::make(0)),
+            Allocate::make(threadValues, ir::Mul::make(numThreads, size))));
+        hoistedFrees.push_back(Free::make(threadValues));
+        Expr threadNum = Call::make("taco_threadNum", {}, Int());
+        decl = VarDecl::make(values, ir::Add::make(threadValues,
+                                                   ir::Mul::make(threadNum,
+                                                                 size)));
+      }
+      else {
+        if((isa<Forall>(where.getProducer()) && inParallelLoopDepth == 0) || !should_use_CUDA_codegen()) {
+          decl = VarDecl::make(values, ir::Literal::make(0));
+        }
+        allocate = Allocate::make(values, size);
+        freeTemporary = Free::make(values);
       }
-      Stmt allocate = Allocate::make(values, size);
 
       Expr p = Var::make("p" + temporary.getName(), Int());
       Stmt zeroInit = Store::make(values, p, ir::Literal::zero(temporary.getType().getDataType()));
       Stmt zeroInitLoop = For::make(p, 0, size, 1, zeroInit, LoopKind::Serial);
 
-      freeTemporary = Free::make(values);
+      initializeTemporary = Block::make(initializeTables, decl, allocate,
+                                        zeroInitLoop);
+    }
 
-      /// Make a struct object that lowerAssignment and lowerAccess can read
-      /// temporary value arrays from.
+    /// Make a struct object that lowerAssignment and lowerAccess can read
+    /// temporary value arrays from.
+    if (generateComputeCode() || isHashed) {
       TemporaryArrays arrays;
       arrays.values = values;
       this->temporaryArrays.insert({temporary, arrays});
-
-      initializeTemporary = Block::make(decl, allocate, zeroInitLoop);
     }
   }
 
@@ -1354,7 +2075,13 @@ Stmt LowererImpl::lowerWhere(Where where) {
   whereConsumers.pop_back();
   whereTemps.pop_back();
   whereTempsToResult.erase(where.getTemporary());
-  return Block::make(initializeTemporary, producer, markAssignsAtomicDepth > 0 ? capturedLocatePos : ir::Stmt(), consumer, freeTemporary);
+  Stmt lowered = Block::make(initializeTemporary, producer, markAssignsAtomicDepth > 0 ? capturedLocatePos : ir::Stmt(), consumer, freeTemporary, freeTables);
+  if (!temporaryDimensions.empty()) {
+    lowered = replaceTemporaryProperties(lowered, getTensorVar(temporary),
+                                         temporaryDimensions,
+                                         temporaryIndexArrays);
+  }
+  return lowered;
 }
 
 
@@ -1384,6 +2111,10 @@ Expr LowererImpl::lowerAccess(Access access) {
     return getTensorVar(var);
   }
 
+  if (isPattern(var)) {
+    return ir::Literal::make(1);
+  }
+
   return getIterators(access).back().isUnique()
          ? Load::make(getValuesArray(var), generateValueLocExpr(access))
          : getReducedValueVar(access);
@@ -1424,6 +2155,7 @@ Expr LowererImpl::lowerLiteral(Literal literal) {
       return ir::Literal::make(literal.getVal<std::complex<float>>());
     case Datatype::Complex128:
       return ir::Literal::make(literal.getVal<std::complex<double>>());
+    case Datatype::Pattern:
     case Datatype::Undefined:
       taco_unreachable;
       break;
@@ -1514,6 +2246,16 @@ Expr LowererImpl::getCapacityVar(Expr tensor) const {
 }
 
 
+bool LowererImpl::isWorkspace(Expr tensor) const {
+  for (auto& temporary : temporaryArrays) {
+    if (getTensorVar(temporary.first) == tensor) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
 ir::Expr LowererImpl::getValuesArray(TensorVar var) const
 {
   return (util::contains(temporaryArrays, var))
@@ -1665,7 +2407,7 @@ Stmt LowererImpl::initResultArrays(vector<Access> writes,
       }
 
       // Pre-allocate memory for the value array if computing while assembling
-      if (generateComputeCode()) {
+      if (generateComputeCode() && !isPattern(write.getTensorVar())) {
         taco_iassert(!iterators.empty());
         
         Expr capacityVar = getCapacityVar(tensor);
@@ -1673,6 +2415,13 @@ Stmt LowererImpl::initResultArrays(vector<Access> writes,
                          ? DEFAULT_ALLOC_SIZE : parentSize;
         initArrays.push_back(VarDecl::make(capacityVar, allocSize));
         initArrays.push_back(Allocate::make(valuesArr, capacityVar));
+
+        // Let a last level that moves its coordinates while it is assembled
+        // move their values with them
+        if (iterators.back().hasInsert()) {
+          Mode mode = iterators.back().getMode();
+          mode.setValuesArray(valuesArr);
+        }
       }
 
       taco_iassert(!initArrays.empty());
@@ -1700,7 +2449,7 @@ Stmt LowererImpl::initResultArrays(vector<Access> writes,
     }
 
     if (generateComputeCode() && iterators.back().hasInsert() && 
-        !isValue(parentSize, 0) && 
+        !isValue(parentSize, 0) && !isPattern(write.getTensorVar()) &&
         (hasSparseInserts(iterators, readIterators) || 
          util::contains(reducedAccesses, write))) {
       // Zero-initialize values array if size statically known and might not 
@@ -1747,7 +2496,7 @@ ir::Stmt LowererImpl::finalizeResultArrays(std::vector<Access> writes) {
       parentSize = size;
     }
 
-    if (!generateComputeCode()) {
+    if (!generateComputeCode() && !isPattern(write.getTensorVar())) {
       // Allocate memory for values array after assembly if not also computing
       Expr tensor = getTensorVar(write.getTensorVar());
       Expr valuesArr = GetProperty::make(tensor, TensorProperty::Values);
@@ -1803,6 +2552,11 @@ Stmt LowererImpl::initResultArrays(IndexVar var, vector<Access> writes,
     Expr tensor = getTensorVar(write.getTensorVar());
     Expr values = GetProperty::make(tensor, TensorProperty::Values);
 
+    // Workspaces are initialized where they are declared
+    if (isWorkspace(tensor)) {
+      continue;
+    }
+
     vector<Iterator> iterators = getIteratorsFrom(var, getIterators(write));
 
     if (iterators.empty()) {
@@ -1844,7 +2598,8 @@ Stmt LowererImpl::initResultArrays(IndexVar var, vector<Access> writes,
         // Initialize data structures for storing edges of next append mode
         taco_iassert(initIterator.hasAppend());
         result.push_back(initIterator.getAppendInitEdges(initBegin, initEnd));
-      } else if (generateComputeCode() && !isTopLevel) {
+      } else if (generateComputeCode() && !isTopLevel &&
+                 !isPattern(write.getTensorVar())) {
         if (isa<ir::Mul>(stride)) {
           Expr strideVar = Var::make(util::toString(tensor) + "_stride", Int());
           result.push_back(VarDecl::make(strideVar, stride));
@@ -1883,14 +2638,14 @@ Stmt LowererImpl::resizeAndInitValues(const std::vector<Iterator>& appenders,
   std::vector<Stmt> result;
 
   for (auto& appender : appenders) {
-    if (!appender.isLeaf()) {
+    if (!appender.isLeaf() || appender.getTensor().type().isPattern()) {
       continue;
     }
 
     Expr tensor = appender.getTensor(); 
     Expr values = GetProperty::make(tensor, TensorProperty::Values);
     Expr capacity = getCapacityVar(appender.getTensor());
-    Expr pos = appender.getIteratorVar();
+    Expr pos = appender.getPosVar();
 
     if (generateAssembleCode()) {
       result.push_back(doubleSizeIfFull(values, capacity, pos));
@@ -1909,7 +2664,8 @@ Stmt LowererImpl::resizeAndInitValues(const std::vector<Iterator>& appenders,
 Stmt LowererImpl::zeroInitValues(Expr tensor, Expr begin, Expr size) {
   Expr lower = simplify(ir::Mul::make(begin, size));
   Expr upper = simplify(ir::Mul::make(ir::Add::make(begin, 1), size));
-  Expr p = Var::make("p" + util::toString(tensor), Int());
+  Expr p = Var::make("p" + util::toString(tensor),
+                     max_type(lower.type(), upper.type()));
   Expr values = GetProperty::make(tensor, TensorProperty::Values);
   Stmt zeroInit = Store::make(values, p, ir::Literal::zero(tensor.type()));
   LoopKind parallel = (isa<ir::Literal>(size) && 
@@ -1939,8 +2695,8 @@ Stmt LowererImpl::declLocatePosVars(vector<Iterator> locators) {
 
     if (doLocate) {
       Iterator locateIterator = locator;
-      if (locateIterator.hasPosIter()) {
-        taco_iassert(!provGraph.isUnderived(locateIterator.getIndexVar()));
+      if (locateIterator.hasPosIter() &&
+          !provGraph.isUnderived(locateIterator.getIndexVar())) {
         continue; // these will be recovered with separate procedure
       }
       do {
@@ -1948,6 +2704,9 @@ Stmt LowererImpl::declLocatePosVars(vector<Iterator> locators) {
         taco_iassert(isValue(locate.getResults()[1], true));
         Stmt declarePosVar = VarDecl::make(locateIterator.getPosVar(),
                                            locate.getResults()[0]);
+        if (locate.compute().defined()) {
+          result.push_back(locate.compute());
+        }
         result.push_back(declarePosVar);
 
         if (locateIterator.isLeaf()) {
@@ -1972,7 +2731,8 @@ Stmt LowererImpl::reduceDuplicateCoordinates(Expr coordinate,
     Access access = this->iterators.modeAccess(iterator).getAccess();
     Expr iterVar = iterator.getIteratorVar();
     Expr segendVar = iterator.getSegendVar();
-    Expr reducedVal = iterator.isLeaf() ? getReducedValueVar(access) : Expr();
+    Expr reducedVal = (iterator.isLeaf() && !isPattern(access.getTensorVar()))
+                      ? getReducedValueVar(access) : Expr();
     Expr tensorVar = getTensorVar(access.getTensorVar());
     Expr tensorVals = GetProperty::make(tensorVar, TensorProperty::Values);
 
@@ -2074,10 +2834,10 @@ Stmt LowererImpl::codeToInitializeIteratorVar(Iterator iterator, vector<Iterator
     }
   }
   else if (iterator.hasCoordIter()) {
-    // E.g. a hasmap mode
-    vector<Expr> coords = coordinates(iterator);
-    coords.erase(coords.begin());
-    ModeFunction bounds = iterator.coordBounds(coords);
+    // E.g. a bitmap mode
+    vector<Expr> parentCoords = coordinates(iterator);
+    parentCoords.pop_back();
+    ModeFunction bounds = iterator.coordBounds(parentCoords);
     result.push_back(bounds.compute());
     result.push_back(VarDecl::make(iterVar, bounds[0]));
     result.push_back(VarDecl::make(endVar, bounds[1]));
@@ -2206,6 +2966,27 @@ Stmt LowererImpl::codeToIncIteratorVars(Expr coordinate, IndexVar coordinateVar,
   return Block::make(result);
 }
 
+ModeFunction LowererImpl::coordIterAccess(Iterator iterator) const {
+  taco_iassert(iterator.hasCoordIter());
+  vector<Expr> coords = coordinates(iterator);
+  coords.back() = iterator.getCoordVar();
+  return iterator.coordAccess(coords);
+}
+
+Stmt LowererImpl::codeToAccessCoordIterators(vector<Iterator> iterators) {
+  vector<Stmt> result;
+  auto coordIters = filter(iterators, [](Iterator it){return it.hasCoordIter();});
+  for (auto& coordIter : coordIters) {
+    ModeFunction coordAccess = coordIterAccess(coordIter);
+    result.push_back(coordAccess.compute());
+    result.push_back(VarDecl::make(coordIter.getPosVar(), coordAccess[0]));
+    if (!isValue(coordAccess[1], true)) {
+      result.push_back(VarDecl::make(coordIter.getValidVar(), coordAccess[1]));
+    }
+  }
+  return result.empty() ? Stmt() : Block::make(result);
+}
+
 Stmt LowererImpl::codeToLoadCoordinatesFromPosIterators(vector<Iterator> iterators, bool declVars) {
   // Load coordinates from position iterators
   Stmt loadPosIterCoordinates;
@@ -2245,6 +3026,22 @@ bool isLastAppender(Iterator iter) {
 }
 
 
+Stmt LowererImpl::insertCoordinates(vector<Iterator> inserters) {
+  vector<Stmt> result;
+  for (auto& inserter : inserters) {
+    // Workspaces are assembled while they are computed
+    if (!generateAssembleCode() && !isWorkspace(inserter.getTensor())) {
+      continue;
+    }
+    Stmt insertCoord = inserter.getInsertCoord(inserter.getPosVar(),
+                                               coordinates(inserter));
+    if (insertCoord.defined()) {
+      result.push_back(insertCoord);
+    }
+  }
+  return result.empty() ? Stmt() : Block::make(result);
+}
+
 Stmt LowererImpl::appendCoordinate(vector<Iterator> appenders, Expr coord) {
   vector<Stmt> result;
   for (auto& appender : appenders) {
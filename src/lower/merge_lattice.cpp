@@ -324,11 +324,14 @@ private:
   }
 
   void visit(const SequenceNode* node) {
-    taco_not_supported_yet;
+    // The definition and the mutation share the loop, so it must iterate over
+    // the union of their iteration spaces.  The zero rewrite of each case then
+    // removes whichever statement has nothing to compute there.
+    lattice = unionLattices(build(node->definition), build(node->mutation));
   }
 
   void visit(const SuchThatNode* node) {
-    taco_not_supported_yet;
+    lattice = build(node->stmt);
   }
 
   /**
@@ -426,7 +429,8 @@ private:
     // Remove duplicate iterators.
     iterators = deduplicateDimensionIterators(iterators);
 
-    vector<Iterator> results = combine(left.results(),   right.results());
+    vector<Iterator> results = deduplicateResults(combine(left.results(),
+                                                          right.results()));
 
     return MergePoint(iterators, locators, results);
   }
@@ -445,6 +449,7 @@ private:
 
     // Remove duplicate iterators.
     iterators = deduplicateDimensionIterators(iterators);
+    results = deduplicateResults(results);
 
     return MergePoint(iterators, locaters, results);
   }
@@ -587,6 +592,19 @@ private:
     }
     return deduplicates;
   }
+
+  static vector<Iterator>
+  deduplicateResults(const vector<Iterator>& results)
+  {
+    // Statements of a sequence may write the same result
+    vector<Iterator> deduplicates;
+    for (auto& result : results) {
+      if (!util::contains(deduplicates, result)) {
+        deduplicates.push_back(result);
+      }
+    }
+    return deduplicates;
+  }
 };
 
 
@@ -22,6 +22,8 @@ struct Mode::Content {
 
   ModeFormat parentModeFormat;  /// type of previous mode in the tensor
 
+  ir::Expr   values;            /// values indexed by the mode's positions
+
   std::map<std::string, ir::Expr> vars;
 };
 
@@ -87,6 +89,14 @@ void Mode::addVar(std::string varName, ir::Expr var) {
   content->vars[varName] = var;
 }
 
+ir::Expr Mode::getValuesArray() const {
+  return content->values;
+}
+
+void Mode::setValuesArray(ir::Expr values) {
+  content->values = values;
+}
+
 bool Mode::defined() const {
   return content != nullptr;
 }
@@ -100,6 +110,7 @@ std::ostream& operator<<(std::ostream& os, const Mode& mode) {
 struct ModePack::Content {
   size_t numModes = 0;
   vector<ir::Expr> arrays;
+  Datatype posType = Int();
 };
 
 ModePack::ModePack() : content(new Content) {
@@ -111,6 +122,22 @@ ModePack::ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor,
   content->arrays = modeType.impl->getArrays(tensor, mode, level);
 }
 
+ModePack::ModePack(size_t numModes, ModeFormat modeType, ir::Expr tensor,
+                   int mode, int level, const vector<Datatype>& arrayTypes,
+                   Datatype posType)
+    : ModePack(numModes, modeType, tensor, mode, level) {
+  content->posType = posType;
+  for (size_t i = 0; i < content->arrays.size() && i < arrayTypes.size(); ++i) {
+    const ir::GetProperty* array = content->arrays[i].as<ir::GetProperty>();
+    if (array != nullptr && array->property == ir::TensorProperty::Indices) {
+      content->arrays[i] = ir::GetProperty::make(array->tensor,
+                                                 array->property, array->mode,
+                                                 array->index, array->name,
+                                                 arrayTypes[i]);
+    }
+  }
+}
+
 size_t ModePack::getNumModes() const {
   return content->numModes;
 }
@@ -119,4 +146,8 @@ ir::Expr ModePack::getArray(size_t i) const {
   return content->arrays[i];
 }
 
+Datatype ModePack::getPosType() const {
+  return content->posType;
+}
+
 }
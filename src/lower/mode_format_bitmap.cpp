@@ -0,0 +1,167 @@
+#include "taco/lower/mode_format_bitmap.h"
+
+#include "ir/ir_generators.h"
+#include "taco/ir/simplify.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+BitmapModeFormat::BitmapModeFormat() : BitmapModeFormat(true, true) {
+}
+
+BitmapModeFormat::BitmapModeFormat(bool isOrdered, bool isUnique) :
+    ModeFormatImpl("bitmap", false, isOrdered, isUnique, false, false, true,
+                   false, true, true, false, false, true) {
+}
+
+ModeFormat BitmapModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isOrdered = this->isOrdered;
+  bool isUnique = this->isUnique;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::ORDERED:
+        isOrdered = true;
+        break;
+      case ModeFormat::NOT_ORDERED:
+        isOrdered = false;
+        break;
+      case ModeFormat::UNIQUE:
+        isUnique = true;
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        isUnique = false;
+        break;
+      default:
+        break;
+    }
+  }
+  return ModeFormat(std::make_shared<BitmapModeFormat>(isOrdered, isUnique));
+}
+
+ModeFunction BitmapModeFormat::coordIterBounds(vector<Expr> parentCoords,
+                                               Mode mode) const {
+  return ModeFunction(Stmt(), {0, getWidth(mode)});
+}
+
+ModeFunction BitmapModeFormat::coordIterAccess(Expr parentPos,
+                                               std::vector<Expr> coords,
+                                               Mode mode) const {
+  Expr pos = Add::make(Mul::make(parentPos, getWidth(mode)), coords.back());
+  Expr isSet = Call::make("taco_bitmapTest",
+                          {getBitmapArray(mode.getModePack()), pos}, Bool);
+  return ModeFunction(Stmt(), {pos, isSet});
+}
+
+ModeFunction BitmapModeFormat::coordBounds(Expr parentPos, Mode mode) const {
+  return ModeFunction(Stmt(), {0, getWidth(mode)});
+}
+
+ModeFunction BitmapModeFormat::wordIterBounds(Expr parentPos, Mode mode) const {
+  Expr numWords = Div::make(Add::make(getWidth(mode), 63), 64);
+  return ModeFunction(Stmt(), {0, numWords});
+}
+
+ModeFunction BitmapModeFormat::wordIterAccess(Expr parentPos, Expr word,
+                                              Mode mode) const {
+  // Fibers need not start at a word boundary, so the bits of a word of the
+  // fiber may straddle two words of the bitmap
+  Expr coord = Mul::make(word, 64);
+  Expr pos = Add::make(Mul::make(parentPos, getWidth(mode)), coord);
+  Expr numBits = Min::make(64, Sub::make(getWidth(mode), coord));
+  Expr bits = Call::make("taco_bitmapBits",
+                         {getBitmapArray(mode.getModePack()), pos, numBits},
+                         UInt64);
+  return ModeFunction(Stmt(), {bits});
+}
+
+ModeFunction BitmapModeFormat::locate(Expr parentPos,
+                                      std::vector<Expr> coords,
+                                      Mode mode) const {
+  // Unset positions hold zero, so every coordinate can be located
+  Expr pos = Add::make(Mul::make(parentPos, getWidth(mode)), coords.back());
+  return ModeFunction(Stmt(), {pos, true});
+}
+
+Stmt BitmapModeFormat::getInsertCoord(Expr p, const std::vector<Expr>& i,
+                                      Mode mode) const {
+  Expr bitmapArray = getBitmapArray(mode.getModePack());
+  Expr word = Call::make("taco_bitmapWord", {p}, Int());
+  Expr mask = Call::make("taco_bitmapMask", {p}, UInt64);
+  return Store::make(bitmapArray, word,
+                     BitOr::make(Load::make(bitmapArray, word), mask));
+}
+
+Expr BitmapModeFormat::getWidth(Mode mode) const {
+  return getSizeArray(mode.getModePack());
+}
+
+Stmt BitmapModeFormat::getInsertInitCoords(Expr pBegin, Expr pEnd,
+                                           Mode mode) const {
+  Expr bitmapArray = getBitmapArray(mode.getModePack());
+  Expr wordBegin = simplify(Div::make(Add::make(pBegin, 63), 64));
+  Expr wordEnd = simplify(Div::make(Add::make(pEnd, 63), 64));
+  Stmt maybeResizeBitmap = atLeastDoubleSizeIfFull(bitmapArray,
+      getBitmapCapacity(mode), simplify(Sub::make(wordEnd, 1)));
+
+  // Fibers are initialized in order, so the word holding the first bits of
+  // this fiber, if it also holds bits of the previous one, is already clear
+  Expr wVar = Var::make("w" + mode.getName(), Int());
+  Stmt clearWords = For::make(wVar, wordBegin, wordEnd, 1,
+                              Store::make(bitmapArray, wVar,
+                                          Literal::zero(UInt64)));
+  return Block::make({maybeResizeBitmap, clearWords});
+}
+
+Stmt BitmapModeFormat::getInsertInitLevel(Expr szPrev, Expr sz,
+                                          Mode mode) const {
+  const bool szIsZero = isa<Literal>(sz) && to<Literal>(sz)->equalsScalar(0);
+  Expr bitmapCapacity = getBitmapCapacity(mode);
+  Expr initCapacity = szIsZero ? Literal::make(DEFAULT_ALLOC_SIZE)
+                               : simplify(Div::make(Add::make(sz, 63), 64));
+  return Block::make({VarDecl::make(bitmapCapacity, initCapacity),
+                      Allocate::make(getBitmapArray(mode.getModePack()),
+                                     bitmapCapacity)});
+}
+
+Stmt BitmapModeFormat::getInsertFinalizeLevel(Expr szPrev, Expr sz,
+                                              Mode mode) const {
+  return Stmt();
+}
+
+vector<Expr> BitmapModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Dimension, mode),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_bitmap")};
+}
+
+size_t BitmapModeFormat::getNumWords(size_t size) {
+  return (size + 63) / 64;
+}
+
+Expr BitmapModeFormat::getSizeArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr BitmapModeFormat::getBitmapArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr BitmapModeFormat::getBitmapCapacity(Mode mode) const {
+  const std::string varName = mode.getName() + "_bitmap_size";
+
+  if (!mode.hasVar(varName)) {
+    Expr bitmapCapacity = Var::make(varName, Int());
+    mode.addVar(varName, bitmapCapacity);
+    return bitmapCapacity;
+  }
+
+  return mode.getVar(varName);
+}
+
+}
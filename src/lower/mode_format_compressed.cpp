@@ -15,8 +15,19 @@ CompressedModeFormat::CompressedModeFormat() :
 
 CompressedModeFormat::CompressedModeFormat(bool isFull, bool isOrdered,
                                        bool isUnique, long long allocSize) :
-    ModeFormatImpl("compressed", isFull, isOrdered, isUnique, false, true,
-                   false, true, false, false, true), 
+    CompressedModeFormat("compressed", isFull, isOrdered, isUnique, false,
+                         true, false, allocSize) {
+}
+
+CompressedModeFormat::CompressedModeFormat(std::string name, bool isFull,
+                                           bool isOrdered, bool isUnique,
+                                           bool hasCoordValIter,
+                                           bool hasCoordPosIter,
+                                           bool hasRunIter,
+                                           long long allocSize) :
+    ModeFormatImpl(name, isFull, isOrdered, isUnique, false, true,
+                   hasCoordValIter, hasCoordPosIter, false, false, true,
+                   hasRunIter),
     allocSize(allocSize) {
 }
 
@@ -123,7 +134,8 @@ Stmt CompressedModeFormat::getAppendInitEdges(Expr pPrevBegin,
     return doubleSizeIfFull(posArray, posCapacity, pPrevEnd);
   }
 
-  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Expr pVar = Var::make("p" + mode.getName(),
+                        mode.getModePack().getPosType());
   Expr lb = Add::make(pPrevBegin, 1);
   Expr ub = Add::make(pPrevEnd, 1);
   Stmt initPos = For::make(pVar, lb, ub, 1, Store::make(posArray, pVar, 0));
@@ -151,7 +163,8 @@ Stmt CompressedModeFormat::getAppendInitLevel(Expr szPrev, Expr sz,
 
   if (mode.getParentModeType().defined() &&
       !mode.getParentModeType().hasAppend() && !szPrevIsZero) {
-    Expr pVar = Var::make("p" + mode.getName(), Int());
+    Expr pVar = Var::make("p" + mode.getName(),
+                        mode.getModePack().getPosType());
     Stmt storePos = Store::make(posArray, pVar, 0);
     initStmts.push_back(For::make(pVar, 1, initCapacity, 1, storePos));
   }
@@ -174,10 +187,12 @@ Stmt CompressedModeFormat::getAppendFinalizeLevel(Expr szPrev,
     return Stmt();
   }
 
-  Expr csVar = Var::make("cs" + mode.getName(), Int());
+  Expr csVar = Var::make("cs" + mode.getName(),
+                         mode.getModePack().getPosType());
   Stmt initCs = VarDecl::make(csVar, 0);
   
-  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Expr pVar = Var::make("p" + mode.getName(),
+                        mode.getModePack().getPosType());
   Expr loadPos = Load::make(getPosArray(mode.getModePack()), pVar);
   Stmt incCs = Assign::make(csVar, Add::make(csVar, loadPos));
   Stmt updatePos = Store::make(getPosArray(mode.getModePack()), pVar, csVar);
@@ -208,7 +223,7 @@ Expr CompressedModeFormat::getPosCapacity(Mode mode) const {
   const std::string varName = mode.getName() + "_pos_size";
  
   if (!mode.hasVar(varName)) {
-    Expr posCapacity = Var::make(varName, Int());
+    Expr posCapacity = Var::make(varName, mode.getModePack().getPosType());
     mode.addVar(varName, posCapacity);
     return posCapacity;
   }
@@ -220,7 +235,7 @@ Expr CompressedModeFormat::getCoordCapacity(Mode mode) const {
   const std::string varName = mode.getName() + "_crd_size";
   
   if (!mode.hasVar(varName)) {
-    Expr idxCapacity = Var::make(varName, Int());
+    Expr idxCapacity = Var::make(varName, mode.getModePack().getPosType());
     mode.addVar(varName, idxCapacity);
     return idxCapacity;
   }
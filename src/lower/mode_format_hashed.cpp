@@ -0,0 +1,341 @@
+#include "taco/lower/mode_format_hashed.h"
+
+#include "ir/ir_generators.h"
+#include "taco/ir/simplify.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+/// Returns the home slot of `coord` in a table of `width` slots.  The
+/// coordinate is scrambled by a multiplicative (Fibonacci) hash whose high bits
+/// then pick the slot, so that strided coordinates don't all collide.
+static Expr homeSlot(Expr coord, Expr width) {
+  Expr goldenRatio = Cast::make(Literal::make(2654435769u, UInt32), UInt32);
+  Expr hash = Mul::make(Cast::make(coord, UInt32), goldenRatio, UInt32);
+  Expr scaled = Mul::make(Cast::make(hash, UInt64), Cast::make(width, UInt64),
+                          UInt64);
+  return Cast::make(Div::make(scaled, Literal::make((uint64_t)1 << 32, UInt64),
+                              UInt64), Int());
+}
+
+/// Probes linearly from the home slot of `coord` in the table of `width` slots
+/// that starts at `base`, until `slot` holds `coord` or is empty.  Every slot
+/// is probed at most once, so probing always terminates.
+static Stmt probe(Expr crd, Expr base, Expr width, Expr coord, Expr slot,
+                  Expr probes) {
+  Expr mask = Sub::make(width, 1);
+  Expr slotCoord = Load::make(crd, Add::make(base, slot));
+  Expr isOtherCoord = And::make(Gte::make(slotCoord, 0),
+                                Neq::make(slotCoord, coord));
+  Expr hasUnprobedSlots = Lt::make(probes, mask);
+  Stmt nextSlot = Block::make(
+      Assign::make(slot, BitAnd::make(Add::make(slot, 1), mask)),
+      Assign::make(probes, Add::make(probes, 1)));
+  return Block::make(VarDecl::make(slot, homeSlot(coord, width)),
+                     VarDecl::make(probes, 0),
+                     While::make(And::make(isOtherCoord, hasUnprobedSlots),
+                                 nextSlot));
+}
+
+HashedModeFormat::HashedModeFormat(int width) :
+    HashedModeFormat(false, true, width) {
+}
+
+HashedModeFormat::HashedModeFormat(bool isOrdered, bool isUnique, int width) :
+    ModeFormatImpl("hashed", false, isOrdered, isUnique, false, false, false,
+                   true, true, true, false),
+    width(width) {
+  taco_uassert(width >= 0) << "Hash table widths cannot be negative";
+}
+
+ModeFormat HashedModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  bool isOrdered = this->isOrdered;
+  bool isUnique = this->isUnique;
+  for (const auto property : properties) {
+    switch (property) {
+      case ModeFormat::ORDERED:
+        isOrdered = true;
+        break;
+      case ModeFormat::NOT_ORDERED:
+        isOrdered = false;
+        break;
+      case ModeFormat::UNIQUE:
+        isUnique = true;
+        break;
+      case ModeFormat::NOT_UNIQUE:
+        isUnique = false;
+        break;
+      default:
+        break;
+    }
+  }
+  const auto hashedVariant =
+      std::make_shared<HashedModeFormat>(isOrdered, isUnique, width);
+  return ModeFormat(hashedVariant);
+}
+
+ModeFunction HashedModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  Expr tableWidth = getWidth(mode);
+  Expr pbegin = Mul::make(parentPos, tableWidth);
+  Expr pend = Mul::make(Add::make(parentPos, 1), tableWidth);
+  return ModeFunction(Stmt(), {pbegin, pend});
+}
+
+ModeFunction HashedModeFormat::posIterAccess(Expr pos,
+                                             std::vector<Expr> coords,
+                                             Mode mode) const {
+  // Empty slots hold coordinate -1
+  Expr idx = Load::make(getCoordArray(mode.getModePack()), pos);
+  return ModeFunction(Stmt(), {idx, Gte::make(idx, 0)});
+}
+
+ModeFunction HashedModeFormat::locate(Expr parentPos,
+                                      std::vector<Expr> coords,
+                                      Mode mode) const {
+  // A missing coordinate is located at the empty slot that ends its probe,
+  // whose value is zero and where it is inserted
+  Expr base = Mul::make(parentPos, getWidth(mode));
+  Expr slot = Var::make(mode.getName() + "_slot", Int());
+  Expr probes = Var::make(mode.getName() + "_probes", Int());
+  Stmt probeSlot = probe(getCoordArray(mode.getModePack()), base,
+                         getWidth(mode), coords.back(), slot, probes);
+  return ModeFunction(probeSlot, {Add::make(base, slot), true});
+}
+
+Stmt HashedModeFormat::getInsertCoord(Expr p, const std::vector<Expr>& i,
+                                      Mode mode) const {
+  taco_iassert(isa<Var>(p));
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr fillArray = getFillArray(mode);
+  Expr tableWidth = getWidth(mode);
+  Expr coord = i.back();
+
+  // Count the coordinates of the table the first time a coordinate is stored
+  Expr table = Var::make(mode.getName() + "_table", Int());
+  Stmt declTable = VarDecl::make(table, Div::make(p, tableWidth));
+  Expr fill = Load::make(fillArray, table);
+  Stmt countCoord = Store::make(fillArray, table, Add::make(fill, 1));
+
+  // Keep every table at most half full, so that probes stay short and every
+  // table keeps empty slots, by doubling the width of the level's tables and
+  // rehashing their coordinates when a table grows past half its width
+  Stmt growTables = IfThenElse::make(Gt::make(Mul::make(2, fill), tableWidth),
+                                     getGrowTables(p, coord, table, mode));
+
+  Stmt insertCoord = Block::make(Store::make(crdArray, p, coord), declTable,
+                                 countCoord, growTables);
+  return IfThenElse::make(Lt::make(Load::make(crdArray, p), 0), insertCoord);
+}
+
+Expr HashedModeFormat::getWidth(Mode mode) const {
+  return Load::make(getWidthArray(mode.getModePack()), 0);
+}
+
+Stmt HashedModeFormat::getInsertInitCoords(Expr pBegin, Expr pEnd,
+                                           Mode mode) const {
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Stmt maybeResizeIdx = atLeastDoubleSizeIfFull(crdArray,
+                                                getCoordCapacity(mode),
+                                                simplify(Sub::make(pEnd, 1)));
+
+  Expr pVar = Var::make("p" + mode.getName(), Int());
+  Stmt clearSlots = For::make(pVar, pBegin, pEnd, 1,
+                              Store::make(crdArray, pVar, -1));
+
+  // Tables start out empty
+  Expr tableWidth = getWidth(mode);
+  Expr tablesBegin = Div::make(pBegin, tableWidth);
+  Expr tablesEnd = Div::make(pEnd, tableWidth);
+  Expr fillArray = getFillArray(mode);
+  Stmt maybeResizeFill = atLeastDoubleSizeIfFull(fillArray,
+                                                 getFillCapacity(mode),
+                                                 Sub::make(tablesEnd, 1));
+  Expr tVar = Var::make("t" + mode.getName(), Int());
+  Stmt clearFill = For::make(tVar, tablesBegin, tablesEnd, 1,
+                             Store::make(fillArray, tVar, 0));
+  Expr numTables = getNumTables(mode);
+  Stmt updateNumTables = Assign::make(numTables,
+                                      Max::make(numTables, tablesEnd));
+  return Block::make({maybeResizeIdx, clearSlots, maybeResizeFill, clearFill,
+                      updateNumTables});
+}
+
+Stmt HashedModeFormat::getInsertInitLevel(Expr szPrev, Expr sz,
+                                          Mode mode) const {
+  Expr crdCapacity = getCoordCapacity(mode);
+  Expr fillCapacity = getFillCapacity(mode);
+  Expr initCapacity = isValue(sz, 0) ? DEFAULT_ALLOC_SIZE : sz;
+  Expr initFillCapacity = isValue(szPrev, 0) ? DEFAULT_ALLOC_SIZE : szPrev;
+  return Block::make({VarDecl::make(crdCapacity, initCapacity),
+                      Allocate::make(getCoordArray(mode.getModePack()),
+                                     crdCapacity),
+                      VarDecl::make(getNumTables(mode), 0),
+                      VarDecl::make(fillCapacity, initFillCapacity),
+                      VarDecl::make(getFillArray(mode), 0),
+                      Allocate::make(getFillArray(mode), fillCapacity)});
+}
+
+Stmt HashedModeFormat::getInsertFinalizeLevel(Expr szPrev, Expr sz,
+                                              Mode mode) const {
+  return Free::make(getFillArray(mode));
+}
+
+vector<Expr> HashedModeFormat::getArrays(Expr tensor, int mode,
+                                         int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_width"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_crd")};
+}
+
+int HashedModeFormat::getTableWidth(int numCoordinates) const {
+  const int minWidth = std::max(std::max(width, 2 * numCoordinates), 1);
+  int tableWidth = 1;
+  while (tableWidth < minWidth) {
+    tableWidth *= 2;
+  }
+  return tableWidth;
+}
+
+Stmt HashedModeFormat::getGrowTables(Expr p, Expr coord, Expr table,
+                                     Mode mode) const {
+  const std::string name = mode.getName();
+  Expr crdArray = getCoordArray(mode.getModePack());
+  Expr valuesArray = mode.getValuesArray();
+  Expr numTables = getNumTables(mode);
+
+  Expr oldWidth = Var::make(name + "_old_width", Int());
+  Expr newWidth = Var::make(name + "_new_width", Int());
+  Expr newSize = Var::make(name + "_new_size", Int());
+  vector<Stmt> result = {
+    VarDecl::make(oldWidth, getWidth(mode)),
+    VarDecl::make(newWidth, Mul::make(oldWidth, 2)),
+    VarDecl::make(newSize, Mul::make(numTables, newWidth))
+  };
+
+  // Allocate empty tables of twice the width
+  Expr newCrdArray = Var::make(name + "_new_crd", Int(), true);
+  Expr newValuesArray;
+  Expr q = Var::make("q" + name, Int());
+  vector<Stmt> clearSlot = {Store::make(newCrdArray, q, -1)};
+  result.push_back(VarDecl::make(newCrdArray, 0));
+  result.push_back(Allocate::make(newCrdArray, newSize));
+  if (valuesArray.defined()) {
+    newValuesArray = Var::make(name + "_new_vals", valuesArray.type(), true);
+    result.push_back(VarDecl::make(newValuesArray, 0));
+    result.push_back(Allocate::make(newValuesArray, newSize));
+    clearSlot.push_back(Store::make(newValuesArray, q,
+                                    ir::Literal::zero(valuesArray.type())));
+  }
+  result.push_back(For::make(q, 0, newSize, 1, Block::make(clearSlot)));
+
+  // Rehash the coordinates, and their values, of every table
+  Expr oldCoord = Var::make(name + "_old_crd", Int());
+  Expr base = Var::make(name + "_new_base", Int());
+  Expr slot = Var::make(name + "_new_slot", Int());
+  Expr probes = Var::make(name + "_new_probes", Int());
+  Expr newPos = Add::make(base, slot);
+  vector<Stmt> rehashCoord = {
+    VarDecl::make(base, Mul::make(Div::make(q, oldWidth), newWidth)),
+    probe(newCrdArray, base, newWidth, oldCoord, slot, probes),
+    Store::make(newCrdArray, newPos, oldCoord)
+  };
+  if (valuesArray.defined()) {
+    rehashCoord.push_back(Store::make(newValuesArray, newPos,
+                                      Load::make(valuesArray, q)));
+  }
+  Stmt rehashSlot = Block::make(
+      VarDecl::make(oldCoord, Load::make(crdArray, q)),
+      IfThenElse::make(Gte::make(oldCoord, 0), Block::make(rehashCoord)));
+  result.push_back(For::make(q, 0, Mul::make(numTables, oldWidth), 1,
+                             rehashSlot));
+
+  // Replace the tables
+  result.push_back(Free::make(crdArray));
+  result.push_back(Assign::make(crdArray, newCrdArray));
+  result.push_back(Assign::make(getCoordCapacity(mode), newSize));
+  if (valuesArray.defined()) {
+    result.push_back(Free::make(valuesArray));
+    result.push_back(Assign::make(valuesArray, newValuesArray));
+  }
+  result.push_back(Store::make(getWidthArray(mode.getModePack()), 0,
+                               newWidth));
+
+  // Relocate the inserted coordinate
+  Expr tableBase = Var::make(name + "_table_base", Int());
+  Expr tableSlot = Var::make(name + "_table_slot", Int());
+  Expr tableProbes = Var::make(name + "_table_probes", Int());
+  result.push_back(VarDecl::make(tableBase, Mul::make(table, newWidth)));
+  result.push_back(probe(crdArray, tableBase, newWidth, coord, tableSlot,
+                         tableProbes));
+  result.push_back(Assign::make(p, Add::make(tableBase, tableSlot)));
+  return Block::make(result);
+}
+
+Expr HashedModeFormat::getWidthArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr HashedModeFormat::getCoordArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr HashedModeFormat::getCoordCapacity(Mode mode) const {
+  const std::string varName = mode.getName() + "_crd_size";
+
+  if (!mode.hasVar(varName)) {
+    Expr idxCapacity = Var::make(varName, Int());
+    mode.addVar(varName, idxCapacity);
+    return idxCapacity;
+  }
+
+  return mode.getVar(varName);
+}
+
+Expr HashedModeFormat::getFillArray(Mode mode) const {
+  const std::string varName = mode.getName() + "_fill";
+
+  if (!mode.hasVar(varName)) {
+    Expr fillArray = Var::make(varName, Int(), true);
+    mode.addVar(varName, fillArray);
+    return fillArray;
+  }
+
+  return mode.getVar(varName);
+}
+
+Expr HashedModeFormat::getFillCapacity(Mode mode) const {
+  const std::string varName = mode.getName() + "_fill_size";
+
+  if (!mode.hasVar(varName)) {
+    Expr fillCapacity = Var::make(varName, Int());
+    mode.addVar(varName, fillCapacity);
+    return fillCapacity;
+  }
+
+  return mode.getVar(varName);
+}
+
+Expr HashedModeFormat::getNumTables(Mode mode) const {
+  const std::string varName = mode.getName() + "_tables";
+
+  if (!mode.hasVar(varName)) {
+    Expr numTables = Var::make(varName, Int());
+    mode.addVar(varName, numTables);
+    return numTables;
+  }
+
+  return mode.getVar(varName);
+}
+
+bool HashedModeFormat::equals(const ModeFormatImpl& other) const {
+  return ModeFormatImpl::equals(other) &&
+         (dynamic_cast<const HashedModeFormat&>(other).width == width);
+}
+
+}
@@ -58,11 +58,13 @@ ModeFormatImpl::ModeFormatImpl(const std::string name, bool isFull,
                                bool isOrdered, bool isUnique, bool isBranchless, 
                                bool isCompact, bool hasCoordValIter, 
                                bool hasCoordPosIter, bool hasLocate, 
-                               bool hasInsert, bool hasAppend) :
+                               bool hasInsert, bool hasAppend,
+                               bool hasRunIter, bool hasWordIter) :
     name(name), isFull(isFull), isOrdered(isOrdered), isUnique(isUnique),
     isBranchless(isBranchless), isCompact(isCompact),
     hasCoordValIter(hasCoordValIter), hasCoordPosIter(hasCoordPosIter),
-    hasLocate(hasLocate), hasInsert(hasInsert), hasAppend(hasAppend) {
+    hasLocate(hasLocate), hasInsert(hasInsert), hasAppend(hasAppend),
+    hasRunIter(hasRunIter), hasWordIter(hasWordIter) {
 }
 
 ModeFormatImpl::~ModeFormatImpl() {
@@ -95,6 +97,25 @@ ModeFunction ModeFormatImpl::posIterAccess(ir::Expr pos,
   return ModeFunction();
 }
 
+ModeFunction ModeFormatImpl::runIterBounds(ir::Expr parentPos,
+                                           Mode mode) const {
+  return ModeFunction();
+}
+
+ModeFunction ModeFormatImpl::runIterAccess(ir::Expr pos, Mode mode) const {
+  return ModeFunction();
+}
+
+ModeFunction ModeFormatImpl::wordIterBounds(ir::Expr parentPos,
+                                            Mode mode) const {
+  return ModeFunction();
+}
+
+ModeFunction ModeFormatImpl::wordIterAccess(ir::Expr parentPos, ir::Expr word,
+                                            Mode mode) const {
+  return ModeFunction();
+}
+
 ModeFunction ModeFormatImpl::locate(ir::Expr parentPos,
                                   std::vector<ir::Expr> coords,
                                   Mode mode) const {
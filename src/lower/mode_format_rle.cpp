@@ -0,0 +1,96 @@
+#include "taco/lower/mode_format_rle.h"
+
+#include "ir/ir_generators.h"
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+RunLengthModeFormat::RunLengthModeFormat(long long allocSize) :
+    CompressedModeFormat("rle", false, true, true, true, false, true,
+                         allocSize) {
+}
+
+ModeFormat RunLengthModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  for (const auto property : properties) {
+    taco_uassert(property != ModeFormat::NOT_ORDERED &&
+                 property != ModeFormat::NOT_UNIQUE)
+        << "Run-length encoded modes are always ordered and unique";
+  }
+  return ModeFormat(std::make_shared<RunLengthModeFormat>(allocSize));
+}
+
+ModeFunction RunLengthModeFormat::coordIterBounds(vector<Expr> parentCoords,
+                                                  Mode mode) const {
+  return ModeFunction(Stmt(), {0, getDimension(mode.getModePack())});
+}
+
+ModeFunction RunLengthModeFormat::coordIterAccess(Expr parentPos,
+                                                  std::vector<Expr> coords,
+                                                  Mode mode) const {
+  taco_iassert(mode.getModePack().getNumModes() == 1);
+
+  // Search the fiber for the run that holds the coordinate
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr pend = Load::make(posArray, Add::make(parentPos, 1));
+  Expr run = Var::make(mode.getName() + "_run", Int());
+  Expr search = Call::make("taco_runSearch",
+                           {getRunsArray(mode.getModePack()),
+                            Load::make(posArray, parentPos), pend,
+                            coords.back()}, Int());
+  return ModeFunction(VarDecl::make(run, search), {run, Lt::make(run, pend)});
+}
+
+ModeFunction RunLengthModeFormat::coordBounds(Expr parentPos,
+                                              Mode mode) const {
+  return ModeFunction(Stmt(), {0, getDimension(mode.getModePack())});
+}
+
+ModeFunction RunLengthModeFormat::runIterBounds(Expr parentPos,
+                                                Mode mode) const {
+  return posIterBounds(parentPos, mode);
+}
+
+ModeFunction RunLengthModeFormat::runIterAccess(Expr pos, Mode mode) const {
+  Expr runsArray = getRunsArray(mode.getModePack());
+  Expr start = Load::make(runsArray, Mul::make(pos, 2));
+  Expr end = Load::make(runsArray, Add::make(Mul::make(pos, 2), 1));
+  return ModeFunction(Stmt(), {start, end});
+}
+
+Stmt RunLengthModeFormat::getAppendCoord(Expr p, Expr i, Mode mode) const {
+  taco_iassert(mode.getModePack().getNumModes() == 1);
+
+  // Every appended coordinate is a run of its own until packing merges runs
+  Expr runsArray = getRunsArray(mode.getModePack());
+  Expr start = Mul::make(p, 2);
+  Expr end = Add::make(start, 1);
+  Stmt maybeResizeRuns = atLeastDoubleSizeIfFull(runsArray,
+                                                 getCoordCapacity(mode), end);
+  return Block::make({maybeResizeRuns,
+                      Store::make(runsArray, start, i),
+                      Store::make(runsArray, end, Add::make(i, 1))});
+}
+
+vector<Expr> RunLengthModeFormat::getArrays(Expr tensor, int mode,
+                                            int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_pos"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_runs"),
+          GetProperty::make(tensor, TensorProperty::Dimension, mode)};
+}
+
+Expr RunLengthModeFormat::getRunsArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr RunLengthModeFormat::getDimension(ModePack pack) const {
+  return pack.getArray(2);
+}
+
+}
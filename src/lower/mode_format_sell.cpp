@@ -0,0 +1,99 @@
+#include "taco/lower/mode_format_sell.h"
+
+#include "taco/util/strings.h"
+
+using namespace std;
+using namespace taco::ir;
+
+namespace taco {
+
+SellModeFormat::SellModeFormat(int sliceHeight, int sortingScope) :
+    ModeFormatImpl("sell", false, true, true, false, false, false, true,
+                   false, false, false),
+    sliceHeight(sliceHeight), sortingScope(sortingScope) {
+  taco_uassert(sliceHeight > 0) << "Slices must hold at least one fiber";
+  taco_uassert(sortingScope > 0) << "Fibers must be sorted in windows of at "
+                                 << "least one fiber";
+}
+
+ModeFormat SellModeFormat::copy(
+    vector<ModeFormat::Property> properties) const {
+  for (const auto property : properties) {
+    taco_uassert(property != ModeFormat::NOT_ORDERED &&
+                 property != ModeFormat::NOT_UNIQUE) <<
+        "SELL modes are always ordered and unique";
+  }
+  return ModeFormat(std::make_shared<SellModeFormat>(sliceHeight,
+                                                    sortingScope));
+}
+
+ModeFunction SellModeFormat::posIterBounds(Expr parentPos, Mode mode) const {
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr slice = Div::make(parentPos, sliceHeight);
+  Expr pbegin = Add::make(Load::make(posArray, slice),
+                          Rem::make(parentPos, sliceHeight));
+  Expr pend = Load::make(posArray, Add::make(slice, 1));
+  return ModeFunction(Stmt(), {pbegin, pend, sliceHeight});
+}
+
+ModeFunction SellModeFormat::sliceBounds(Expr slice, Mode mode) const {
+  Expr posArray = getPosArray(mode.getModePack());
+  Expr pbegin = Load::make(posArray, slice);
+  Expr pend = Load::make(posArray, Add::make(slice, 1));
+  return ModeFunction(Stmt(), {pbegin, pend});
+}
+
+Expr SellModeFormat::fiberCoord(Expr fiber, Mode mode) const {
+  if (sortingScope == 1) {
+    return fiber;
+  }
+  return Load::make(getPermArray(mode.getModePack()), fiber);
+}
+
+ModeFunction SellModeFormat::posIterAccess(Expr pos, vector<Expr> coords,
+                                           Mode mode) const {
+  // Padding positions hold coordinate -1
+  Expr idx = Load::make(getCoordArray(mode.getModePack()), pos);
+  return ModeFunction(Stmt(), {idx, Gte::make(idx, 0)});
+}
+
+vector<Expr> SellModeFormat::getArrays(Expr tensor, int mode,
+                                       int level) const {
+  std::string arraysName = util::toString(tensor) + std::to_string(level);
+  return {GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 0, arraysName + "_pos"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 1, arraysName + "_crd"),
+          GetProperty::make(tensor, TensorProperty::Indices,
+                            level - 1, 2, arraysName + "_perm")};
+}
+
+int SellModeFormat::getSliceHeight() const {
+  return sliceHeight;
+}
+
+int SellModeFormat::getSortingScope() const {
+  return sortingScope;
+}
+
+Expr SellModeFormat::getPosArray(ModePack pack) const {
+  return pack.getArray(0);
+}
+
+Expr SellModeFormat::getCoordArray(ModePack pack) const {
+  return pack.getArray(1);
+}
+
+Expr SellModeFormat::getPermArray(ModePack pack) const {
+  return pack.getArray(2);
+}
+
+bool SellModeFormat::equals(const ModeFormatImpl& other) const {
+  return ModeFormatImpl::equals(other) &&
+         (dynamic_cast<const SellModeFormat&>(other).sliceHeight ==
+          sliceHeight) &&
+         (dynamic_cast<const SellModeFormat&>(other).sortingScope ==
+          sortingScope);
+}
+
+}
@@ -18,6 +18,7 @@ struct Array::Content : util::Uncopyable {
   void*  data;
   size_t size;
   Policy policy = Array::UserOwns;
+  std::shared_ptr<void> owner;
 
   ~Content() {
     switch (policy) {
@@ -79,6 +80,8 @@ struct Array::Content : util::Uncopyable {
           case Datatype::Complex128:
             delete[] ((std::complex<double>*)data);
             break;
+          case Datatype::Pattern:
+            break;
           case Datatype::Undefined:
             taco_ierror;
             break;
@@ -98,6 +101,11 @@ Array::Array(Datatype type, void* data, size_t size, Policy policy) : Array() {
   content->policy = policy;
 }
 
+Array::Array(Datatype type, void* data, size_t size,
+             std::shared_ptr<void> owner) : Array(type, data, size, UserOwns) {
+  content->owner = owner;
+}
+
 const Datatype& Array::getType() const {
   return content->type;
 }
@@ -187,6 +195,7 @@ std::ostream& operator<<(std::ostream& os, const Array& array) {
     case Datatype::Complex128:
       printData<std::complex<double>>(os, array);
       break;
+    case Datatype::Pattern:
     case Datatype::Undefined:
       os << "[]";
       break;
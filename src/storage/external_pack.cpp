@@ -0,0 +1,471 @@
+#include "external_pack.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <queue>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "taco/tensor.h"
+#include "taco/format.h"
+#include "taco/error.h"
+#include "taco/storage/index.h"
+#include "taco/storage/array.h"
+#include "taco/util/env.h"
+#include "taco/util/uncopyable.h"
+#include "text_parser.h"
+
+using namespace std;
+
+namespace taco {
+
+/// Smallest block of text parsed into one run, so that tiny budgets do not
+/// produce a run per line.
+static const size_t minBytesPerRun = 1 << 12;
+
+/// Smallest number of records buffered from each run while merging.
+static const size_t minRecordsPerRunBuffer = 16;
+
+Format getReadFormat(const Format& format, int) {
+  return format;
+}
+
+Format getReadFormat(const ModeFormat& modetype, int order) {
+  return Format(std::vector<ModeFormatPack>(order, modetype));
+}
+
+bool canPackExternally(const Format& format, int order) {
+  if (order == 0 || format.getOrder() != order) {
+    return false;
+  }
+  for (auto& modeFormat : format.getModeFormats()) {
+    if (modeFormat.getName() != Dense.getName() &&
+        !(modeFormat.getName() == Compressed.getName() &&
+          modeFormat.isUnique())) {
+      return false;
+    }
+  }
+  // The packed index arrays are built with 32-bit positions and coordinates
+  for (int i = 0; i < order; ++i) {
+    if (format.getCoordinateTypePos(i) != Int32 ||
+        format.getCoordinateTypeIdx(i) != Int32) {
+      return false;
+    }
+  }
+  return true;
+}
+
+namespace {
+
+/// A temporary file that sorted runs are spilled to.  The file is unlinked as
+/// soon as it is created, so it disappears when it is closed.
+class SpillFile : util::Uncopyable {
+public:
+  SpillFile() : size(0) {
+    string path = util::getTmpdir() + "runs.XXXXXX";
+    vector<char> name(path.begin(), path.end());
+    name.push_back('\0');
+    fd = mkstemp(name.data());
+    taco_uassert(fd != -1) << "Unable to create a spill file in "
+                           << util::getTmpdir();
+    unlink(name.data());
+  }
+
+  ~SpillFile() {
+    close(fd);
+  }
+
+  /// Appends the bytes to the file and returns the offset they start at.
+  off_t append(const char* data, size_t bytes) {
+    off_t offset = size;
+    while (bytes > 0) {
+      ssize_t written = pwrite(fd, data, bytes, size);
+      taco_uassert(written > 0) << "Unable to write to spill file";
+      data += written;
+      bytes -= written;
+      size += written;
+    }
+    return offset;
+  }
+
+  void read(char* data, size_t bytes, off_t offset) const {
+    while (bytes > 0) {
+      ssize_t numRead = pread(fd, data, bytes, offset);
+      taco_uassert(numRead > 0) << "Unable to read from spill file";
+      data += numRead;
+      bytes -= numRead;
+      offset += numRead;
+    }
+  }
+
+private:
+  int fd;
+  off_t size;
+};
+
+/// A sorted run of records in the spill file, read through a buffer.
+struct Run {
+  off_t offset;
+  size_t numRecords;
+
+  vector<char> buffer;
+  size_t numBuffered;
+  size_t next;
+};
+
+/// A malloc'd array that grows geometrically and is handed to an Array without
+/// being copied.  Elements are zero-initialized.
+template <typename T>
+class GrowableArray : util::Uncopyable {
+public:
+  GrowableArray() : data(nullptr), size(0), capacity(0) {
+    reserve(1);
+  }
+
+  ~GrowableArray() {
+    free(data);
+  }
+
+  size_t getSize() const {
+    return size;
+  }
+
+  T& operator[](size_t i) {
+    return data[i];
+  }
+
+  void resize(size_t newSize) {
+    if (newSize > capacity) {
+      reserve(std::max(newSize, 2 * capacity));
+    }
+    if (newSize > size) {
+      memset((void*)(data + size), 0, (newSize - size) * sizeof(T));
+    }
+    size = newSize;
+  }
+
+  void push_back(T value) {
+    resize(size + 1);
+    data[size - 1] = value;
+  }
+
+  /// Transfers the elements to an Array that frees them.
+  Array release() {
+    Array array(type<T>(), data, size, Array::Free);
+    data = nullptr;
+    size = 0;
+    capacity = 0;
+    return array;
+  }
+
+private:
+  T* data;
+  size_t size;
+  size_t capacity;
+
+  void reserve(size_t newCapacity) {
+    T* newData = (T*)realloc((void*)data, newCapacity * sizeof(T));
+    taco_uassert(newData != nullptr) << "Out of memory while packing";
+    data = newData;
+    capacity = newCapacity;
+  }
+};
+
+/// Builds the index and value arrays of a tensor whose modes are all dense or
+/// compressed from its components, which must arrive sorted in storage order.
+/// If `storeValues` is false (for pattern tensors) only the index is built.
+template <typename T>
+class PackedBuilder {
+public:
+  PackedBuilder(const Format& format, const vector<int>& dimensions,
+                bool storeValues)
+      : dimensions(dimensions), positions(dimensions.size(), 0),
+        previous(dimensions.size(), 0), empty(true), storeValues(storeValues),
+        levels(dimensions.size()) {
+    for (size_t l = 0; l < dimensions.size(); ++l) {
+      levels[l].dense = (format.getModeFormats()[l].getName() ==
+                         Dense.getName());
+    }
+  }
+
+  void append(const int* coordinates, T value) {
+    const size_t order = dimensions.size();
+    size_t diverge = 0;
+    if (!empty) {
+      while (diverge < order && coordinates[diverge] == previous[diverge]) {
+        diverge++;
+      }
+      if (diverge == order) {
+        // Duplicates are summed, as pack does
+        if (storeValues) {
+          values[positions[order-1]] += value;
+        }
+        return;
+      }
+    }
+    empty = false;
+
+    for (size_t l = diverge; l < order; ++l) {
+      const int coordinate = coordinates[l];
+      taco_uassert(coordinate >= 0 && coordinate < dimensions[l]) <<
+          "Coordinate " << coordinate << " is out of bounds for a mode of "
+          "dimension " << dimensions[l];
+      const size_t parent = (l == 0) ? 0 : positions[l-1];
+      Level& level = levels[l];
+      if (level.dense) {
+        positions[l] = parent * dimensions[l] + coordinate;
+      }
+      else {
+        if (level.pos.getSize() < parent + 2) {
+          level.pos.resize(parent + 2);
+        }
+        level.pos[parent + 1]++;
+        level.crd.push_back(coordinate);
+        positions[l] = level.crd.getSize() - 1;
+      }
+      previous[l] = coordinate;
+    }
+
+    if (!storeValues) {
+      return;
+    }
+    if (values.getSize() <= positions[order-1]) {
+      values.resize(positions[order-1] + 1);
+    }
+    values[positions[order-1]] = value;
+  }
+
+  /// Finishes the arrays and stores them in the tensor.
+  void finish(TensorBase& tensor) {
+    const Format& format = tensor.getFormat();
+    vector<ModeIndex> modeIndices;
+    size_t size = 1;
+    for (size_t l = 0; l < levels.size(); ++l) {
+      Level& level = levels[l];
+      if (level.dense) {
+        size *= dimensions[l];
+        modeIndices.push_back(ModeIndex({makeArray({dimensions[l]})}));
+      }
+      else {
+        level.pos.resize(size + 1);
+        for (size_t i = 0; i < size; ++i) {
+          level.pos[i+1] += level.pos[i];
+        }
+        size = level.crd.getSize();
+        modeIndices.push_back(ModeIndex({level.pos.release(),
+                                         level.crd.release()}));
+      }
+    }
+    auto storage = tensor.getStorage();
+    storage.setIndex(Index(format, modeIndices));
+    if (storeValues) {
+      values.resize(size);
+      storage.setValues(values.release());
+    }
+    else {
+      storage.setValues(makeArray(tensor.getComponentType(), size));
+    }
+    tensor.setStorage(storage);
+  }
+
+private:
+  struct Level {
+    bool dense;
+    GrowableArray<int> pos;
+    GrowableArray<int> crd;
+  };
+
+  vector<int> dimensions;
+  vector<size_t> positions;
+  vector<int> previous;
+  bool empty;
+  bool storeValues;
+  vector<Level> levels;
+  GrowableArray<T> values;
+};
+
+}
+
+static inline bool lexicographicalLess(const int* a, const int* b,
+                                       size_t order) {
+  for (size_t i = 0; i < order; ++i) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i];
+    }
+  }
+  return false;
+}
+
+/// Sort the parsed components into a run of records, each of which holds the
+/// coordinates in storage order followed by the value, and spill it.
+static Run spillRun(const ParsedComponents& parsed,
+                    const vector<int>& modeOrdering, size_t recordSize,
+                    size_t maxBufferBytes, SpillFile& spillFile) {
+  const size_t order = modeOrdering.size();
+  const size_t valueSize = parsed.valueType.getNumBytes();
+  const size_t numComponents = parsed.getNumComponents();
+  vector<const int*> coordinates;
+  for (int mode : modeOrdering) {
+    coordinates.push_back(parsed.coordinates[mode].data());
+  }
+
+  vector<size_t> permutation(numComponents);
+  std::iota(permutation.begin(), permutation.end(), 0);
+  std::sort(permutation.begin(), permutation.end(),
+            [&](size_t a, size_t b) {
+    for (size_t l = 0; l < order; ++l) {
+      if (coordinates[l][a] != coordinates[l][b]) {
+        return coordinates[l][a] < coordinates[l][b];
+      }
+    }
+    return false;
+  });
+
+  Run run;
+  run.offset = -1;
+  run.numRecords = numComponents;
+  const size_t recordsPerWrite = std::max(maxBufferBytes / recordSize,
+                                          (size_t)1);
+  vector<char> buffer(std::min(recordsPerWrite, numComponents) * recordSize);
+  for (size_t first = 0; first < numComponents; first += recordsPerWrite) {
+    const size_t last = std::min(first + recordsPerWrite, numComponents);
+    char* record = buffer.data();
+    for (size_t i = first; i < last; ++i, record += recordSize) {
+      const size_t component = permutation[i];
+      for (size_t l = 0; l < order; ++l) {
+        memcpy(record + l * sizeof(int), &coordinates[l][component],
+               sizeof(int));
+      }
+      memcpy(record + order * sizeof(int),
+             &parsed.values[component * valueSize], valueSize);
+    }
+    off_t offset = spillFile.append(buffer.data(), (last - first) * recordSize);
+    if (run.offset == -1) {
+      run.offset = offset;
+    }
+  }
+  return run;
+}
+
+/// Refill the run's buffer from the spill file.  Returns false once the run
+/// has been read to its end.
+static bool refillRun(Run& run, size_t recordSize,
+                      const SpillFile& spillFile) {
+  if (run.numRecords == 0) {
+    return false;
+  }
+  const size_t numRecords = std::min(run.buffer.size() / recordSize,
+                                     run.numRecords);
+  spillFile.read(run.buffer.data(), numRecords * recordSize, run.offset);
+  run.offset += numRecords * recordSize;
+  run.numRecords -= numRecords;
+  run.numBuffered = numRecords;
+  run.next = 0;
+  return true;
+}
+
+TensorBase packExternally(const char* begin, const char* end, int order,
+                          char comment, int indexBase,
+                          std::vector<int> dimensions, const Format& format,
+                          Datatype ctype, bool symm, bool pattern,
+                          size_t memoryBudget) {
+  taco_iassert(canPackExternally(format, order));
+  const vector<int>& modeOrdering = format.getModeOrdering();
+  const size_t recordSize = order * sizeof(int) + ctype.getNumBytes();
+
+  // Parsed components take about as many bytes as their text, and sorting a
+  // block takes as much again, so a block of a quarter of the budget keeps
+  // parsing, sorting and spilling it within the budget.
+  const size_t bytesPerRun = std::max(memoryBudget / 4, minBytesPerRun);
+  const bool inferDimensions = dimensions.empty();
+  vector<int> maxCoordinates(order, 0);
+
+  // Sort blocks of components into runs and spill them
+  SpillFile spillFile;
+  vector<Run> runs;
+  const char* blockBegin = begin;
+  while (blockBegin < end) {
+    const char* blockEnd = blockBegin + std::min(bytesPerRun,
+                                                 (size_t)(end - blockBegin));
+    if (blockEnd < end && blockEnd[-1] != '\n') {
+      const char* lineEnd = (const char*)memchr(blockEnd, '\n',
+                                                end - blockEnd);
+      blockEnd = (lineEnd != nullptr) ? lineEnd + 1 : end;
+    }
+
+    ParsedComponents parsed = parseComponents(blockBegin, blockEnd, order,
+                                              comment, indexBase, ctype,
+                                              pattern);
+    blockBegin = blockEnd;
+    if (parsed.getNumComponents() == 0) {
+      continue;
+    }
+    for (int i = 0; i < order; ++i) {
+      maxCoordinates[i] = std::max(maxCoordinates[i],
+                                   parsed.maxCoordinates[i]);
+    }
+    if (symm) {
+      addTranspose(&parsed);
+    }
+    runs.push_back(spillRun(parsed, modeOrdering, recordSize, bytesPerRun,
+                            spillFile));
+  }
+  if (inferDimensions) {
+    dimensions = maxCoordinates;
+  }
+
+  // Merge the runs straight into the packed arrays, buffering an equal share
+  // of the budget from each run
+  TensorBase tensor(ctype, dimensions, format);
+  vector<int> storageDimensions;
+  for (int mode : modeOrdering) {
+    storageDimensions.push_back(dimensions[mode]);
+  }
+
+  const size_t recordsPerRun =
+      std::max(memoryBudget / std::max(runs.size(), (size_t)1) / recordSize,
+               minRecordsPerRunBuffer);
+  auto record = [&](size_t r) {
+    const Run& run = runs[r];
+    return (const int*)&run.buffer[run.next * recordSize];
+  };
+  auto greater = [&](size_t a, size_t b) {
+    return lexicographicalLess(record(b), record(a), order);
+  };
+  priority_queue<size_t, vector<size_t>, decltype(greater)> heap(greater);
+  for (size_t r = 0; r < runs.size(); ++r) {
+    runs[r].buffer.resize(recordsPerRun * recordSize);
+    if (refillRun(runs[r], recordSize, spillFile)) {
+      heap.push(r);
+    }
+  }
+  // Pattern records hold no value, so the builder is instantiated for any type
+  const bool storeValues = !ctype.isPattern();
+  dispatchValueType(storeValues ? ctype : Bool, [&](auto tag) {
+    typedef decltype(tag) T;
+    PackedBuilder<T> builder(tensor.getFormat(), storageDimensions,
+                             storeValues);
+    while (!heap.empty()) {
+      const size_t r = heap.top();
+      heap.pop();
+      Run& run = runs[r];
+      const char* data = (const char*)record(r);
+      T value = T(1);
+      if (storeValues) {
+        memcpy(&value, data + order * sizeof(int), sizeof(T));
+      }
+      builder.append((const int*)data, value);
+      if (++run.next < run.numBuffered ||
+          refillRun(run, recordSize, spillFile)) {
+        heap.push(r);
+      }
+    }
+    builder.finish(tensor);
+  });
+  return tensor;
+}
+
+}
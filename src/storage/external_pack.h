@@ -0,0 +1,43 @@
+#ifndef TACO_STORAGE_EXTERNAL_PACK_H
+#define TACO_STORAGE_EXTERNAL_PACK_H
+
+#include <vector>
+#include <cstddef>
+
+#include "taco/type.h"
+
+namespace taco {
+class TensorBase;
+class Format;
+class ModeFormat;
+
+/// Returns the format of an order `order` tensor read in `format`.
+Format getReadFormat(const Format& format, int order);
+
+/// Returns the format of an order `order` tensor read in `modetype`.
+Format getReadFormat(const ModeFormat& modetype, int order);
+
+/// Returns true if the components of a tensor of the given format and order
+/// can be packed by packExternally, which is the case if every mode is dense
+/// or compressed and unique and every index array is 32-bit.
+bool canPackExternally(const Format& format, int order);
+
+/// Parse the lines in [begin, end) like parseComponents and pack them into a
+/// tensor of `format` without ever holding all the components in memory.  The
+/// text is parsed in blocks whose components take roughly `memoryBudget` bytes
+/// and each block is sorted into a run that is spilled to a file in the
+/// temporary directory.  The runs are then merged and the tensor's index and
+/// value arrays are built directly from the merged stream.
+///
+/// If `dimensions` is empty they are inferred from the largest coordinates.
+/// Values are parsed as `ctype`, or are all one if `pattern` is true.  If
+/// `symm` is true the transpose of every off-diagonal component of the matrix
+/// is added.
+TensorBase packExternally(const char* begin, const char* end, int order,
+                          char comment, int indexBase,
+                          std::vector<int> dimensions, const Format& format,
+                          Datatype ctype, bool symm, bool pattern,
+                          size_t memoryBudget);
+
+}
+#endif
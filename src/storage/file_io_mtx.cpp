@@ -5,6 +5,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <climits>
+#include <cstring>
 
 #include "taco/tensor.h"
 #include "taco/format.h"
@@ -12,34 +13,121 @@
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/files.h"
+#include "text_parser.h"
+#include "external_pack.h"
 
 using namespace std;
 
 namespace taco {
 
+static const char* nextLine(const char* p, const char* end) {
+  const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+  return (lineEnd != nullptr) ? lineEnd + 1 : end;
+}
+
+/// Skip the comments at the top of the text and return the first other line,
+/// which is the header with the dimensions.
+static string readDimensionsLine(const char** p, const char* end) {
+  string line;
+  while (*p < end) {
+    const char* next = nextLine(*p, end);
+    line.assign(*p, next);
+    *p = next;
+    std::stringstream lineStream(line);
+    string token;
+    if ((lineStream >> token) && token[0] != '%') {
+      break;
+    }
+  }
+  return line;
+}
+
+static vector<int> parseDimensions(string line) {
+  vector<int> dimensions;
+  char* linePtr = (char*)line.data();
+  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
+    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
+    dimensions.push_back(static_cast<int>(dimension));
+  }
+  return dimensions;
+}
+
 template <typename T>
-TensorBase dispatchReadMTX(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readMTX(file, format, pack);
-  file.close();
+static TensorBase readSparseText(const char* begin, const char* end,
+                                 const T& format, Datatype ctype, bool symm,
+                                 bool pattern, bool pack) {
+  // The first non-comment line is the header with dimensions
+  const char* p = begin;
+  vector<int> dimensions = parseDimensions(readDimensionsLine(&p, end));
+  dimensions.pop_back();
+  if (symm)
+    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
+
+  // Files too large for the memory budget are sorted externally
+  const int order = (int)dimensions.size();
+  const size_t budget = getReadMemoryBudget();
+  Format readFormat = getReadFormat(format, order);
+  if (pack && budget > 0 && (size_t)(end - p) > budget &&
+      canPackExternally(readFormat, order)) {
+    return packExternally(p, end, order, '%', 1, dimensions, readFormat,
+                          ctype, symm, pattern, budget);
+  }
+
+  ParsedComponents parsed = parseComponents(p, end, order, '%', 1, ctype,
+                                            pattern);
+
+  // Symmetric files only store the lower triangle, so add the transpose of
+  // the off-diagonal components
+  if (symm) {
+    addTranspose(&parsed);
+  }
+
+  // Create matrix
+  TensorBase tensor(ctype, dimensions, format);
+  insertComponents(tensor, parsed, pack);
   return tensor;
 }
 
-TensorBase readMTX(std::string filename, const ModeFormat& modetype, bool pack) {
-  return dispatchReadMTX(filename, modetype, pack);
-}
+template <typename T>
+static TensorBase readDenseText(const char* begin, const char* end,
+                                const T& format, Datatype ctype, bool symm,
+                                bool pack) {
+  // The first non-comment line is the header with dimension sizes
+  const char* p = begin;
+  vector<int> dimensions = parseDimensions(readDimensionsLine(&p, end));
+  if (symm)
+    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
 
-TensorBase readMTX(std::string filename, const Format& format, bool pack) {
-  return dispatchReadMTX(filename, format, pack);
+  // Values are listed one per line in column-major order
+  ParsedComponents parsed = parseComponents(p, end, 0, '%', 0, ctype);
+  const size_t size = parsed.getNumComponents();
+  parsed.coordinates.resize(dimensions.size(), vector<int>(size));
+  for (size_t n = 0; n < size; n++) {
+    auto index = n;
+    for (size_t mode = 0; mode < dimensions.size()-1; mode++) {
+      parsed.coordinates[mode][n] = index%dimensions[mode];
+      index=index/dimensions[mode];
+    }
+    parsed.coordinates.back()[n] = index;
+  }
+  if (symm) {
+    addTranspose(&parsed);
+  }
+
+  // Create matrix
+  TensorBase tensor(ctype, dimensions, format);
+  insertComponents(tensor, parsed, pack);
+  return tensor;
 }
 
 template <typename T>
-TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
-  string line;
-  if (!std::getline(stream, line)) {
+static TensorBase readMTXText(const char* begin, const char* end,
+                              const T& format, Datatype ctype, bool pack) {
+  if (begin == end) {
     return TensorBase();
   }
+  const char* p = nextLine(begin, end);
+  string line(begin, p);
 
   // Read Header
   std::stringstream lineStream(line);
@@ -51,102 +139,92 @@ TensorBase dispatchReadMTX(std::istream& stream, const T& format, bool pack) {
                                        << "Unknown type of MatrixMarket";
   // formats = [coordinate array]
   // field = [real integer complex pattern]
-  taco_uassert(field=="real")          << "MatrixMarket field not available";
+  taco_uassert((field=="real") || (field=="integer") ||
+               (field=="complex") || (field=="pattern"))
+                                       << "MatrixMarket field not available";
+  taco_uassert(ctype.isPattern() || (field=="complex") == ctype.isComplex())
+      << "MatrixMarket " << field << " values cannot be read as " << ctype;
   // symmetry = [general symmetric skew-symmetric Hermitian]
   taco_uassert((symmetry=="general") || (symmetry=="symmetric"))
                                        << "MatrixMarket symmetry not available";
 
   bool symm = (symmetry=="symmetric");
+  bool pattern = (field=="pattern");
 
-  TensorBase tensor;
-  if (formats=="coordinate")
-    tensor = readSparse(stream,format,symm);
-  else if (formats=="array")
-    tensor = readDense(stream,format,symm);
+  // Components are parsed in parallel, directly as ctype, and packed in bulk
+  if (formats=="coordinate") {
+    return readSparseText(p, end, format, ctype, symm, pattern, pack);
+  }
+  else if (formats=="array") {
+    taco_uassert(!pattern && !ctype.isPattern())
+        << "MatrixMarket arrays cannot be patterns";
+    return readDenseText(p, end, format, ctype, symm, pack);
+  }
   else
     taco_uerror << "MatrixMarket format not available";
+  return TensorBase();
+}
 
-  if (pack) {
-    tensor.pack();
-  }
+template <typename T>
+TensorBase dispatchReadMTX(std::string filename, const T& format,
+                           Datatype ctype, bool pack) {
+  util::MappedFile file(filename);
+  return readMTXText(file.getData(), file.getData() + file.getSize(), format,
+                     ctype, pack);
+}
 
-  return tensor;
+TensorBase readMTX(std::string filename, const ModeFormat& modetype, bool pack) {
+  return dispatchReadMTX(filename, modetype, type<double>(), pack);
 }
 
-TensorBase readMTX(std::istream& stream, const ModeFormat& modetype, bool pack) {
-  return dispatchReadMTX(stream, modetype, pack);
+TensorBase readMTX(std::string filename, const Format& format, bool pack) {
+  return dispatchReadMTX(filename, format, type<double>(), pack);
 }
 
-TensorBase readMTX(std::istream& stream, const Format& format, bool pack) {
-  return dispatchReadMTX(stream, format, pack);
+TensorBase readMTX(std::string filename, const ModeFormat& modetype,
+                   Datatype ctype, bool pack) {
+  return dispatchReadMTX(filename, modetype, ctype, pack);
+}
+
+TensorBase readMTX(std::string filename, const Format& format, Datatype ctype,
+                   bool pack) {
+  return dispatchReadMTX(filename, format, ctype, pack);
 }
 
 template <typename T>
-TensorBase dispatchReadSparse(std::istream& stream, const T& format, 
-                              bool symm) {
-  string line;
-  std::getline(stream,line);
+TensorBase dispatchReadMTX(std::istream& stream, const T& format,
+                           Datatype ctype, bool pack) {
+  string text((std::istreambuf_iterator<char>(stream)),
+              std::istreambuf_iterator<char>());
+  return readMTXText(text.data(), text.data() + text.size(), format, ctype,
+                     pack);
+}
 
-  // Skip comments at the top of the file
-  string token;
-  do {
-    std::stringstream lineStream(line);
-    lineStream >> token;
-    if (token[0] != '%') {
-      break;
-    }
-  } while (std::getline(stream, line));
+TensorBase readMTX(std::istream& stream, const ModeFormat& modetype, bool pack) {
+  return dispatchReadMTX(stream, modetype, type<double>(), pack);
+}
 
-  // The first non-comment line is the header with dimensions
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
-  }
-  size_t nnz = dimensions[dimensions.size()-1];
-  dimensions.pop_back();
-  if (symm)
-    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
+TensorBase readMTX(std::istream& stream, const Format& format, bool pack) {
+  return dispatchReadMTX(stream, format, type<double>(), pack);
+}
 
-  vector<int> coordinates;
-  vector<double> values;
-  coordinates.reserve(nnz*dimensions.size());
-  values.reserve(nnz);
-
-  while (std::getline(stream, line)) {
-    linePtr = (char*)line.data();
-    for (size_t i=0; i < dimensions.size(); i++) {
-      long index = strtol(linePtr, &linePtr, 10);
-      taco_uassert(index <= INT_MAX) << "Index exceeds INT_MAX";
-      coordinates.push_back(static_cast<int>(index));
-    }
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
-  }
+TensorBase readMTX(std::istream& stream, const ModeFormat& modetype,
+                   Datatype ctype, bool pack) {
+  return dispatchReadMTX(stream, modetype, ctype, pack);
+}
 
-  // Create matrix
-  TensorBase tensor(type<double>(), dimensions, format);
-  if (symm)
-    tensor.reserve(2*nnz);
-  else
-    tensor.reserve(nnz);
-
-  // Insert coordinates
-  std::vector<int> coord;
-  for (size_t i = 0; i < nnz; i++) {
-    coord.clear();
-    for (size_t mode = 0; mode < dimensions.size(); mode++) {
-      coord.push_back(coordinates[i*dimensions.size() + mode] -1);
-    }
-    tensor.insert(coord, values[i]);
-    if (symm && coord.front() != coord.back()) {
-      std::reverse(coord.begin(), coord.end());
-      tensor.insert(coord, values[i]);
-    }
-  }
+TensorBase readMTX(std::istream& stream, const Format& format, Datatype ctype,
+                   bool pack) {
+  return dispatchReadMTX(stream, format, ctype, pack);
+}
 
-  return tensor;
+template <typename T>
+TensorBase dispatchReadSparse(std::istream& stream, const T& format, 
+                              bool symm) {
+  string text((std::istreambuf_iterator<char>(stream)),
+              std::istreambuf_iterator<char>());
+  return readSparseText(text.data(), text.data() + text.size(), format,
+                        type<double>(), symm, false, false);
 }
 
 TensorBase readSparse(std::istream& stream, const ModeFormat& modetype, 
@@ -160,65 +238,10 @@ TensorBase readSparse(std::istream& stream, const Format& format, bool symm) {
 
 template <typename T>
 TensorBase dispatchReadDense(std::istream& stream, const T& format, bool symm) {
-  string line;
-  std::getline(stream,line);
-
-  // Skip comments at the top of the file
-  string token;
-  do {
-    std::stringstream lineStream(line);
-    lineStream >> token;
-    if (token[0] != '%') {
-      break;
-    }
-  } while (std::getline(stream, line));
-
-  // The first non-comment line is the header with dimension sizes
-  vector<int> dimensions;
-  char* linePtr = (char*)line.data();
-  while (size_t dimension = strtoul(linePtr, &linePtr, 10)) {
-    taco_uassert(dimension <= INT_MAX) << "Dimension exceeds INT_MAX";
-    dimensions.push_back(static_cast<int>(dimension));
-  }
-  if (symm)
-    taco_uassert(dimensions.size()==2) << "Symmetry only available for matrix";
-
-  vector<double> values;
-  auto size = std::accumulate(begin(dimensions), end(dimensions),
-                              1, std::multiplies<double>());
-  values.reserve(size);
-
-  while (std::getline(stream, line)) {
-    linePtr = (char*)line.data();
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
-  }
-
-  // Create matrix
-  TensorBase tensor(type<double>(), dimensions, format);
-  if (symm)
-    tensor.reserve(2*size);
-  else
-    tensor.reserve(size);
-
-  // Insert coordinates
-  std::vector<int> coord;
-  for (auto n = 0; n<size; n++) {
-    coord.clear();
-    auto index=n;
-    for (size_t mode = 0; mode < dimensions.size()-1; mode++) {
-      coord.push_back(index%dimensions[mode]);
-      index=index/dimensions[mode];
-    }
-    coord.push_back(index);
-    tensor.insert(coord, values[n]);
-    if (symm && coord.front() != coord.back()) {
-      std::reverse(coord.begin(), coord.end());
-      tensor.insert(coord, values[n]);
-    }
-  }
-
-  return tensor;
+  string text((std::istreambuf_iterator<char>(stream)),
+              std::istreambuf_iterator<char>());
+  return readDenseText(text.data(), text.data() + text.size(), format,
+                       type<double>(), symm, false);
 }
 
 TensorBase readDense(std::istream& stream, const ModeFormat& modetype, 
@@ -279,6 +302,23 @@ static void writeSparseCharTyped(std::ostream& stream, const TensorBase& tensor)
 }
 
 
+static void writeSparsePattern(std::ostream& stream,
+                               const TensorBase& tensor) {
+  if(tensor.getOrder() == 2)
+    stream << "%%MatrixMarket matrix coordinate pattern general" << std::endl;
+  else
+    stream << "%%MatrixMarket tensor coordinate pattern general" << std::endl;
+  stream << "%"                                                << std::endl;
+  stream << util::join(tensor.getDimensions(), " ") << " ";
+  stream << tensor.getStorage().getIndex().getSize() << endl;
+  for (auto& value : iterate<bool>(tensor)) {
+    for (int k = 0; k < tensor.getOrder(); ++k) {
+      stream << value.first[k]+1 << (k+1 < tensor.getOrder() ? " " : "");
+    }
+    stream << endl;
+  }
+}
+
 void writeSparse(std::ostream& stream, const TensorBase& tensor) {
   switch(tensor.getComponentType().getKind()) {
     case Datatype::Bool: writeSparseTyped<bool>(stream, tensor); break;
@@ -296,6 +336,7 @@ void writeSparse(std::ostream& stream, const TensorBase& tensor) {
     case Datatype::Float64: writeSparseTyped<double>(stream, tensor); break;
     case Datatype::Complex64: writeSparseTyped<std::complex<float>>(stream, tensor); break;
     case Datatype::Complex128: writeSparseTyped<std::complex<double>>(stream, tensor); break;
+    case Datatype::Pattern: writeSparsePattern(stream, tensor); break;
     case Datatype::Undefined: taco_ierror; break;
     default:
       taco_unreachable;
@@ -346,6 +387,9 @@ void writeDense(std::ostream& stream, const TensorBase& tensor) {
     case Datatype::Float64: writeDenseTyped<double>(stream, tensor); break;
     case Datatype::Complex64: writeDenseTyped<std::complex<float>>(stream, tensor); break;
     case Datatype::Complex128: writeDenseTyped<std::complex<double>>(stream, tensor); break;
+    case Datatype::Pattern:
+      taco_uerror << "Pattern tensors cannot be written as MatrixMarket arrays";
+      break;
     case Datatype::Undefined: taco_ierror; break;
     default:
       taco_unreachable;
@@ -14,6 +14,7 @@
 #include "taco/util/files.h"
 #include "taco/util/collections.h"
 #include "taco/cuda.h"
+#include "text_parser.h"
 
 using namespace std;
 
@@ -81,7 +82,12 @@ void readFile(std::istream &hbfile,
   else {
     (*values) = (double*)malloc(nnzero * sizeof(double));
   }
-  readValues(hbfile, valcrd, *values);
+  if ((mxtype[0] == 'P')||(mxtype[0] == 'p')) {
+    std::fill(*values, *values + nnzero, 1.0);
+  }
+  else {
+    readValues(hbfile, valcrd, *values);
+  }
 
   readRHS();
 }
@@ -189,7 +195,9 @@ void readHeader(std::istream &hbfile,
        R Real matrix
        C Complex matrix
        P Pattern only (no numerical values supplied) */
-  taco_uassert(((*mxtype)[0] == 'R')||((*mxtype)[0] == 'r'))
+  taco_uassert(((*mxtype)[0] == 'R')||((*mxtype)[0] == 'r')||
+               ((*mxtype)[0] == 'I')||((*mxtype)[0] == 'i')||
+               ((*mxtype)[0] == 'P')||((*mxtype)[0] == 'p'))
           << "mxtype in HBfile:  case not available " << *mxtype;
   /* Second Character:
        S Symmetric
@@ -321,24 +329,60 @@ TensorBase readRB(std::istream& stream, const ModeFormat& modetype, bool pack) {
   return TensorBase();
 }
 
-TensorBase readRB(std::istream& stream, const Format& format, bool pack) {
-  int rows, cols;
-  int *colptr = NULL;
-  int *rowidx = NULL;
-  double *vals = NULL;
+TensorBase readRB(std::string filename, const Format& format, Datatype ctype,
+                  bool pack) {
+  std::fstream file;
+  util::openStream(file, filename, fstream::in);
+  TensorBase tensor = readRB(file, format, ctype, pack);
+  file.close();
+
+  return tensor;
+}
+
+TensorBase readRB(std::istream& stream, const Format& format, Datatype ctype,
+                  bool pack) {
+  std::string title, key;
+  int totcrd,ptrcrd,indcrd,valcrd,rhscrd;
+  std::string mxtype;
+  int rows, cols, nnzero, neltvl;
+  std::string ptrfmt, indfmt, valfmt, rhsfmt;
 
-  readFile(stream, &rows, &cols, &colptr, &rowidx, &vals);
+  readHeader(stream,
+             &title, &key,
+             &totcrd, &ptrcrd, &indcrd, &valcrd, &rhscrd,
+             &mxtype, &rows, &cols, &nnzero, &neltvl,
+             &ptrfmt, &indfmt, &valfmt, &rhsfmt);
 
   taco_uassert(format == CSC) << "RB files must be loaded into a CSC matrix";
-  TensorBase tensor(type<double>(), {(int)rows,(int)cols}, CSC);
+  TensorBase tensor(ctype, {(int)rows,(int)cols}, CSC);
+
+  Array colptr = makeArray(type<int>(), cols+1);
+  readIndices(stream, ptrcrd, (int*)colptr.getData());
+  Array rowidx = makeArray(type<int>(), nnzero);
+  readIndices(stream, indcrd, (int*)rowidx.getData());
+
+  // Values are parsed directly as ctype; pattern matrices have none
+  Array values = makeArray(ctype, nnzero);
+  if ((mxtype[0] == 'P')||(mxtype[0] == 'p')) {
+    fillOnes(ctype, values.getData(), nnzero);
+  }
+  else {
+    std::string text;
+    std::string line;
+    for (int i = 0; i < valcrd && std::getline(stream, line); i++) {
+      text += line;
+      text += '\n';
+    }
+    size_t numValues = parseValues(text.data(), text.data() + text.size(),
+                                   ctype, values.getData(), nnzero);
+    taco_uassert(numValues == (size_t)nnzero)
+        << "Expected " << nnzero << " values in RB file but read " << numValues;
+  }
 
   auto storage = tensor.getStorage();
   Index index(CSC,
               {ModeIndex({makeArray({(int)cols})}),
-               ModeIndex({makeArray(colptr, cols+1, Array::Free),
-                               makeArray(rowidx, colptr[cols], Array::Free)})});
-  auto values = makeArray(vals, index.getSize(), Array::Free);
-
+               ModeIndex({colptr, rowidx})});
   storage.setIndex(index);
   storage.setValues(values);
 
@@ -349,6 +393,10 @@ TensorBase readRB(std::istream& stream, const Format& format, bool pack) {
   return tensor;
 }
 
+TensorBase readRB(std::istream& stream, const Format& format, bool pack) {
+  return readRB(stream, format, type<double>(), pack);
+}
+
 void writeRB(std::string filename, const TensorBase& tensor) {
   taco_iassert(tensor.getOrder() == 2) <<
       "The .rb format only supports matrices. Consider using the .tns format "
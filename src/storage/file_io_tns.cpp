@@ -13,85 +13,91 @@
 #include "taco/error.h"
 #include "taco/util/strings.h"
 #include "taco/util/files.h"
+#include "text_parser.h"
+#include "external_pack.h"
 
 using namespace std;
 
 namespace taco {
 
 template <typename T>
-TensorBase dispatchReadTNS(std::string filename, const T& format, bool pack) {
-  std::fstream file;
-  util::openStream(file, filename, fstream::in);
-  TensorBase tensor = readTNS(file, format, pack);
-  file.close();
+static TensorBase readTNSText(const char* begin, const char* end,
+                              const T& format, Datatype ctype, bool pack) {
+  // Infer tensor order from the first coordinate, where complex values take
+  // two fields
+  int numFields = countFields(begin, end, '#');
+  if (numFields == 0) {
+    return TensorBase();
+  }
+  int order = numFields - (ctype.isComplex() ? 2 : 1);
+
+  // Files too large for the memory budget are sorted externally
+  const size_t budget = getReadMemoryBudget();
+  Format readFormat = getReadFormat(format, order);
+  if (pack && budget > 0 && (size_t)(end - begin) > budget &&
+      canPackExternally(readFormat, order)) {
+    return packExternally(begin, end, order, '#', 1, {}, readFormat, ctype,
+                          false, false, budget);
+  }
+
+  // Load data, inferring the dimensions from the largest coordinates
+  ParsedComponents parsed = parseComponents(begin, end, order, '#', 1, ctype);
+  TensorBase tensor(ctype, parsed.maxCoordinates, format);
+  insertComponents(tensor, parsed, pack);
   return tensor;
 }
 
+template <typename T>
+TensorBase dispatchReadTNS(std::string filename, const T& format,
+                           Datatype ctype, bool pack) {
+  util::MappedFile file(filename);
+  return readTNSText(file.getData(), file.getData() + file.getSize(), format,
+                     ctype, pack);
+}
+
 TensorBase readTNS(std::string filename, const ModeFormat& modetype, bool pack) {
-  return dispatchReadTNS(filename, modetype, pack);
+  return dispatchReadTNS(filename, modetype, type<double>(), pack);
 }
 
 TensorBase readTNS(std::string filename, const Format& format, bool pack) {
-  return dispatchReadTNS(filename, format, pack);
+  return dispatchReadTNS(filename, format, type<double>(), pack);
 }
 
-template <typename T>
-TensorBase dispatchReadTNS(std::istream& stream, const T& format, bool pack) {
-  std::vector<int>    coordinates;
-  std::vector<double> values;
-
-  std::string line;
-  if (!std::getline(stream, line)) {
-    return TensorBase();
-  }
-
-  // Infer tensor order from the first coordinate
-  vector<string> toks = util::split(line, " ");
-  size_t order = toks.size()-1;
-  std::vector<int> dimensions(order);
-  std::vector<int> coordinate(order);
-
-  // Load data
-  do {
-    char* linePtr = (char*)line.data();
-    for (size_t i = 0; i < order; i++) {
-      long idx = strtol(linePtr, &linePtr, 10);
-      taco_uassert(idx <= INT_MAX)<<"Coordinate in file is larger than INT_MAX";
-      coordinate[i] = (int)idx - 1;
-      dimensions[i] = std::max(dimensions[i], (int)idx);
-    }
-    coordinates.insert(coordinates.end(), coordinate.begin(), coordinate.end());
-    double val = strtod(linePtr, &linePtr);
-    values.push_back(val);
-
-  } while (std::getline(stream, line));
-
-  // Create tensor
-  const size_t nnz = values.size();
-  TensorBase tensor(type<double>(), dimensions, format);
-  tensor.reserve(nnz);
-
-  // Insert coordinates (TODO add and use bulk insertion)
-  for (size_t i = 0; i < nnz; i++) {
-    for (size_t j = 0; j < order; j++) {
-      coordinate[j] = coordinates[i*order + j];
-    }
-    tensor.insert(coordinate, values[i]);
-  }
+TensorBase readTNS(std::string filename, const ModeFormat& modetype,
+                   Datatype ctype, bool pack) {
+  return dispatchReadTNS(filename, modetype, ctype, pack);
+}
 
-  if (pack) {
-    tensor.pack();
-  }
+TensorBase readTNS(std::string filename, const Format& format, Datatype ctype,
+                   bool pack) {
+  return dispatchReadTNS(filename, format, ctype, pack);
+}
 
-  return tensor;
+template <typename T>
+TensorBase dispatchReadTNS(std::istream& stream, const T& format,
+                           Datatype ctype, bool pack) {
+  std::string text((std::istreambuf_iterator<char>(stream)),
+                   std::istreambuf_iterator<char>());
+  return readTNSText(text.data(), text.data() + text.size(), format, ctype,
+                     pack);
 }
 
 TensorBase readTNS(std::istream& stream, const ModeFormat& modetype, bool pack) {
-  return dispatchReadTNS(stream, modetype, pack);
+  return dispatchReadTNS(stream, modetype, type<double>(), pack);
 }
 
 TensorBase readTNS(std::istream& stream, const Format& format, bool pack) {
-  return dispatchReadTNS(stream, format, pack);
+  return dispatchReadTNS(stream, format, type<double>(), pack);
+}
+
+TensorBase readTNS(std::istream& stream, const ModeFormat& modetype,
+                   Datatype ctype, bool pack) {
+  return dispatchReadTNS(stream, modetype, ctype, pack);
+}
+
+TensorBase readTNS(std::istream& stream, const Format& format, Datatype ctype,
+                   bool pack) {
+  return dispatchReadTNS(stream, format, ctype, pack);
 }
 
 void writeTNS(std::string filename, const TensorBase& tensor) {
@@ -0,0 +1,387 @@
+#include "taco/storage/file_io_ttb.h"
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <memory>
+
+#include "taco/tensor.h"
+#include "taco/format.h"
+#include "taco/error.h"
+#include "taco/storage/index.h"
+#include "taco/storage/array.h"
+#include "taco/util/files.h"
+
+using namespace std;
+
+namespace taco {
+
+// A ttb file starts with the magic bytes, followed by a header of 64-bit words:
+//
+//   version, component type, order, dimensions[order],
+//   number of mode format packs, then for every pack the number of modes and
+//   for every mode its format name and property flags,
+//   mode ordering[order],
+//   for every level the number of index arrays and for every array its type,
+//   size and byte offset,
+//   the values' size and byte offset.
+//
+// The arrays follow the header, each starting at an offset that is a multiple
+// of ttbAlignment.  Words and array contents are stored in host byte order.
+static const char ttbMagic[8] = {'T','A','C','O','T','T','B','\0'};
+static const uint64_t ttbVersion = 1;
+static const uint64_t ttbAlignment = 64;
+
+// Mode format names
+static const uint64_t TTBDense = 0;
+static const uint64_t TTBCompressed = 1;
+static const uint64_t TTBSingleton = 2;
+
+// Mode format property flags
+static const uint64_t TTBFull = 1;
+static const uint64_t TTBOrdered = 2;
+static const uint64_t TTBUnique = 4;
+static const uint64_t TTBBranchless = 8;
+static const uint64_t TTBCompact = 16;
+
+static uint64_t encodeModeFormat(const ModeFormat& modeFormat) {
+  if (modeFormat.getName() == Dense.getName()) {
+    return TTBDense;
+  } else if (modeFormat.getName() == Compressed.getName()) {
+    return TTBCompressed;
+  } else if (modeFormat.getName() == Singleton.getName()) {
+    return TTBSingleton;
+  }
+  taco_uerror << "The ttb format does not support " << modeFormat
+              << " modes";
+  return 0;
+}
+
+static uint64_t encodeProperties(const ModeFormat& modeFormat) {
+  return (modeFormat.isFull()       ? TTBFull       : 0) |
+         (modeFormat.isOrdered()    ? TTBOrdered    : 0) |
+         (modeFormat.isUnique()     ? TTBUnique     : 0) |
+         (modeFormat.isBranchless() ? TTBBranchless : 0) |
+         (modeFormat.isCompact()    ? TTBCompact    : 0);
+}
+
+static ModeFormat decodeModeFormat(uint64_t name, uint64_t properties) {
+  ModeFormat modeFormat;
+  switch (name) {
+    case TTBDense:
+      modeFormat = Dense;
+      break;
+    case TTBCompressed:
+      modeFormat = Compressed;
+      break;
+    case TTBSingleton:
+      modeFormat = Singleton;
+      break;
+    default:
+      taco_uerror << "Corrupt ttb file: unknown mode format " << name;
+  }
+  return modeFormat({
+    (properties & TTBFull)       ? ModeFormat::FULL       : ModeFormat::NOT_FULL,
+    (properties & TTBOrdered)    ? ModeFormat::ORDERED    : ModeFormat::NOT_ORDERED,
+    (properties & TTBUnique)     ? ModeFormat::UNIQUE     : ModeFormat::NOT_UNIQUE,
+    (properties & TTBBranchless) ? ModeFormat::BRANCHLESS : ModeFormat::NOT_BRANCHLESS,
+    (properties & TTBCompact)    ? ModeFormat::COMPACT    : ModeFormat::NOT_COMPACT
+  });
+}
+
+static uint64_t align(uint64_t offset) {
+  return (offset + ttbAlignment - 1) / ttbAlignment * ttbAlignment;
+}
+
+/// Reads the header words of a ttb file, checking that they stay within it.
+class TTBHeaderReader {
+public:
+  TTBHeaderReader(const char* data, size_t size) : data(data), size(size),
+                                                   offset(sizeof(ttbMagic)) {
+    taco_uassert(size >= sizeof(ttbMagic) &&
+                 memcmp(data, ttbMagic, sizeof(ttbMagic)) == 0)
+        << "Not a ttb file";
+  }
+
+  uint64_t read() {
+    taco_uassert(offset + sizeof(uint64_t) <= size) << "Truncated ttb file";
+    uint64_t word;
+    memcpy(&word, &data[offset], sizeof(uint64_t));
+    offset += sizeof(uint64_t);
+    return word;
+  }
+
+  /// Read the type, size and offset of an array and return the array, which
+  /// points into the file data.
+  Array readArray(Datatype type, shared_ptr<void> owner) {
+    uint64_t arraySize = read();
+    uint64_t arrayOffset = read();
+    taco_uassert(arrayOffset % ttbAlignment == 0 &&
+                 arrayOffset <= size &&
+                 arraySize <= (size - arrayOffset) / std::max(type.getNumBytes(), 1))
+        << "Corrupt ttb file: array out of bounds";
+    return Array(type, (void*)&data[arrayOffset], arraySize, owner);
+  }
+
+private:
+  const char* data;
+  size_t size;
+  size_t offset;
+};
+
+static TensorBase parseTTB(const char* data, size_t size,
+                           shared_ptr<void> owner) {
+  TTBHeaderReader header(data, size);
+  uint64_t version = header.read();
+  taco_uassert(version == ttbVersion)
+      << "Unsupported ttb version " << version;
+
+  uint64_t componentKind = header.read();
+  taco_uassert(componentKind < Datatype::Undefined)
+      << "Corrupt ttb file: unknown component type";
+  Datatype componentType((Datatype::Kind)componentKind);
+
+  int order = (int)header.read();
+  vector<int> dimensions(order);
+  for (auto& dimension : dimensions) {
+    dimension = (int)header.read();
+  }
+
+  vector<ModeFormatPack> modeFormatPacks;
+  int numModeFormats = 0;
+  uint64_t numPacks = header.read();
+  for (uint64_t i = 0; i < numPacks; ++i) {
+    vector<ModeFormat> modeFormats;
+    uint64_t numModes = header.read();
+    for (uint64_t j = 0; j < numModes; ++j) {
+      uint64_t name = header.read();
+      uint64_t properties = header.read();
+      modeFormats.push_back(decodeModeFormat(name, properties));
+    }
+    numModeFormats += (int)numModes;
+    modeFormatPacks.push_back(ModeFormatPack(modeFormats));
+  }
+  taco_uassert(numModeFormats == order)
+      << "Corrupt ttb file: wrong number of mode formats";
+
+  vector<int> modeOrdering(order);
+  for (auto& mode : modeOrdering) {
+    mode = (int)header.read();
+  }
+  Format format(modeFormatPacks, modeOrdering);
+
+  vector<ModeIndex> modeIndices;
+  vector<vector<Datatype>> levelArrayTypes;
+  for (int i = 0; i < order; ++i) {
+    vector<Array> indexArrays;
+    vector<Datatype> arrayTypes;
+    uint64_t numArrays = header.read();
+    for (uint64_t j = 0; j < numArrays; ++j) {
+      uint64_t kind = header.read();
+      taco_uassert(kind < Datatype::Undefined)
+          << "Corrupt ttb file: unknown index type";
+      indexArrays.push_back(header.readArray((Datatype::Kind)kind, owner));
+      arrayTypes.push_back((Datatype::Kind)kind);
+    }
+    modeIndices.push_back(ModeIndex(indexArrays));
+    levelArrayTypes.push_back(arrayTypes);
+  }
+  format.setLevelArrayTypes(levelArrayTypes);
+  Array values = header.readArray(componentType, owner);
+
+  TensorBase tensor(componentType, dimensions, format);
+  auto storage = tensor.getStorage();
+  storage.setIndex(Index(format, modeIndices));
+  storage.setValues(values);
+  tensor.setStorage(storage);
+  return tensor;
+}
+
+TensorBase readTTB(std::string filename) {
+  auto mapping = make_shared<util::MappedFile>(filename);
+  return parseTTB(mapping->getData(), mapping->getSize(), mapping);
+}
+
+static TensorBase readTTB(std::istream& stream) {
+  vector<char> contents((istreambuf_iterator<char>(stream)),
+                        istreambuf_iterator<char>());
+  // Copy into 64-byte aligned memory so the arrays keep their alignment
+  void* aligned = nullptr;
+  taco_uassert(posix_memalign(&aligned, ttbAlignment,
+                              std::max(contents.size(), (size_t)1)) == 0)
+      << "Out of memory reading ttb tensor";
+  shared_ptr<char> data((char*)aligned, free);
+  memcpy(data.get(), contents.data(), contents.size());
+  return parseTTB(data.get(), contents.size(), data);
+}
+
+static void checkFormat(const TensorBase& tensor, const Format& format) {
+  taco_uassert(tensor.getFormat() == format)
+      << "The ttb file stores a tensor of format " << tensor.getFormat()
+      << ", not " << format;
+}
+
+static void checkFormat(const TensorBase& tensor, const ModeFormat& modetype) {
+  for (auto& modeFormat : tensor.getFormat().getModeFormats()) {
+    taco_uassert(modeFormat == modetype)
+        << "The ttb file stores a tensor of format " << tensor.getFormat()
+        << ", not " << modetype;
+  }
+}
+
+template <typename T>
+static void insertTypedComponents(TensorBase& tensor, const TensorBase& packed) {
+  for (auto& value : iterate<T>(packed)) {
+    tensor.insert(value.first.toVector(), value.second);
+  }
+}
+
+/// Returns a tensor with the components of a packed tensor inserted but not
+/// packed, like the tensors the other readers return when asked not to pack.
+static TensorBase unpack(const TensorBase& packed) {
+  TensorBase tensor(packed.getName(), packed.getComponentType(),
+                    packed.getDimensions(), packed.getFormat());
+  switch (packed.getComponentType().getKind()) {
+    case Datatype::Bool: insertTypedComponents<bool>(tensor, packed); break;
+    case Datatype::UInt8: insertTypedComponents<uint8_t>(tensor, packed); break;
+    case Datatype::UInt16: insertTypedComponents<uint16_t>(tensor, packed); break;
+    case Datatype::UInt32: insertTypedComponents<uint32_t>(tensor, packed); break;
+    case Datatype::UInt64: insertTypedComponents<uint64_t>(tensor, packed); break;
+    case Datatype::UInt128: insertTypedComponents<unsigned long long>(tensor, packed); break;
+    case Datatype::Int8: insertTypedComponents<int8_t>(tensor, packed); break;
+    case Datatype::Int16: insertTypedComponents<int16_t>(tensor, packed); break;
+    case Datatype::Int32: insertTypedComponents<int32_t>(tensor, packed); break;
+    case Datatype::Int64: insertTypedComponents<int64_t>(tensor, packed); break;
+    case Datatype::Int128: insertTypedComponents<long long>(tensor, packed); break;
+    case Datatype::Float32: insertTypedComponents<float>(tensor, packed); break;
+    case Datatype::Float64: insertTypedComponents<double>(tensor, packed); break;
+    case Datatype::Complex64: insertTypedComponents<std::complex<float>>(tensor, packed); break;
+    case Datatype::Complex128: insertTypedComponents<std::complex<double>>(tensor, packed); break;
+    case Datatype::Undefined: taco_ierror; break;
+    default:
+      taco_unreachable;
+  }
+  return tensor;
+}
+
+template <typename T>
+TensorBase dispatchReadTTB(std::string filename, const T& format, bool pack) {
+  TensorBase tensor = readTTB(filename);
+  checkFormat(tensor, format);
+  return pack ? tensor : unpack(tensor);
+}
+
+TensorBase readTTB(std::string filename, const ModeFormat& modetype,
+                   bool pack) {
+  return dispatchReadTTB(filename, modetype, pack);
+}
+
+TensorBase readTTB(std::string filename, const Format& format, bool pack) {
+  return dispatchReadTTB(filename, format, pack);
+}
+
+template <typename T>
+TensorBase dispatchReadTTB(std::istream& stream, const T& format, bool pack) {
+  TensorBase tensor = readTTB(stream);
+  checkFormat(tensor, format);
+  return pack ? tensor : unpack(tensor);
+}
+
+TensorBase readTTB(std::istream& stream, const ModeFormat& modetype,
+                   bool pack) {
+  return dispatchReadTTB(stream, modetype, pack);
+}
+
+TensorBase readTTB(std::istream& stream, const Format& format, bool pack) {
+  return dispatchReadTTB(stream, format, pack);
+}
+
+void writeTTB(std::string filename, const TensorBase& tensor) {
+  std::fstream file;
+  util::openStream(file, filename, fstream::out | fstream::binary);
+  writeTTB(file, tensor);
+  file.close();
+}
+
+void writeTTB(std::ostream& stream, const TensorBase& tensor) {
+  const TensorStorage& storage = tensor.getStorage();
+  const Format& format = storage.getFormat();
+  const Index& index = storage.getIndex();
+
+  // The arrays in the order they are laid out after the header
+  vector<const Array*> arrays;
+  for (int i = 0; i < index.numModeIndices(); ++i) {
+    const ModeIndex& modeIndex = index.getModeIndex(i);
+    for (int j = 0; j < modeIndex.numIndexArrays(); ++j) {
+      arrays.push_back(&modeIndex.getIndexArray(j));
+    }
+  }
+  vector<uint64_t> sizes;
+  for (auto array : arrays) {
+    sizes.push_back(array->getSize());
+  }
+  arrays.push_back(&storage.getValues());
+  sizes.push_back(storage.getValues().getSize());
+
+  vector<uint64_t> header;
+  header.push_back(ttbVersion);
+  header.push_back(tensor.getComponentType().getKind());
+  header.push_back(tensor.getOrder());
+  for (int dimension : tensor.getDimensions()) {
+    header.push_back(dimension);
+  }
+  header.push_back(format.getModeFormatPacks().size());
+  for (auto& modeFormatPack : format.getModeFormatPacks()) {
+    header.push_back(modeFormatPack.getModeFormats().size());
+    for (auto& modeFormat : modeFormatPack.getModeFormats()) {
+      header.push_back(encodeModeFormat(modeFormat));
+      header.push_back(encodeProperties(modeFormat));
+    }
+  }
+  for (int mode : format.getModeOrdering()) {
+    header.push_back(mode);
+  }
+
+  // Array offsets depend on the header size, which is known up front: every
+  // index array takes three words and the value array two.
+  const size_t headerSize = sizeof(ttbMagic) + sizeof(uint64_t) *
+      (header.size() + index.numModeIndices() + 3 * (arrays.size() - 1) + 2);
+  vector<uint64_t> offsets;
+  uint64_t offset = align(headerSize);
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    offsets.push_back(offset);
+    offset = align(offset + sizes[i] * arrays[i]->getType().getNumBytes());
+  }
+
+  size_t arrayIdx = 0;
+  for (int i = 0; i < index.numModeIndices(); ++i) {
+    const ModeIndex& modeIndex = index.getModeIndex(i);
+    header.push_back(modeIndex.numIndexArrays());
+    for (int j = 0; j < modeIndex.numIndexArrays(); ++j, ++arrayIdx) {
+      header.push_back(arrays[arrayIdx]->getType().getKind());
+      header.push_back(sizes[arrayIdx]);
+      header.push_back(offsets[arrayIdx]);
+    }
+  }
+  header.push_back(sizes[arrayIdx]);
+  header.push_back(offsets[arrayIdx]);
+
+  taco_iassert(sizeof(ttbMagic) + header.size() * sizeof(uint64_t) ==
+               headerSize);
+  stream.write(ttbMagic, sizeof(ttbMagic));
+  stream.write((const char*)header.data(), header.size() * sizeof(uint64_t));
+
+  const vector<char> padding(ttbAlignment, 0);
+  uint64_t written = headerSize;
+  for (size_t i = 0; i < arrays.size(); ++i) {
+    stream.write(padding.data(), offsets[i] - written);
+    const uint64_t numBytes = sizes[i] * arrays[i]->getType().getNumBytes();
+    stream.write((const char*)arrays[i]->getData(), numBytes);
+    written = offsets[i] + numBytes;
+  }
+  taco_uassert(stream.good()) << "Error writing ttb tensor";
+}
+
+}
@@ -6,6 +6,7 @@
 #include "taco/format.h"
 #include "taco/error.h"
 #include "taco/storage/array.h"
+#include "taco/lower/mode_format_sell.h"
 
 using namespace std;
 
@@ -57,9 +58,21 @@ size_t Index::getSize() const {
     auto modeIndex = getModeIndex(i);
     if (modeType.getName() == Dense.getName()) {
       size *= modeIndex.getIndexArray(0).get(0).getAsIndex();
-    } else if (modeType.getName() == Sparse.getName()) {
+    } else if (modeType.getName() == Sparse.getName() ||
+               modeType.getName() == RLE.getName()) {
       size = modeIndex.getIndexArray(0).get(size).getAsIndex();
-    } else {
+    } else if (modeType.getName() == Sell.getName()) {
+      // Every slice holds the padded fibers of sliceHeight parent positions
+      const auto sell =
+          std::dynamic_pointer_cast<const SellModeFormat>(modeType.impl);
+      taco_iassert(sell != nullptr);
+      const size_t numSlices = (size + sell->getSliceHeight() - 1) /
+                               sell->getSliceHeight();
+      size = modeIndex.getIndexArray(0).get(numSlices).getAsIndex();
+    } else if (modeType.getName() == Hashed.getName() ||
+               modeType.getName() == Bitmap.getName()) {
+      size *= modeIndex.getIndexArray(0).get(0).getAsIndex();
+    } else if (modeType.getName() != Singleton.getName()) {
       taco_not_supported_yet;
     }
   }
@@ -45,6 +45,14 @@ struct TensorStorage::Content {
         modeTypes[i] = taco_mode_sparse;
       } else if (modeType.getName() == Singleton.getName()) {
         modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Hashed.getName()) {
+        modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Bitmap.getName()) {
+        modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == RLE.getName()) {
+        modeTypes[i] = taco_mode_sparse;
+      } else if (modeType.getName() == Sell.getName()) {
+        modeTypes[i] = taco_mode_sparse;
       } else {
         taco_not_supported_yet;
       }
@@ -133,7 +141,8 @@ TensorStorage::operator struct taco_tensor_t*() const {
       tensorData->indices[i][0] = (uint8_t*)size.getData();
     }
     // Sparse levels have two indices (pos and idx)
-    else if (modeType.getName() == Sparse.getName()) {
+    else if (modeType.getName() == Sparse.getName() ||
+             modeType.getName() == RLE.getName()) {
       // TODO Uncomment assert and remove conditional
       // taco_iassert(modeIndex.numIndexArrays() == 2)
       //     << modeIndex.numIndexArrays();
@@ -144,6 +153,17 @@ TensorStorage::operator struct taco_tensor_t*() const {
         tensorData->indices[i][1] = (uint8_t*)idx.getData();
       }
     }
+    // SELL levels also have the permutation of their sorted fibers
+    else if (modeType.getName() == Sell.getName()) {
+      if (modeIndex.numIndexArrays() > 0) {
+        const Array& pos = modeIndex.getIndexArray(0);
+        const Array& idx = modeIndex.getIndexArray(1);
+        const Array& perm = modeIndex.getIndexArray(2);
+        tensorData->indices[i][0] = (uint8_t*)pos.getData();
+        tensorData->indices[i][1] = (uint8_t*)idx.getData();
+        tensorData->indices[i][2] = (uint8_t*)perm.getData();
+      }
+    }
     else if (modeType.getName() == Singleton.getName()) {
       // TODO Uncomment assert and remove conditional
       // taco_iassert(modeIndex.numIndexArrays() == 2)
@@ -153,6 +173,24 @@ TensorStorage::operator struct taco_tensor_t*() const {
         tensorData->indices[i][1] = (uint8_t*)idx.getData();
       }
     }
+    // Hashed levels have the width of their tables and the coordinates
+    else if (modeType.getName() == Hashed.getName()) {
+      const Array& width = modeIndex.getIndexArray(0);
+      tensorData->indices[i][0] = (uint8_t*)width.getData();
+      if (modeIndex.numIndexArrays() > 1) {
+        const Array& idx = modeIndex.getIndexArray(1);
+        tensorData->indices[i][1] = (uint8_t*)idx.getData();
+      }
+    }
+    // Bitmap levels have the size of the mode and the bitmap words
+    else if (modeType.getName() == Bitmap.getName()) {
+      const Array& size = modeIndex.getIndexArray(0);
+      tensorData->indices[i][0] = (uint8_t*)size.getData();
+      if (modeIndex.numIndexArrays() > 1) {
+        const Array& bitmap = modeIndex.getIndexArray(1);
+        tensorData->indices[i][1] = (uint8_t*)bitmap.getData();
+      }
+    }
     else {
       taco_not_supported_yet;
     }
@@ -0,0 +1,413 @@
+#include "text_parser.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "taco/tensor.h"
+#include "taco/error.h"
+#include "taco/util/thread_pool.h"
+
+using namespace std;
+
+namespace taco {
+
+/// Minimum number of bytes each thread must be given before the parser splits
+/// the text across threads.
+static const size_t minBytesPerParseThread = 1 << 20;
+
+/// Powers of ten that are exactly representable as doubles.
+static const double exactPowersOfTen[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isBlank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline const char* skipBlanks(const char* p, const char* end) {
+  while (p < end && isBlank(*p)) {
+    p++;
+  }
+  return p;
+}
+
+static inline const char* findLineEnd(const char* p, const char* end) {
+  const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+  return (lineEnd != nullptr) ? lineEnd : end;
+}
+
+static inline int parseCoordinate(const char** p, const char* end) {
+  const char* q = skipBlanks(*p, end);
+  bool negative = (q < end && *q == '-');
+  if (q < end && (*q == '-' || *q == '+')) {
+    q++;
+  }
+  taco_uassert(q < end && isDigit(*q)) << "Malformed coordinate in file";
+  long long value = 0;
+  while (q < end && isDigit(*q)) {
+    value = value * 10 + (*q - '0');
+    taco_uassert(value <= INT_MAX)
+        << "Coordinate in file is larger than INT_MAX";
+    q++;
+  }
+  *p = q;
+  return (int)(negative ? -value : value);
+}
+
+static inline const char* findTokenEnd(const char* p, const char* end) {
+  while (p < end && !isBlank(*p) && *p != '\n') {
+    p++;
+  }
+  return p;
+}
+
+/// Parses a double.  Decimals with at most 15 significant digits and no
+/// exponent are exact in a double before scaling, so dividing by an exact
+/// power of ten rounds correctly; everything else is handed to strtod.
+static inline double parseDouble(const char* start, const char* tokenEnd) {
+  if (start == tokenEnd) {
+    return 0.0;
+  }
+
+  const char* q = start;
+  bool negative = (*q == '-');
+  if (*q == '-' || *q == '+') {
+    q++;
+  }
+  uint64_t mantissa = 0;
+  int numDigits = 0;
+  int numFractionDigits = 0;
+  while (q < tokenEnd && isDigit(*q)) {
+    mantissa = mantissa * 10 + (*q++ - '0');
+    numDigits++;
+  }
+  if (q < tokenEnd && *q == '.') {
+    q++;
+    while (q < tokenEnd && isDigit(*q)) {
+      mantissa = mantissa * 10 + (*q++ - '0');
+      numFractionDigits++;
+    }
+  }
+  numDigits += numFractionDigits;
+  if (q == tokenEnd && numDigits > 0 && numDigits <= 15) {
+    double value = (double)mantissa / exactPowersOfTen[numFractionDigits];
+    return negative ? -value : value;
+  }
+
+  string token(start, tokenEnd);
+  return strtod(token.c_str(), nullptr);
+}
+
+/// Parses a float.  Like parseDouble, but the mantissa is only exact in a
+/// float up to 7 digits and powers of ten up to 1e10.
+static inline float parseFloat(const char* start, const char* tokenEnd) {
+  if (start == tokenEnd) {
+    return 0.0f;
+  }
+
+  const char* q = start;
+  bool negative = (*q == '-');
+  if (*q == '-' || *q == '+') {
+    q++;
+  }
+  uint32_t mantissa = 0;
+  int numDigits = 0;
+  int numFractionDigits = 0;
+  while (q < tokenEnd && isDigit(*q) && numDigits <= 7) {
+    mantissa = mantissa * 10 + (*q++ - '0');
+    numDigits++;
+  }
+  if (q < tokenEnd && *q == '.') {
+    q++;
+    while (q < tokenEnd && isDigit(*q) && numDigits <= 7) {
+      mantissa = mantissa * 10 + (*q++ - '0');
+      numDigits++;
+      numFractionDigits++;
+    }
+  }
+  if (q == tokenEnd && numDigits > 0 && numDigits <= 7 &&
+      numFractionDigits <= 10) {
+    float value = (float)mantissa / (float)exactPowersOfTen[numFractionDigits];
+    return negative ? -value : value;
+  }
+
+  string token(start, tokenEnd);
+  return strtof(token.c_str(), nullptr);
+}
+
+/// Parses an integer (or bool, where any nonzero value is true).  Tokens that
+/// are not plain integers, such as "1.0" or "2e3", are parsed as doubles and
+/// converted.
+template <typename T>
+static inline T parseInteger(const char* start, const char* tokenEnd) {
+  const char* q = start;
+  bool negative = (q < tokenEnd && *q == '-');
+  if (q < tokenEnd && (*q == '-' || *q == '+')) {
+    q++;
+  }
+  uint64_t magnitude = 0;
+  int numDigits = 0;
+  while (q < tokenEnd && isDigit(*q)) {
+    magnitude = magnitude * 10 + (*q++ - '0');
+    numDigits++;
+  }
+  if (q == tokenEnd && numDigits > 0 && numDigits <= 18) {
+    return negative ? (T)(-(int64_t)magnitude) : (T)magnitude;
+  }
+  return (T)parseDouble(start, tokenEnd);
+}
+
+template <typename T>
+static inline void parseValue(const char** p, const char* end, T* value) {
+  const char* start = skipBlanks(*p, end);
+  *p = findTokenEnd(start, end);
+  *value = parseInteger<T>(start, *p);
+}
+
+static inline void parseValue(const char** p, const char* end, float* value) {
+  const char* start = skipBlanks(*p, end);
+  *p = findTokenEnd(start, end);
+  *value = parseFloat(start, *p);
+}
+
+static inline void parseValue(const char** p, const char* end, double* value) {
+  const char* start = skipBlanks(*p, end);
+  *p = findTokenEnd(start, end);
+  *value = parseDouble(start, *p);
+}
+
+/// Parses a complex value from a real field and an optional imaginary field.
+template <typename T>
+static inline void parseValue(const char** p, const char* end,
+                              std::complex<T>* value) {
+  T real;
+  T imag;
+  parseValue(p, end, &real);
+  parseValue(p, end, &imag);
+  *value = std::complex<T>(real, imag);
+}
+
+template <typename T>
+static inline void appendValue(vector<char>* values, T value) {
+  const size_t size = values->size();
+  values->resize(size + sizeof(T));
+  memcpy(values->data() + size, &value, sizeof(T));
+}
+
+int countFields(const char* begin, const char* end, char comment) {
+  const char* p = begin;
+  while (p < end) {
+    const char* lineEnd = findLineEnd(p, end);
+    p = skipBlanks(p, lineEnd);
+    if (p < lineEnd && *p != comment) {
+      int numFields = 0;
+      while (p < lineEnd) {
+        numFields++;
+        while (p < lineEnd && !isBlank(*p)) {
+          p++;
+        }
+        p = skipBlanks(p, lineEnd);
+      }
+      return numFields;
+    }
+    p = lineEnd + 1;
+  }
+  return 0;
+}
+
+template <typename T>
+static void parseChunk(const char* begin, const char* end, int order,
+                       char comment, int indexBase, bool pattern,
+                       bool storeValues, ParsedComponents* parsed) {
+  parsed->coordinates.resize(order);
+  parsed->maxCoordinates.resize(order, 0);
+  const char* p = begin;
+  while (p < end) {
+    const char* lineEnd = findLineEnd(p, end);
+    p = skipBlanks(p, lineEnd);
+    if (p == lineEnd || *p == comment) {
+      p = lineEnd + 1;
+      continue;
+    }
+    for (int i = 0; i < order; i++) {
+      int coordinate = parseCoordinate(&p, lineEnd);
+      parsed->maxCoordinates[i] = std::max(parsed->maxCoordinates[i],
+                                           coordinate);
+      parsed->coordinates[i].push_back(coordinate - indexBase);
+    }
+    if (storeValues) {
+      T value = T(1);
+      if (!pattern) {
+        parseValue(&p, lineEnd, &value);
+      }
+      appendValue(&parsed->values, value);
+    }
+    p = lineEnd + 1;
+  }
+}
+
+ParsedComponents parseComponents(const char* begin, const char* end, int order,
+                                 char comment, int indexBase,
+                                 Datatype valueType, bool pattern) {
+  const size_t size = end - begin;
+  const size_t numThreads =
+      std::min((size_t)std::max(taco_get_num_threads(), 1),
+               std::max(size / minBytesPerParseThread, (size_t)1));
+
+  // Every chunk but the first starts at the beginning of a line
+  vector<const char*> chunks(numThreads + 1, end);
+  chunks[0] = begin;
+  for (size_t t = 1; t < numThreads; ++t) {
+    const char* p = std::max(begin + t * size / numThreads, chunks[t-1]);
+    if (p > begin && p[-1] != '\n') {
+      p = findLineEnd(p, end);
+      p = (p < end) ? p + 1 : p;
+    }
+    chunks[t] = p;
+  }
+
+  // Pattern components have no values, so any type will do for parsing them
+  const bool storeValues = !valueType.isPattern();
+  const Datatype parseType = storeValues ? valueType : Bool;
+  vector<ParsedComponents> parsedChunks(numThreads);
+  util::parallelFor(numThreads, numThreads, [&](size_t first, size_t last) {
+    for (size_t t = first; t < last; ++t) {
+      parsedChunks[t].valueType = valueType;
+      dispatchValueType(parseType, [&](auto tag) {
+        parseChunk<decltype(tag)>(chunks[t], chunks[t+1], order, comment,
+                                  indexBase, pattern, storeValues,
+                                  &parsedChunks[t]);
+      });
+    }
+  });
+  if (numThreads == 1) {
+    return std::move(parsedChunks[0]);
+  }
+
+  // Concatenate the chunks, each thread copying its own
+  vector<size_t> offsets(numThreads + 1, 0);
+  for (size_t t = 0; t < numThreads; ++t) {
+    offsets[t+1] = offsets[t] + parsedChunks[t].getNumComponents();
+  }
+  const size_t valueSize = valueType.getNumBytes();
+  ParsedComponents parsed;
+  parsed.coordinates.resize(order, vector<int>(offsets[numThreads]));
+  parsed.valueType = valueType;
+  parsed.values.resize(offsets[numThreads] * valueSize);
+  parsed.maxCoordinates.resize(order, 0);
+  for (auto& parsedChunk : parsedChunks) {
+    for (int i = 0; i < order; i++) {
+      parsed.maxCoordinates[i] = std::max(parsed.maxCoordinates[i],
+                                          parsedChunk.maxCoordinates[i]);
+    }
+  }
+  util::parallelFor(numThreads, numThreads, [&](size_t first, size_t last) {
+    for (size_t t = first; t < last; ++t) {
+      for (int i = 0; i < order; i++) {
+        std::copy(parsedChunks[t].coordinates[i].begin(),
+                  parsedChunks[t].coordinates[i].end(),
+                  parsed.coordinates[i].begin() + offsets[t]);
+      }
+      std::copy(parsedChunks[t].values.begin(), parsedChunks[t].values.end(),
+                parsed.values.begin() + offsets[t] * valueSize);
+      parsedChunks[t] = ParsedComponents();
+    }
+  });
+  return parsed;
+}
+
+size_t parseValues(const char* begin, const char* end, Datatype valueType,
+                   void* values, size_t maxValues) {
+  size_t numValues = 0;
+  dispatchValueType(valueType, [&](auto tag) {
+    typedef decltype(tag) T;
+    T* typedValues = (T*)values;
+    const char* p = begin;
+    while (numValues < maxValues) {
+      while (p < end && (isBlank(*p) || *p == '\n')) {
+        p++;
+      }
+      if (p == end) {
+        break;
+      }
+      parseValue(&p, end, &typedValues[numValues++]);
+    }
+  });
+  return numValues;
+}
+
+void fillOnes(Datatype valueType, void* values, size_t numValues) {
+  if (valueType.isPattern()) {
+    return;
+  }
+  dispatchValueType(valueType, [&](auto tag) {
+    typedef decltype(tag) T;
+    std::fill((T*)values, (T*)values + numValues, T(1));
+  });
+}
+
+void addTranspose(ParsedComponents* parsed) {
+  taco_iassert(parsed->coordinates.size() == 2);
+  const size_t valueSize = parsed->valueType.getNumBytes();
+  const size_t nnz = parsed->getNumComponents();
+  for (size_t i = 0; i < nnz; i++) {
+    int row = parsed->coordinates[0][i];
+    int col = parsed->coordinates[1][i];
+    if (row != col) {
+      parsed->coordinates[0].push_back(col);
+      parsed->coordinates[1].push_back(row);
+      parsed->values.insert(parsed->values.end(),
+                            parsed->values.begin() + i * valueSize,
+                            parsed->values.begin() + (i+1) * valueSize);
+    }
+  }
+}
+
+void insertComponents(TensorBase& tensor, const ParsedComponents& parsed,
+                      bool pack) {
+  taco_iassert(tensor.getComponentType() == parsed.valueType);
+  const size_t numComponents = parsed.getNumComponents();
+  if (pack) {
+    vector<const int*> coordinates;
+    for (auto& modeCoordinates : parsed.coordinates) {
+      coordinates.push_back(modeCoordinates.data());
+    }
+    tensor.setFromCOO(coordinates, (const void*)parsed.values.data(),
+                     numComponents);
+    return;
+  }
+
+  tensor.reserve(numComponents);
+  vector<int> coordinate(parsed.coordinates.size());
+  if (parsed.valueType.isPattern()) {
+    for (size_t i = 0; i < numComponents; i++) {
+      for (size_t mode = 0; mode < coordinate.size(); mode++) {
+        coordinate[mode] = parsed.coordinates[mode][i];
+      }
+      tensor.insert(coordinate, true);
+    }
+    return;
+  }
+  dispatchValueType(parsed.valueType, [&](auto tag) {
+    typedef decltype(tag) T;
+    for (size_t i = 0; i < numComponents; i++) {
+      for (size_t mode = 0; mode < coordinate.size(); mode++) {
+        coordinate[mode] = parsed.coordinates[mode][i];
+      }
+      T value;
+      memcpy(&value, &parsed.values[i * sizeof(T)], sizeof(T));
+      tensor.insert(coordinate, value);
+    }
+  });
+}
+
+}
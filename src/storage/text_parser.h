@@ -0,0 +1,96 @@
+#ifndef TACO_STORAGE_TEXT_PARSER_H
+#define TACO_STORAGE_TEXT_PARSER_H
+
+#include <vector>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+
+#include "taco/type.h"
+#include "taco/error.h"
+
+namespace taco {
+class TensorBase;
+
+/// Components parsed from a text file with one component per line.
+struct ParsedComponents {
+  /// One coordinate array per mode.
+  std::vector<std::vector<int>> coordinates;
+
+  /// The values, stored contiguously as `valueType`.  Pattern components have
+  /// no values.
+  Datatype valueType;
+  std::vector<char> values;
+
+  /// The largest coordinate read in each mode, before `indexBase` was
+  /// subtracted (so for one-based files it is the inferred dimension).
+  std::vector<int> maxCoordinates;
+
+  size_t getNumComponents() const {
+    if (valueType.isPattern()) {
+      return coordinates.empty() ? 0 : coordinates[0].size();
+    }
+    return values.size() / valueType.getNumBytes();
+  }
+};
+
+/// Calls `f` with a value of the C++ type of `type`, for every component type
+/// the text readers can parse.
+template <typename F>
+void dispatchValueType(Datatype type, F&& f) {
+  switch (type.getKind()) {
+    case Datatype::Bool: f(bool()); break;
+    case Datatype::UInt8: f(uint8_t()); break;
+    case Datatype::UInt16: f(uint16_t()); break;
+    case Datatype::UInt32: f(uint32_t()); break;
+    case Datatype::UInt64: f(uint64_t()); break;
+    case Datatype::Int8: f(int8_t()); break;
+    case Datatype::Int16: f(int16_t()); break;
+    case Datatype::Int32: f(int32_t()); break;
+    case Datatype::Int64: f(int64_t()); break;
+    case Datatype::Float32: f(float()); break;
+    case Datatype::Float64: f(double()); break;
+    case Datatype::Complex64: f(std::complex<float>()); break;
+    case Datatype::Complex128: f(std::complex<double>()); break;
+    default:
+      taco_uerror << "Values of type " << type << " cannot be read from text";
+  }
+}
+
+/// Returns the number of whitespace-separated fields on the first line in
+/// [begin, end) that is neither blank nor starts with `comment`.
+int countFields(const char* begin, const char* end, char comment);
+
+/// Parse the lines in [begin, end), each of which holds `order` integer
+/// coordinates followed by a value that is parsed directly as `valueType`
+/// (complex values are a real and an imaginary field).  If `pattern` is true
+/// the lines hold no value and every component is one.  If `valueType` is
+/// Pattern any value is skipped and only the coordinates are kept.  Blank lines and lines
+/// starting with `comment` are skipped, and `indexBase` is subtracted from
+/// every coordinate.  The text is split at line boundaries into chunks that
+/// are parsed in parallel by up to taco_get_num_threads() threads.
+ParsedComponents parseComponents(const char* begin, const char* end, int order,
+                                 char comment, int indexBase,
+                                 Datatype valueType, bool pattern=false);
+
+/// Parse up to `maxValues` whitespace-separated values of type `valueType`
+/// from [begin, end) into `values`.  Returns the number of values parsed.
+size_t parseValues(const char* begin, const char* end, Datatype valueType,
+                   void* values, size_t maxValues);
+
+/// Set `numValues` values of type `valueType` to one.  Does nothing for
+/// Pattern, which has no values.
+void fillOnes(Datatype valueType, void* values, size_t numValues);
+
+/// Add the transpose of every off-diagonal component of a parsed matrix, for
+/// symmetric files that only store one triangle.
+void addTranspose(ParsedComponents* parsed);
+
+/// Insert the parsed components into a tensor of matching order and component
+/// type.  If `pack` is true they are handed to the tensor in bulk and packed;
+/// otherwise they are inserted one by one and left unpacked.
+void insertComponents(TensorBase& tensor, const ParsedComponents& parsed,
+                      bool pack);
+
+}
+#endif
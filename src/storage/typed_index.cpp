@@ -27,6 +27,7 @@ size_t TypedIndex::getAsIndex(const IndexTypeUnion& mem) const {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror; return 0;
   }
   taco_unreachable;
@@ -50,6 +51,7 @@ void TypedIndex::set(IndexTypeUnion& mem, const IndexTypeUnion& value) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror;
   }
 }
@@ -71,6 +73,7 @@ void TypedIndex::setInt(IndexTypeUnion& mem, const int value) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror;
   }
 }
@@ -92,6 +95,7 @@ void TypedIndex::add(IndexTypeUnion& result, const IndexTypeUnion& a, const Inde
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror;
   }
 }
@@ -113,6 +117,7 @@ void TypedIndex::addInt(IndexTypeUnion& result, const IndexTypeUnion& a, const i
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror;
   }
 }
@@ -134,6 +139,7 @@ void TypedIndex::multiply(IndexTypeUnion& result, const IndexTypeUnion& a, const
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror;
   }
 }
@@ -155,6 +161,7 @@ void TypedIndex::multiplyInt(IndexTypeUnion& result, const IndexTypeUnion& a, co
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror;
   }
 }
@@ -218,6 +225,7 @@ void TypedIndexVal::set(TypedComponentVal value) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror; return;  }
 }
 
@@ -239,6 +247,7 @@ void TypedIndexVal::set(TypedComponentRef value) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror; return;  }
 }
 
@@ -430,6 +439,7 @@ bool operator>(const TypedIndexVal& a, const TypedIndexVal &other) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror; return false;
   }
   taco_unreachable;
@@ -454,6 +464,7 @@ bool operator==(const TypedIndexVal& a, const TypedIndexVal &other) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror; return false;
   }
   taco_unreachable;
@@ -493,6 +504,7 @@ bool operator>(const TypedIndexVal& a, const int other) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror; return false;
   }
   taco_unreachable;
@@ -516,6 +528,7 @@ bool operator==(const TypedIndexVal& a, const int other) {
     case Datatype::Float64:
     case Datatype::Complex64:
     case Datatype::Complex128:
+    case Datatype::Pattern:
     case Datatype::Undefined: taco_ierror; return false;
   }
   taco_unreachable;
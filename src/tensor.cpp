@@ -9,6 +9,10 @@
 #include <vector>
 #include <utility>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <functional>
+#include <algorithm>
 
 #include "taco/cuda.h"
 #include "taco/format.h"
@@ -21,10 +25,15 @@
 //#include "codegen/codegen_cuda.h"
 //#include "taco/taco_tensor_t.h"
 #include "taco/index_notation/index_notation_visitor.h"
+#include "taco/index_notation/index_notation_rewriter.h"
 #include "taco/index_notation/transformations.h"
 #include "taco/ir/ir.h"
 #include "taco/ir/ir_printer.h"
 #include "taco/lower/lower.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_bitmap.h"
+#include "taco/lower/mode_format_rle.h"
+#include "taco/lower/mode_format_sell.h"
 #include "taco/storage/storage.h"
 #include "taco/storage/index.h"
 #include "taco/storage/array.h"
@@ -32,11 +41,14 @@
 #include "taco/storage/file_io_tns.h"
 #include "taco/storage/file_io_mtx.h"
 #include "taco/storage/file_io_rb.h"
+#include "taco/storage/file_io_ttb.h"
 #include "taco/storage/typed_vector.h"
 #include "taco/util/collections.h"
 #include "taco/util/strings.h"
 #include "taco/util/timers.h"
 #include "taco/util/name_generator.h"
+#include "taco/util/thread_pool.h"
+#include "taco/util/env.h"
 
 #include "codegen/codegen_c.h"
 #include "codegen/codegen_cuda.h"
@@ -91,6 +103,19 @@ static Format initFormat(Format format) {
       } else if (modeType.getName() == Singleton.getName()) {
         arrayTypes.push_back(Int32);
         arrayTypes.push_back(Int32);
+      } else if (modeType.getName() == Hashed.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(Int32);
+      } else if (modeType.getName() == Bitmap.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(UInt64);
+      } else if (modeType.getName() == RLE.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(Int32);
+      } else if (modeType.getName() == Sell.getName()) {
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(Int32);
+        arrayTypes.push_back(Int32);
       } else {
         taco_not_supported_yet;
       }
@@ -107,6 +132,8 @@ TensorBase::TensorBase(string name, Datatype ctype, vector<int> dimensions,
   taco_uassert((size_t)format.getOrder() == dimensions.size()) <<
       "The number of format mode types (" << format.getOrder() << ") " <<
       "must match the tensor order (" << dimensions.size() << ").";
+  taco_uassert(!ctype.isPattern() || !dimensions.empty()) <<
+      "Scalars cannot have pattern components";
 
   content->allocSize = 1 << 20;
 
@@ -114,9 +141,21 @@ TensorBase::TensorBase(string name, Datatype ctype, vector<int> dimensions,
   // Initialize dense storage modes
   // TODO: Get rid of this and make code use dimensions instead of dense indices
   for (int i = 0; i < format.getOrder(); ++i) {
-    if (format.getModeFormats()[i].getName() == Dense.getName()) {
+    if (format.getModeFormats()[i].getName() == Dense.getName() ||
+        format.getModeFormats()[i].getName() == Bitmap.getName()) {
       const size_t idx = format.getModeOrdering()[i];
       modeIndices[i] = ModeIndex({makeArray({content->dimensions[idx]})});
+    } else if (format.getModeFormats()[i].getName() == Hashed.getName()) {
+      // The tables of the last level start small and grow as the level is
+      // assembled, while the tables of levels above other levels never grow
+      const size_t idx = format.getModeOrdering()[i];
+      const auto hashed = std::dynamic_pointer_cast<const HashedModeFormat>(
+          format.getModeFormats()[i].impl);
+      taco_iassert(hashed != nullptr);
+      const bool isLastLevel = (i == format.getOrder() - 1);
+      const int width = hashed->getTableWidth(
+          isLastLevel ? 0 : content->dimensions[idx]);
+      modeIndices[i] = ModeIndex({makeArray({width})});
     }
   }
   content->storage.setIndex(Index(format, modeIndices));
@@ -234,19 +273,293 @@ void TensorBase::setAssembleWhileCompute(bool assembleWhileCompute) {
   content->assembleWhileCompute = assembleWhileCompute;
 }
 
-static size_t numIntegersToCompare = 0;
-static int lexicographicalCmp(const void* a, const void* b) {
-  for (size_t i = 0; i < numIntegersToCompare; i++) {
-    int diff = ((int*)a)[i] - ((int*)b)[i];
-    if (diff != 0) {
-      return diff;
+/// Returns true if coordinate `a` precedes coordinate `b` lexicographically.
+/// The order is passed in rather than kept in a global so that tensors can be
+/// packed concurrently.
+static inline bool lexicographicalLess(const int* a, const int* b, int order) {
+  for (int i = 0; i < order; i++) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i];
+    }
+  }
+  return false;
+}
+
+/// Reorder records so that position i holds the record that was at perm[i].
+static void permuteRecords(char* records, size_t numRecords, size_t recordSize,
+                           const vector<size_t>& perm) {
+  vector<char> sorted(numRecords * recordSize);
+  for (size_t i = 0; i < numRecords; ++i) {
+    memcpy(&sorted[i * recordSize], &records[perm[i] * recordSize], recordSize);
+  }
+  memcpy(records, sorted.data(), sorted.size());
+}
+
+/// A 128-bit radix sort key, for coordinates that do not fit in 64 bits.
+struct Key128 {
+  uint64_t lo = 0;
+  uint64_t hi = 0;
+};
+
+static inline void appendBits(uint64_t* key, int value, int bits) {
+  *key = (bits == 0) ? *key : ((*key << bits) | (uint64_t)value);
+}
+
+static inline void appendBits(Key128* key, int value, int bits) {
+  if (bits == 0) {
+    return;
+  }
+  key->hi = (key->hi << bits) | (key->lo >> (64 - bits));
+  key->lo = (key->lo << bits) | (uint64_t)value;
+}
+
+static inline unsigned digit(uint64_t key, int shift) {
+  return (unsigned)(key >> shift) & 0xff;
+}
+
+static inline unsigned digit(const Key128& key, int shift) {
+  return (shift < 64) ? digit(key.lo, shift) : digit(key.hi, shift - 64);
+}
+
+/// Sort coordinate records with an LSD radix sort over keys that concatenate
+/// the coordinates of each record, `bits[d]` bits per mode.  Returns false,
+/// leaving the records untouched, if some coordinate is out of bounds.
+template <typename Key>
+static bool radixSortCoordinates(char* records, size_t numRecords,
+                                 size_t recordSize, const vector<int>& bits) {
+  const int order = (int)bits.size();
+  vector<Key> keys(numRecords);
+  for (size_t i = 0; i < numRecords; ++i) {
+    const int* coordinate = (const int*)&records[i * recordSize];
+    Key key = Key();
+    for (int d = 0; d < order; ++d) {
+      if (coordinate[d] < 0 || (bits[d] < 31 && coordinate[d] >> bits[d])) {
+        return false;
+      }
+      appendBits(&key, coordinate[d], bits[d]);
+    }
+    keys[i] = key;
+  }
+
+  int numKeyBits = 0;
+  for (int b : bits) {
+    numKeyBits += b;
+  }
+  const int numPasses = (numKeyBits + 7) / 8;
+
+  // Count the digits of every pass up front so each pass reads the keys once
+  vector<size_t> counts(numPasses * 256, 0);
+  for (const Key& key : keys) {
+    for (int p = 0; p < numPasses; ++p) {
+      counts[p * 256 + digit(key, 8 * p)]++;
+    }
+  }
+
+  vector<size_t> perm(numRecords);
+  for (size_t i = 0; i < numRecords; ++i) {
+    perm[i] = i;
+  }
+  vector<Key> sortedKeys(numRecords);
+  vector<size_t> sortedPerm(numRecords);
+  for (int p = 0; p < numPasses; ++p) {
+    size_t* count = &counts[p * 256];
+    if (count[digit(keys[0], 8 * p)] == numRecords) {
+      continue;  // Every key has the same digit, so the pass is a no-op
+    }
+    size_t offset = 0;
+    for (int d = 0; d < 256; ++d) {
+      const size_t c = count[d];
+      count[d] = offset;
+      offset += c;
+    }
+    for (size_t i = 0; i < numRecords; ++i) {
+      const size_t dst = count[digit(keys[i], 8 * p)]++;
+      sortedKeys[dst] = keys[i];
+      sortedPerm[dst] = perm[i];
+    }
+    keys.swap(sortedKeys);
+    perm.swap(sortedPerm);
+  }
+
+  permuteRecords(records, numRecords, recordSize, perm);
+  return true;
+}
+
+/// Sort coordinate records lexicographically.  Coordinates that can be packed
+/// into 64- or 128-bit keys, given the dimensions, are radix sorted; anything
+/// else falls back to a comparison sort.
+static void sortCoordinateRun(char* records, size_t numRecords,
+                              size_t recordSize, const vector<int>& dimensions) {
+  if (numRecords < 2) {
+    return;
+  }
+  vector<int> bits(dimensions.size());
+  int numKeyBits = 0;
+  for (size_t d = 0; d < dimensions.size(); ++d) {
+    while (bits[d] < 31 && (1u << bits[d]) < (unsigned)dimensions[d]) {
+      bits[d]++;
+    }
+    numKeyBits += bits[d];
+  }
+  if (numKeyBits <= 64 &&
+      radixSortCoordinates<uint64_t>(records, numRecords, recordSize, bits)) {
+    return;
+  }
+  if (numKeyBits > 64 && numKeyBits <= 128 &&
+      radixSortCoordinates<Key128>(records, numRecords, recordSize, bits)) {
+    return;
+  }
+  const int order = (int)dimensions.size();
+  vector<size_t> perm(numRecords);
+  for (size_t i = 0; i < numRecords; ++i) {
+    perm[i] = i;
+  }
+  std::sort(perm.begin(), perm.end(), [&](size_t a, size_t b) {
+    return lexicographicalLess((const int*)&records[a * recordSize],
+                               (const int*)&records[b * recordSize], order);
+  });
+  permuteRecords(records, numRecords, recordSize, perm);
+}
+
+/// Minimum number of coordinates each thread must be given before pack()
+/// splits its work across threads; below it thread startup dominates.
+static const size_t minCoordinatesPerPackThread = 1 << 15;
+
+static size_t getNumPackThreads(size_t numCoordinates) {
+  const size_t maxThreads = std::max(numCoordinates / minCoordinatesPerPackThread,
+                                     (size_t)1);
+  return std::min((size_t)std::max(taco_get_num_threads(), 1), maxThreads);
+}
+
+/// Merge the sorted records in `a` and `b` into `dst`, which must not overlap
+/// either of them.
+static void mergeCoordinates(const char* a, size_t numA, const char* b,
+                             size_t numB, char* dst, size_t coordSize,
+                             int order) {
+  size_t i = 0, j = 0;
+  while (i < numA && j < numB) {
+    const char* recordA = &a[i * coordSize];
+    const char* recordB = &b[j * coordSize];
+    if (lexicographicalLess((const int*)recordB, (const int*)recordA, order)) {
+      memcpy(dst, recordB, coordSize);
+      j++;
+    } else {
+      memcpy(dst, recordA, coordSize);
+      i++;
+    }
+    dst += coordSize;
+  }
+  memcpy(dst, &a[i * coordSize], (numA - i) * coordSize);
+  dst += (numA - i) * coordSize;
+  memcpy(dst, &b[j * coordSize], (numB - j) * coordSize);
+}
+
+static bool isSortedCoordinates(const char* coordinates, size_t numCoordinates,
+                                size_t coordSize, int order) {
+  for (size_t i = 1; i < numCoordinates; ++i) {
+    if (lexicographicalLess((const int*)&coordinates[i * coordSize],
+                            (const int*)&coordinates[(i-1) * coordSize],
+                            order)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Sort `numCoordinates` records of `coordSize` bytes. Every thread sorts one
+/// contiguous run, after which the runs are merged pairwise (with the merges of
+/// each round running in parallel), ping-ponging between the coordinate buffer
+/// and `buffer`. Returns whichever of the two holds the sorted records.
+static char* sortCoordinates(char* coordinates, size_t numCoordinates,
+                             size_t coordSize, const vector<int>& dimensions,
+                             size_t numThreads, vector<char>* buffer) {
+  if (numThreads <= 1) {
+    sortCoordinateRun(coordinates, numCoordinates, coordSize, dimensions);
+    return coordinates;
+  }
+
+  const int order = (int)dimensions.size();
+  vector<size_t> runs(numThreads + 1);
+  for (size_t t = 0; t <= numThreads; ++t) {
+    runs[t] = t * numCoordinates / numThreads;
+  }
+  util::parallelFor(numThreads, numThreads, [&](size_t begin, size_t end) {
+    for (size_t t = begin; t < end; ++t) {
+      sortCoordinateRun(&coordinates[runs[t] * coordSize], runs[t+1] - runs[t],
+                        coordSize, dimensions);
+    }
+  });
+
+  buffer->resize(numCoordinates * coordSize);
+  char* src = coordinates;
+  char* dst = buffer->data();
+  while (runs.size() > 2) {
+    const size_t numRuns = runs.size() - 1;
+    const size_t numMerges = (numRuns + 1) / 2;
+    util::parallelFor(numMerges, numMerges, [&](size_t begin, size_t end) {
+      for (size_t m = begin; m < end; ++m) {
+        const size_t lo = runs[2*m];
+        const size_t mid = runs[std::min(2*m + 1, numRuns)];
+        const size_t hi = runs[std::min(2*m + 2, numRuns)];
+        mergeCoordinates(&src[lo * coordSize], mid - lo,
+                         &src[mid * coordSize], hi - mid,
+                         &dst[lo * coordSize], coordSize, order);
+      }
+    });
+    vector<size_t> mergedRuns;
+    for (size_t r = 0; r < numRuns; r += 2) {
+      mergedRuns.push_back(runs[r]);
+    }
+    mergedRuns.push_back(numCoordinates);
+    runs = mergedRuns;
+    std::swap(src, dst);
+  }
+  return src;
+}
+
+/// Returns element `i` of an index array of type `type`.
+static size_t loadIndex(Datatype type, const uint8_t* array, size_t i) {
+  taco_iassert(type == Int32 || type == Int64);
+  return (type == Int64) ? (size_t)((const int64_t*)array)[i]
+                         : (size_t)((const int32_t*)array)[i];
+}
+
+/// Merges the adjacent runs of the fibers of a run-length encoded level that
+/// hold equal values, and returns the number of runs left.  Only the last level
+/// of a tensor can merge runs, since the runs of other levels lead to subtrees.
+static size_t mergeRuns(int32_t* pos, int32_t* runs, uint8_t* vals,
+                        size_t numFibers, size_t csize) {
+  size_t numRuns = 0;
+  int32_t fiberBegin = pos[0];
+  for (size_t f = 0; f < numFibers; f++) {
+    const int32_t fiberEnd = pos[f+1];
+    const size_t fiberRuns = numRuns;
+    for (int32_t r = fiberBegin; r < fiberEnd; r++) {
+      const bool merge = numRuns > fiberRuns &&
+          runs[2*numRuns-1] == runs[2*r] &&
+          (vals == nullptr ||
+           memcmp(&vals[(numRuns-1)*csize], &vals[r*csize], csize) == 0);
+      if (merge) {
+        runs[2*numRuns-1] = runs[2*r+1];
+        continue;
+      }
+      runs[2*numRuns] = runs[2*r];
+      runs[2*numRuns+1] = runs[2*r+1];
+      if (vals != nullptr && (size_t)r != numRuns) {
+        memcpy(&vals[numRuns*csize], &vals[r*csize], csize);
+      }
+      numRuns++;
     }
+    pos[f] = (int32_t)fiberRuns;
+    fiberBegin = fiberEnd;
   }
-  return 0;
+  pos[numFibers] = (int32_t)numRuns;
+  return numRuns;
 }
 
 static size_t unpackTensorData(const taco_tensor_t& tensorData,
-                               const TensorBase& tensor) {
+                               const TensorBase& tensor,
+                               bool hasValues=true) {
   auto storage = tensor.getStorage();
   auto format = storage.getFormat();
 
@@ -259,36 +572,95 @@ static size_t unpackTensorData(const taco_tensor_t& tensorData,
       modeIndices.push_back(ModeIndex({size}));
       numVals *= ((int*)tensorData.indices[i][0])[0];
     } else if (modeType.getName() == Sparse.getName()) {
-      auto size = ((int*)tensorData.indices[i][0])[numVals];
-      Array pos = Array(type<int>(), tensorData.indices[i][0], numVals+1, Array::UserOwns);
-      Array idx = Array(type<int>(), tensorData.indices[i][1], size, Array::UserOwns);
+      Datatype posType = format.getCoordinateTypePos(i);
+      Datatype idxType = format.getCoordinateTypeIdx(i);
+      auto size = loadIndex(posType, tensorData.indices[i][0], numVals);
+      Array pos = Array(posType, tensorData.indices[i][0], numVals+1, Array::UserOwns);
+      Array idx = Array(idxType, tensorData.indices[i][1], size, Array::UserOwns);
       modeIndices.push_back(ModeIndex({pos, idx}));
       numVals = size;
     } else if (modeType.getName() == Singleton.getName()) {
-      Array idx = Array(type<int>(), tensorData.indices[i][1], numVals, Array::UserOwns);
+      Datatype idxType = format.getCoordinateTypeIdx(i);
+      Array idx = Array(idxType, tensorData.indices[i][1], numVals, Array::UserOwns);
       modeIndices.push_back(ModeIndex({makeArray(type<int>(), 0), idx}));
+    } else if (modeType.getName() == Hashed.getName()) {
+      Array width = makeArray({*(int*)tensorData.indices[i][0]});
+      numVals *= ((int*)tensorData.indices[i][0])[0];
+      Array idx = Array(type<int>(), tensorData.indices[i][1], numVals, Array::UserOwns);
+      modeIndices.push_back(ModeIndex({width, idx}));
+    } else if (modeType.getName() == Bitmap.getName()) {
+      Array size = makeArray({*(int*)tensorData.indices[i][0]});
+      numVals *= ((int*)tensorData.indices[i][0])[0];
+      Array bitmap = Array(UInt64, tensorData.indices[i][1],
+                           BitmapModeFormat::getNumWords(numVals),
+                           Array::UserOwns);
+      modeIndices.push_back(ModeIndex({size, bitmap}));
+    } else if (modeType.getName() == RLE.getName()) {
+      int32_t* pos = (int32_t*)tensorData.indices[i][0];
+      int32_t* runs = (int32_t*)tensorData.indices[i][1];
+      size_t size = pos[numVals];
+      if (i == tensor.getOrder() - 1 && hasValues) {
+        const Datatype ctype = tensor.getComponentType();
+        size = mergeRuns(pos, runs, ctype.isPattern() ? nullptr
+                                                      : tensorData.vals,
+                         numVals, ctype.getNumBytes());
+      }
+      Array posArray = Array(Int32, pos, numVals+1, Array::UserOwns);
+      Array runsArray = Array(Int32, runs, 2*size, Array::UserOwns);
+      modeIndices.push_back(ModeIndex({posArray, runsArray}));
+      numVals = size;
     } else {
       taco_not_supported_yet;
     }
   }
   storage.setIndex(Index(format, modeIndices));
-  storage.setValues(Array(tensor.getComponentType(), tensorData.vals, numVals));
+  // Kernels never allocate values for pattern tensors, so their values pointer
+  // is still the one of the previous values array
+  storage.setValues(tensor.getComponentType().isPattern()
+                    ? makeArray(tensor.getComponentType(), numVals)
+                    : Array(tensor.getComponentType(), tensorData.vals, numVals));
   return numVals;
 }
 
 /// Pack coordinates into a data structure given by the tensor format.
+/// Returns the positions {0, numCoordinates} of the coordinate buffer that is
+/// packed into a tensor of the given format.  The buffer's positions have the
+/// type of the format's positions, so that formats with 64-bit positions can
+/// pack more than 2^31-1 components.
+static Array makeBufferPos(const Format& format, size_t numCoordinates) {
+  const Datatype posType = format.getPositionType();
+  Array pos = makeArray(posType, 2);
+  if (posType == Int64) {
+    ((int64_t*)pos.getData())[0] = 0;
+    ((int64_t*)pos.getData())[1] = (int64_t)numCoordinates;
+  } else {
+    taco_uassert(numCoordinates <= INT_MAX) << "Cannot pack "
+        << numCoordinates << " components into a format with 32-bit "
+        << "positions, which holds at most " << INT_MAX << " components";
+    ((int32_t*)pos.getData())[0] = 0;
+    ((int32_t*)pos.getData())[1] = (int32_t)numCoordinates;
+  }
+  return pos;
+}
+
 void TensorBase::pack() {
   if (!needsPack()) {
     return;
   }
   setNeedsPack(false);
 
+  taco_iassert((content->coordinateBufferUsed % content->coordinateSize) == 0);
+  const size_t numNewCoordinates =
+      content->coordinateBufferUsed / content->coordinateSize;
+
   if (neverPacked()) {
     unsetNeverPacked();
   } else {
-    // Reinsert packed components into temporary buffer and repack them along
-    // with unpacked components. This is needed to implement increment
-    // semantics.
+    // Reinsert packed components into temporary buffer, after the new
+    // components, and repack them along with the new components. This is
+    // needed to implement increment semantics. The packed components come
+    // out in storage order, so only the new components are sorted below and
+    // the two are then merged in linear time.
     // TODO: Change to using code that adds packed components (stored in packed
     //       data structure) with unpacked components (stored in temporary
     //       buffer). We can already generate such code, but currently
@@ -333,6 +705,9 @@ void TensorBase::pack() {
       case Datatype::Complex128:
         reinsertPackedComponents<std::complex<double>>();
         break;
+      case Datatype::Pattern:
+        reinsertPackedComponents<bool>();
+        break;
       default:
         taco_ierror << "unsupported type";
         break;
@@ -346,11 +721,10 @@ void TensorBase::pack() {
   taco_iassert((content->coordinateBufferUsed % content->coordinateSize) == 0);
   const size_t numCoordinates = content->coordinateBufferUsed / content->coordinateSize;
 
-  const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType(),
-                                              dimensions);
-
   // Pack scalars
   if (order == 0) {
+    const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType(),
+                                                dimensions);
     Array array = makeArray(getComponentType(), 1);
 
     std::vector<taco_mode_t> bufferModeType = {taco_mode_sparse};
@@ -360,8 +734,8 @@ void TensorBase::pack() {
     taco_tensor_t* bufferStorage = init_taco_tensor_t(1, csize,
         (int32_t*)bufferDim.data(), (int32_t*)bufferModeOrdering.data(),
         (taco_mode_t*)bufferModeType.data());
-    std::vector<int> pos = {0, (int)numCoordinates};
-    bufferStorage->indices[0][0] = (uint8_t*)pos.data();
+    Array pos = makeBufferPos(getFormat(), numCoordinates);
+    bufferStorage->indices[0][0] = (uint8_t*)pos.getData();
     bufferStorage->indices[0][1] = (uint8_t*)bufferCoords.data();
     bufferStorage->vals = (uint8_t*)content->coordinateBuffer->data();
 
@@ -386,23 +760,43 @@ void TensorBase::pack() {
 
   const size_t coordSize = content->coordinateSize;
   char* coordinatesPtr = content->coordinateBuffer->data();
-  vector<int> permuteBuffer(order);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordinate = (int*)coordinatesPtr;
-    for (int j = 0; j < order; j++) {
-      permuteBuffer[j] = coordinate[permutation[j]];
-    }
-    for (int j = 0; j < order; j++) {
-      coordinate[j] = permuteBuffer[j];
+  const size_t numThreads = getNumPackThreads(numCoordinates);
+  util::parallelFor(numCoordinates, numThreads,
+                    [&](size_t begin, size_t end) {
+    vector<int> permuteBuffer(order);
+    for (size_t i = begin; i < end; ++i) {
+      int* coordinate = (int*)&coordinatesPtr[i * coordSize];
+      for (int j = 0; j < order; j++) {
+        permuteBuffer[j] = coordinate[permutation[j]];
+      }
+      for (int j = 0; j < order; j++) {
+        coordinate[j] = permuteBuffer[j];
+      }
     }
-    coordinatesPtr += content->coordinateSize;
-  }
-  coordinatesPtr = content->coordinateBuffer->data();
+  });
 
   // The pack code expects the coordinates to be sorted
-  numIntegersToCompare = order;
-  qsort(coordinatesPtr, numCoordinates, coordSize, lexicographicalCmp);
-
+  std::vector<char> sortBuffer;
+  std::vector<char> mergeBuffer;
+  const size_t numPackedCoordinates = numCoordinates - numNewCoordinates;
+  char* packedCoordinatesPtr = &coordinatesPtr[numNewCoordinates * coordSize];
+  if (numPackedCoordinates > 0 &&
+      isSortedCoordinates(packedCoordinatesPtr, numPackedCoordinates,
+                          coordSize, order)) {
+    const char* newCoordinatesPtr =
+        sortCoordinates(coordinatesPtr, numNewCoordinates, coordSize,
+                        permutedDimensions,
+                        getNumPackThreads(numNewCoordinates), &sortBuffer);
+    mergeBuffer.resize(numCoordinates * coordSize);
+    mergeCoordinates(packedCoordinatesPtr, numPackedCoordinates,
+                     newCoordinatesPtr, numNewCoordinates, mergeBuffer.data(),
+                     coordSize, order);
+    coordinatesPtr = mergeBuffer.data();
+  } else {
+    coordinatesPtr = sortCoordinates(coordinatesPtr, numCoordinates, coordSize,
+                                     permutedDimensions, numThreads,
+                                     &sortBuffer);
+  }
 
   // Move coords into separate arrays
   std::vector<std::vector<int>> coordinates(order);
@@ -410,45 +804,232 @@ void TensorBase::pack() {
     coordinates[i] = std::vector<int>(numCoordinates);
   }
   char* values = (char*) malloc(numCoordinates * csize);
-  for (size_t i = 0; i < numCoordinates; ++i) {
-    int* coordLoc = (int*)&coordinatesPtr[i * coordSize];
-    for (int d = 0; d < order; ++d) {
-      coordinates[d][i] = *coordLoc;
-      coordLoc++;
+  util::parallelFor(numCoordinates, numThreads,
+                    [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      int* coordLoc = (int*)&coordinatesPtr[i * coordSize];
+      for (int d = 0; d < order; ++d) {
+        coordinates[d][i] = *coordLoc;
+        coordLoc++;
+      }
+      memcpy(&values[i * csize], coordLoc, csize);
     }
-    memcpy(&values[i * csize], coordLoc, csize);
-  }
-
+  });
 
   content->coordinateBuffer->clear();
   content->coordinateBufferUsed = 0;
 
+  std::vector<const int*> coordinateArrays(order);
+  for (int i = 0; i < order; ++i) {
+    coordinateArrays[i] = coordinates[i].data();
+  }
+  packSortedCoordinates(coordinateArrays, values, numCoordinates);
+  free(values);
+}
+
+void TensorBase::packSortedCoordinates(
+    const std::vector<const int*>& coordinates, const void* values,
+    size_t numCoordinates) {
+  const int order = getOrder();
+  const int csize = getComponentType().getNumBytes();
+  const std::vector<int>& dimensions = getDimensions();
+  std::vector<int> permutation = getFormat().getModeOrdering();
+
+  // SELL levels cannot be assembled by kernels, so the coordinates are packed
+  // into compressed fibers that are then sliced and padded
+  const ModeFormat lastModeFormat = getFormat().getModeFormats()[order - 1];
+  if (lastModeFormat.getName() == Sell.getName()) {
+    std::vector<ModeFormatPack> fiberModeFormats;
+    int numFibers = 1;
+    for (int i = 0; i < order - 1; ++i) {
+      taco_uassert(getFormat().getModeFormats()[i].getName() ==
+                   Dense.getName()) <<
+          "SELL levels can only be packed below dense levels";
+      fiberModeFormats.push_back(Dense);
+      numFibers *= dimensions[permutation[i]];
+    }
+    fiberModeFormats.push_back(Compressed);
+    TensorBase fibers(getComponentType(), dimensions,
+                      Format(fiberModeFormats, permutation));
+    fibers.packSortedCoordinates(coordinates, values, numCoordinates);
+
+    const Index& fiberIndex = fibers.getStorage().getIndex();
+    const ModeIndex fiberModeIndex = fiberIndex.getModeIndex(order - 1);
+    const int* fiberPos = (const int*)fiberModeIndex.getIndexArray(0).getData();
+    const int* fiberCrd = (const int*)fiberModeIndex.getIndexArray(1).getData();
+    const char* fiberVals =
+        (const char*)fibers.getStorage().getValues().getData();
+
+    const auto sell = std::dynamic_pointer_cast<const SellModeFormat>(
+        lastModeFormat.impl);
+    taco_iassert(sell != nullptr);
+    const int sliceHeight = sell->getSliceHeight();
+    const int sortingScope = sell->getSortingScope();
+    const int numSlices = (numFibers + sliceHeight - 1) / sliceHeight;
+
+    // Sort the fibers of every window of sortingScope fibers by decreasing
+    // length, so that fibers of similar lengths share slices
+    auto fiberLength = [&](int p) {
+      return (p < numFibers) ? fiberPos[p + 1] - fiberPos[p] : 0;
+    };
+    std::vector<int> sortedFibers(numSlices * sliceHeight);
+    std::iota(sortedFibers.begin(), sortedFibers.end(), 0);
+    if (sortingScope > 1) {
+      for (int w = 0; w < numFibers; w += sortingScope) {
+        std::stable_sort(sortedFibers.begin() + w,
+                         sortedFibers.begin() +
+                             std::min(w + sortingScope, numFibers),
+                         [&](int a, int b) {
+                           return fiberLength(a) > fiberLength(b);
+                         });
+      }
+    }
+
+    // Every slice is as wide as its longest fiber
+    Array pos = makeArray(Int32, numSlices + 1);
+    int* posData = (int*)pos.getData();
+    posData[0] = 0;
+    for (int s = 0; s < numSlices; ++s) {
+      int width = 0;
+      for (int f = s * sliceHeight; f < (s + 1) * sliceHeight; ++f) {
+        width = std::max(width, fiberLength(sortedFibers[f]));
+      }
+      posData[s + 1] = posData[s] + width * sliceHeight;
+    }
+
+    const int size = posData[numSlices];
+    Array crd = makeArray(Int32, size);
+    int* crdData = (int*)crd.getData();
+    std::fill(crdData, crdData + size, -1);
+    Array vals = makeArray(getComponentType(), size);
+    char* valsData = (char*)vals.getData();
+    memset(valsData, 0, (size_t)size * csize);
+    for (int f = 0; f < numSlices * sliceHeight; ++f) {
+      const int p = sortedFibers[f];
+      if (p >= numFibers) {
+        continue;
+      }
+      const int begin = posData[f / sliceHeight] + f % sliceHeight;
+      for (int k = fiberPos[p]; k < fiberPos[p + 1]; ++k) {
+        const int slot = begin + (k - fiberPos[p]) * sliceHeight;
+        crdData[slot] = fiberCrd[k];
+        memcpy(&valsData[(size_t)slot * csize],
+               &fiberVals[(size_t)k * csize], csize);
+      }
+    }
+
+    // Fibers that are not sorted are sliced in order and need no permutation
+    Array perm = makeArray((sortingScope > 1) ? sortedFibers
+                                              : std::vector<int>());
+
+    std::vector<ModeIndex> modeIndices;
+    for (int i = 0; i < order - 1; ++i) {
+      modeIndices.push_back(fiberIndex.getModeIndex(i));
+    }
+    modeIndices.push_back(ModeIndex({pos, crd, perm}));
+    content->storage.setIndex(Index(getFormat(), modeIndices));
+    content->storage.setValues(vals);
+    content->valuesSize = size;
+    return;
+  }
+
+  const auto helperFuncs = getHelperFunctions(getFormat(), getComponentType(),
+                                              dimensions);
 
   std::vector<taco_mode_t> bufferModeTypes(order, taco_mode_sparse);
   taco_tensor_t* bufferStorage = init_taco_tensor_t(order, csize,
       (int32_t*)dimensions.data(), (int32_t*)permutation.data(),
       (taco_mode_t*)bufferModeTypes.data());
-  std::vector<int> pos = {0, (int)numCoordinates};
-  bufferStorage->indices[0][0] = (uint8_t*)pos.data();
+  Array pos = makeBufferPos(getFormat(), numCoordinates);
+  bufferStorage->indices[0][0] = (uint8_t*)pos.getData();
   for (int i = 0; i < order; ++i) {
-    bufferStorage->indices[i][1] = (uint8_t*)coordinates[i].data();
+    bufferStorage->indices[i][1] = (uint8_t*)coordinates[i];
   }
   bufferStorage->vals = (uint8_t*)values;
 
+  // Size the hash tables of a hashed last level from its largest fiber, so
+  // that packing never grows them
+  if (lastModeFormat.getName() == Hashed.getName()) {
+    int maxFiberSize = 0;
+    int fiberSize = 0;
+    for (size_t i = 0; i < numCoordinates; ++i) {
+      int firstChangedLevel = (i == 0) ? 0 : order;
+      for (int l = 0; l < order && firstChangedLevel == order; ++l) {
+        if (coordinates[l][i] != coordinates[l][i-1]) {
+          firstChangedLevel = l;
+        }
+      }
+      if (firstChangedLevel < order - 1) {
+        fiberSize = 0;
+      }
+      if (firstChangedLevel < order) {
+        maxFiberSize = std::max(maxFiberSize, ++fiberSize);
+      }
+    }
+    const auto hashed = std::dynamic_pointer_cast<const HashedModeFormat>(
+        lastModeFormat.impl);
+    taco_iassert(hashed != nullptr);
+    Array width = content->storage.getIndex().getModeIndex(order - 1)
+                                             .getIndexArray(0);
+    ((int*)width.getData())[0] = hashed->getTableWidth(maxFiberSize);
+  }
+
   // Pack nonzero components into required format
   std::vector<void*> arguments = {content->storage, bufferStorage};
   helperFuncs->callFuncPacked("pack", arguments.data());
   content->valuesSize = unpackTensorData(*((taco_tensor_t*)arguments[0]), *this);
 
-  free(values);
   deinit_taco_tensor_t(bufferStorage);
 }
 
+void TensorBase::setFromCOO(const std::vector<const int*>& coordinates,
+                            const void* values, size_t numComponents,
+                            bool sorted) {
+  taco_uassert(coordinates.size() == (size_t)getOrder()) <<
+      "Wrong number of coordinate arrays";
+  syncDependentTensors();
+
+  // Drop the current components, so that the tensor only holds the new ones
+  content->coordinateBuffer->clear();
+  content->coordinateBufferUsed = 0;
+  content->neverPacked = true;
+
+  if (!sorted || getOrder() == 0) {
+    const size_t csize = getComponentType().getNumBytes();
+    reserve(numComponents);
+    char* coordLoc = content->coordinateBuffer->data();
+    for (size_t i = 0; i < numComponents; ++i) {
+      for (size_t d = 0; d < coordinates.size(); ++d) {
+        ((int*)coordLoc)[d] = coordinates[d][i];
+      }
+      memcpy(coordLoc + coordinates.size() * sizeof(int),
+             (const char*)values + i * csize, csize);
+      coordLoc += content->coordinateSize;
+    }
+    content->coordinateBufferUsed = numComponents * content->coordinateSize;
+    setNeedsPack(true);
+    pack();
+    return;
+  }
+
+  // Sorted components are packed straight from the caller's arrays, listed in
+  // the order the format stores the modes in.
+  std::vector<const int*> storageCoordinates(getOrder());
+  for (int i = 0; i < getOrder(); ++i) {
+    storageCoordinates[i] = coordinates[getFormat().getModeOrdering()[i]];
+  }
+  unsetNeverPacked();
+  setNeedsPack(false);
+  packSortedCoordinates(storageCoordinates, values, numComponents);
+}
+
 void TensorBase::setStorage(TensorStorage storage) {
   // TODO(pnoyola): figure out all possible interactions between
   // setStorage and automatic compilation machinery.
   content->needsPack = false;
   content->storage = storage;
+  // The storage holds the tensor's components, which later packs must keep
+  content->neverPacked = false;
 }
 
 static inline map<TensorVar, TensorBase> getTensors(const IndexExpr& expr);
@@ -486,6 +1067,28 @@ struct AccessTensorNode : public AccessNode {
   }
 };
 
+/// Rebuilds the accesses of the tensors in an expression, whose rewriting
+/// dropped the TensorBase objects of the accesses.
+static IndexExpr makeTensorAccesses(IndexExpr expr,
+                                    const map<TensorVar,TensorBase>& tensors) {
+  struct MakeTensorAccesses : IndexNotationRewriter {
+    using IndexNotationRewriter::visit;
+    MakeTensorAccesses(const map<TensorVar,TensorBase>& tensors)
+        : tensors(tensors) {}
+    const map<TensorVar,TensorBase>& tensors;
+
+    void visit(const AccessNode* op) {
+      if (isa<AccessTensorNode>(op) ||
+          !util::contains(tensors, op->tensorVar)) {
+        expr = op;
+        return;
+      }
+      expr = new AccessTensorNode(tensors.at(op->tensorVar), op->indexVars);
+    }
+  };
+  return MakeTensorAccesses(tensors).rewrite(expr);
+}
+
 const Access TensorBase::operator()(const std::vector<IndexVar>& indices) const {
   taco_uassert(indices.size() == (size_t)getOrder())
       << "A tensor of order " << getOrder() << " must be indexed with "
@@ -511,31 +1114,50 @@ const Access TensorBase::operator()() const {
 }
 
 TensorBase::KernelsCache TensorBase::computeKernels;
-std::mutex TensorBase::computeKernelsMutex;
+static std::shared_timed_mutex computeKernelsMutex;
 
 std::shared_ptr<Module> TensorBase::getComputeKernel(const IndexStmt stmt) {
-  computeKernelsMutex.lock();
-  const auto computeKernelsReverse =
-      util::ReverseConstIterable<TensorBase::KernelsCache>(computeKernels);
-  for (const auto& computeKernel : computeKernelsReverse) {
-    if (isomorphic(stmt, computeKernel.first)) {
-      const auto kernelModule = computeKernel.second;
-      computeKernelsMutex.unlock();
-      return kernelModule;
+  const size_t hash = isomorphicHash(stmt);
+  std::shared_lock<std::shared_timed_mutex> lock(computeKernelsMutex);
+  const auto bucket = computeKernels.equal_range(hash);
+  for (auto computeKernel = bucket.first; computeKernel != bucket.second;
+       ++computeKernel) {
+    if (isomorphic(stmt, computeKernel->second.first)) {
+      return computeKernel->second.second;
     }
   }
-  computeKernelsMutex.unlock();
   return nullptr;
 }
 
 void TensorBase::cacheComputeKernel(const IndexStmt stmt,
                                     const std::shared_ptr<Module> kernel) {
-  computeKernelsMutex.lock();
-  computeKernels.emplace_back(stmt, kernel);
-  computeKernelsMutex.unlock();
+  const size_t hash = isomorphicHash(stmt);
+  std::unique_lock<std::shared_timed_mutex> lock(computeKernelsMutex);
+  computeKernels.emplace(hash, std::make_pair(stmt, kernel));
 }
 
-void TensorBase::compile() {
+static util::ThreadPool& getCompileThreadPool() {
+  static util::ThreadPool pool([]() -> size_t {
+    string numThreads = util::getFromEnv("TACO_COMPILE_THREADS", "");
+    if (numThreads != "") {
+      return (size_t)std::max(atoi(numThreads.c_str()), 1);
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }());
+  return pool;
+}
+
+static std::shared_future<void> pendingOrReady(
+    const std::shared_future<void>& future) {
+  if (future.valid()) {
+    return future;
+  }
+  std::promise<void> ready;
+  ready.set_value();
+  return ready.get_future().share();
+}
+
+IndexStmt TensorBase::makeDefaultStmt() const {
   Assignment assignment = getAssignment();
   taco_uassert(assignment.defined())
       << error::compile_without_expr;
@@ -544,12 +1166,78 @@ void TensorBase::compile() {
   stmt = reorderLoopsTopologically(stmt);
   stmt = insertTemporaries(stmt);
   stmt = parallelizeOuterLoop(stmt);
-  compile(stmt, content->assembleWhileCompute);
+  return stmt;
 }
+
+void TensorBase::fuseOperands() {
+  taco_uassert(getAssignment().defined()) << error::compile_without_expr;
+  if (!needsCompute()) {
+    return;
+  }
+
+  // Collect the assignments of uncomputed operands, and of their operands
+  vector<Assignment> producers;
+  map<TensorVar,TensorBase> tensors;
+  std::function<void(Assignment)> collectProducers = [&](Assignment assign) {
+    for (auto& operand : getTensors(assign.getRhs())) {
+      if (!tensors.insert(operand).second) {
+        continue;
+      }
+      TensorBase tensor = operand.second;
+      Assignment producer = tensor.getAssignment();
+      if (tensor.needsCompute() && !producer.getOperator().defined()) {
+        producers.push_back(producer);
+        collectProducers(producer);
+      }
+    }
+  };
+  collectProducers(getAssignment());
+  if (producers.empty()) {
+    return;
+  }
+
+  Assignment assignment = getAssignment();
+  IndexExpr rhs = makeTensorAccesses(fuse(assignment, producers).getRhs(),
+                                     tensors);
+  for (auto& operand : getTensors(assignment.getRhs())) {
+    operand.second.removeDependentTensor(*this);
+  }
+  for (auto& operand : getTensors(rhs)) {
+    operand.second.addDependentTensor(*this);
+  }
+
+  setAssignment(Assignment(assignment.getLhs(), rhs, assignment.getOperator()));
+  setNeedsCompile(true);
+  setNeedsAssemble(true);
+}
+
+void TensorBase::compile() {
+  compile(makeDefaultStmt(), content->assembleWhileCompute);
+}
+
 void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
+  compileKernels(stmt, assembleWhileCompute, false);
+}
+
+std::shared_future<void> TensorBase::compileAsync() {
   if (!needsCompile()) {
-    return;
+    return pendingOrReady(content->compileFuture);
+  }
+  return compileAsync(makeDefaultStmt(), content->assembleWhileCompute);
+}
+
+std::shared_future<void> TensorBase::compileAsync(IndexStmt stmt,
+                                                  bool assembleWhileCompute) {
+  return compileKernels(stmt, assembleWhileCompute, true);
+}
+
+std::shared_future<void> TensorBase::compileKernels(IndexStmt stmt,
+                                                    bool assembleWhileCompute,
+                                                    bool async) {
+  if (!needsCompile()) {
+    return pendingOrReady(content->compileFuture);
   }
+  waitForCompile();
   setNeedsCompile(false);
 
   IndexStmt concretizedAssign = stmt;
@@ -562,17 +1250,37 @@ void TensorBase::compile(taco::IndexStmt stmt, bool assembleWhileCompute) {
     const auto cachedKernel = getComputeKernel(concretizedAssign);
     if (cachedKernel) {
       content->module = cachedKernel;
-      return;
+      return pendingOrReady(content->compileFuture);
     }
   }
 
   content->assembleFunc = lower(stmtToCompile, "assemble", true, false);
   content->computeFunc = lower(stmtToCompile, "compute",  assembleWhileCompute, true);
-  content->module->reset();
-  content->module->addFunction(content->assembleFunc);
-  content->module->addFunction(content->computeFunc);
-  content->module->compile();
-  cacheComputeKernel(concretizedAssign, content->module);
+
+  // Compile into a fresh module since the previous one may be shared through
+  // the kernel cache.
+  auto module = make_shared<Module>();
+  module->addFunction(content->assembleFunc);
+  module->addFunction(content->computeFunc);
+  content->module = module;
+
+  auto compileModule = [module, concretizedAssign]() {
+    module->compile();
+    cacheComputeKernel(concretizedAssign, module);
+  };
+  if (async) {
+    content->compileFuture = getCompileThreadPool().submit(compileModule);
+  } else {
+    compileModule();
+  }
+  return pendingOrReady(content->compileFuture);
+}
+
+void TensorBase::waitForCompile() {
+  if (content->compileFuture.valid()) {
+    content->compileFuture.get();
+    content->compileFuture = std::shared_future<void>();
+  }
 }
 
 taco_tensor_t* TensorBase::getTacoTensorT() {
@@ -687,6 +1395,7 @@ void TensorBase::assemble() {
   if (!needsAssemble()) {
     return;
   }
+  waitForCompile();
   // Sync operand tensors if needed.
   auto operands = getTensors(getAssignment().getRhs());
   for (auto& operand : operands) {
@@ -699,7 +1408,7 @@ void TensorBase::assemble() {
   if (!content->assembleWhileCompute) {
     setNeedsAssemble(false);
     taco_tensor_t* tensorData = ((taco_tensor_t*)arguments[0]);
-    content->valuesSize = unpackTensorData(*tensorData, *this);
+    content->valuesSize = unpackTensorData(*tensorData, *this, false);
   }
 }
 
@@ -708,6 +1417,7 @@ void TensorBase::compute() {
   if (!needsCompute()) {
     return;
   }
+  waitForCompile();
   setNeedsCompute(false);
   // Sync operand tensors if needed.
   auto operands = getTensors(getAssignment().getRhs());
@@ -776,17 +1486,17 @@ void TensorBase::printAssembleIR(ostream& os, bool color, bool simplify) const {
 }
 
 string TensorBase::getSource() const {
+  const_cast<TensorBase*>(this)->waitForCompile();
   return content->module->getSource();
 }
 
 void TensorBase::compileSource(std::string source) {
   taco_iassert(getAssignment().getRhs().defined())
       << error::compile_without_expr;
+  waitForCompile();
 
-  IndexStmt stmt = makeConcreteNotation(makeReductionNotation(getAssignment()));
-  stmt = reorderLoopsTopologically(stmt);
-  stmt = insertTemporaries(stmt);
-  stmt = parallelizeOuterLoop(stmt);
+  IndexStmt stmt = makeDefaultStmt();
+  content->module = make_shared<Module>();
   content->assembleFunc = lower(stmt, "assemble", true, false);
   content->computeFunc = lower(stmt, "compute",  false, true);
 
@@ -808,25 +1518,11 @@ void TensorBase::compileSource(std::string source) {
 TensorBase::HelperFuncsCache TensorBase::helperFunctions;
 std::mutex TensorBase::helperFunctionsMutex;
 
-std::shared_ptr<ir::Module>
-TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
-                               const std::vector<int>& dimensions) {
-  helperFunctionsMutex.lock();
-  const auto helperFunctionsReverse =
-      util::ReverseConstIterable<TensorBase::HelperFuncsCache>(helperFunctions);
-  for (const auto& helperFuncs : helperFunctionsReverse) {
-    if (std::get<0>(helperFuncs) == format &&
-        std::get<1>(helperFuncs) == ctype &&
-        std::get<2>(helperFuncs) == dimensions) {
-      // If helper functions had already been generated for specified tensor
-      // format and type, then use cached version.
-      const auto helperFuncsModule = std::get<3>(helperFuncs);
-      helperFunctionsMutex.unlock();
-      return helperFuncsModule;
-    }
-  }
-  helperFunctionsMutex.unlock();
-
+/// Lowers and compiles the routines that pack and iterate over tensors of the
+/// given format, component type and dimensions.
+static std::shared_ptr<Module>
+compileHelperFunctions(const Format& format, Datatype ctype,
+                       const std::vector<int>& dimensions) {
   std::shared_ptr<Module> helperModule = std::make_shared<Module>();
 
   std::function<Dimension(int)> getDim = [](int dim) {
@@ -835,8 +1531,9 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
   const auto dims = util::map(dimensions, getDim);
 
   if (format.getOrder() > 0) {
-    const Format bufferFormat = COO(format.getOrder(), false, true, false,
-                                    format.getModeOrdering());
+    Format bufferFormat = COO(format.getOrder(), false, true, false,
+                              format.getModeOrdering());
+    bufferFormat.setCoordinateTypes(format.getPositionType(), Int32);
     TensorVar bufferTensor(Type(ctype, Shape(dims)), bufferFormat);
     TensorVar packedTensor(Type(ctype, Shape(dims)), format);
 
@@ -850,11 +1547,14 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
       iterateStmt = forall(indexVars[mode], iterateStmt);
     }
 
-    // Lower packing and iterator code.
-    helperModule->addFunction(lower(packStmt, "pack", true, true));
+    // Lower packing and iterator code.  SELL levels are packed on the host.
+    if (format.getModeFormats().back().getName() != Sell.getName()) {
+      helperModule->addFunction(lower(packStmt, "pack", true, true));
+    }
     helperModule->addFunction(lower(iterateStmt, "iterate", false, true));
   } else {
-    const Format bufferFormat = COO(1, false, true, false);
+    Format bufferFormat = COO(1, false, true, false);
+    bufferFormat.setCoordinateTypes(format.getPositionType(), Int32);
     TensorVar bufferVector(Type(ctype, Shape({1})), bufferFormat);
     TensorVar packedScalar(Type(ctype, dims), format);
 
@@ -871,11 +1571,41 @@ TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
     helperModule->addFunction(lower(iterateStmt, "iterate", false, true));
   }
   helperModule->compile();
+  return helperModule;
+}
 
+std::shared_ptr<ir::Module>
+TensorBase::getHelperFunctions(const Format& format, Datatype ctype,
+                               const std::vector<int>& dimensions) {
+  // The first thread to need helper functions compiles them, and other threads
+  // that need the same helper functions wait for it
+  std::promise<std::shared_ptr<Module>> helperFuncsPromise;
   helperFunctionsMutex.lock();
-  helperFunctions.emplace_back(format, ctype, dimensions, helperModule);
+  const auto helperFunctionsReverse =
+      util::ReverseConstIterable<TensorBase::HelperFuncsCache>(helperFunctions);
+  for (const auto& helperFuncs : helperFunctionsReverse) {
+    if (std::get<0>(helperFuncs) == format &&
+        std::get<1>(helperFuncs) == ctype &&
+        std::get<2>(helperFuncs) == dimensions) {
+      // If helper functions had already been generated for specified tensor
+      // format and type, then use cached version.
+      const auto helperFuncsModule = std::get<3>(helperFuncs);
+      helperFunctionsMutex.unlock();
+      return helperFuncsModule.get();
+    }
+  }
+  helperFunctions.emplace_back(format, ctype, dimensions,
+                               helperFuncsPromise.get_future().share());
   helperFunctionsMutex.unlock();
 
+  std::shared_ptr<Module> helperModule;
+  try {
+    helperModule = compileHelperFunctions(format, ctype, dimensions);
+  } catch (...) {
+    helperFuncsPromise.set_exception(std::current_exception());
+    throw;
+  }
+  helperFuncsPromise.set_value(helperModule);
   return helperModule;
 }
 
@@ -997,6 +1727,7 @@ bool equals(const TensorBase& a, const TensorBase& b) {
     case Datatype::Float64: return equalsTyped<double>(a, b);
     case Datatype::Complex64: return equalsTyped<std::complex<float>>(a, b);
     case Datatype::Complex128: return equalsTyped<std::complex<double>>(a, b);
+    case Datatype::Pattern: return equalsTyped<bool>(a, b);
     case Datatype::Undefined: taco_ierror << "Undefined data type";
   }
   taco_unreachable;
@@ -1056,6 +1787,7 @@ ostream& operator<<(ostream& os, const TensorBase& tensor) {
       case Datatype::Float64: os << ((double*)(ptr+tensor.getOrder()))[0] << std::endl; break;
       case Datatype::Complex64: os << ((std::complex<float>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
       case Datatype::Complex128: os << ((std::complex<double>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
+      case Datatype::Pattern: os << 1 << std::endl; break;
       case Datatype::Undefined: taco_ierror; break;
     }
   }
@@ -1096,6 +1828,7 @@ ostream& operator<<(ostream& os, TensorBase& tensor) {
       case Datatype::Float64: os << ((double*)(ptr+tensor.getOrder()))[0] << std::endl; break;
       case Datatype::Complex64: os << ((std::complex<float>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
       case Datatype::Complex128: os << ((std::complex<double>*)(ptr+tensor.getOrder()))[0] << std::endl; break;
+      case Datatype::Pattern: os << 1 << std::endl; break;
       case Datatype::Undefined: taco_ierror; break;
     }
   }
@@ -1124,6 +1857,9 @@ TensorBase dispatchRead(T& file, FileType filetype, U format, bool pack) {
     case FileType::rb:
       tensor = readRB(file, format, pack);
       break;
+    case FileType::ttb:
+      tensor = readTTB(file, format, pack);
+      break;
   }
   return tensor;
 }
@@ -1145,6 +1881,9 @@ TensorBase dispatchRead(std::string filename, U format, bool pack) {
   else if (extension == "rb") {
     tensor = dispatchRead(filename, FileType::rb, format, pack);
   }
+  else if (extension == "ttb") {
+    tensor = dispatchRead(filename, FileType::ttb, format, pack);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
@@ -1196,6 +1935,9 @@ void dispatchWrite(T& file, const TensorBase& tensor, FileType filetype) {
     case FileType::rb:
       writeRB(file, tensor);
       break;
+    case FileType::ttb:
+      writeTTB(file, tensor);
+      break;
   }
 }
 
@@ -1216,6 +1958,9 @@ void write(string filename, const TensorBase& tensor) {
   else if (extension == "rb") {
     dispatchWrite(filename, tensor, FileType::rb);
   }
+  else if (extension == "ttb") {
+    dispatchWrite(filename, tensor, FileType::ttb);
+  }
   else {
     taco_uerror << "File extension not recognized: " << filename << std::endl;
   }
@@ -1229,6 +1974,16 @@ void write(ofstream& stream, FileType filetype, const TensorBase& tensor) {
   dispatchWrite(stream, tensor, filetype);
 }
 
+static size_t readMemoryBudget = 0;
+
+void setReadMemoryBudget(size_t bytes) {
+  readMemoryBudget = bytes;
+}
+
+size_t getReadMemoryBudget() {
+  return readMemoryBudget;
+}
+
 void packOperands(const TensorBase& tensor) {
   auto operands = getArguments(makeConcreteNotation(tensor.getAssignment()));
 
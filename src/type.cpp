@@ -26,6 +26,10 @@ Datatype::Kind Datatype::getKind() const {
 bool Datatype::isBool() const {
   return getKind() == Bool;
 }
+
+bool Datatype::isPattern() const {
+  return getKind() == Pattern;
+}
   
 bool Datatype::isUInt() const {
   return getKind() == UInt8 || getKind() == UInt16 || getKind() == UInt32 ||
@@ -49,6 +53,10 @@ Datatype max_type(Datatype a, Datatype b) {
   if (a == b) {
     return a;
   }
+  else if (a.isPattern() || b.isPattern()) {
+    // Pattern components are implicitly one, so they adopt the other type
+    return a.isPattern() ? b : a;
+  }
   else if (a.isComplex() || b.isComplex()) {
     if (a == Complex128 || b == Complex128 || a == Float64 || b == Float64) {
       return Complex128;
@@ -104,6 +112,8 @@ int Datatype::getNumBits() const {
     case Int128:
     case UInt128:
       return 128;
+    case Pattern:
+      return 0;
     default:
       taco_ierror << "Bits for data type not set: " << getKind();
       return -1;
@@ -118,6 +128,7 @@ std::ostream& operator<<(std::ostream& os, const Datatype& type) {
   else if (type == Datatype::Float64) os << "double";
   else if (type == Datatype::Complex64) os << "float complex";
   else if (type == Datatype::Complex128) os << "double complex";
+  else if (type == Datatype::Pattern) os << "pattern";
   else os << "Undefined";
   return os;
 }
@@ -139,6 +150,7 @@ std::ostream& operator<<(std::ostream& os, const Datatype::Kind& kind) {
     case Datatype::Float64: os << "Float64"; break;
     case Datatype::Complex64: os << "Complex64"; break;
     case Datatype::Complex128: os << "Complex128"; break;
+    case Datatype::Pattern: os << "Pattern"; break;
     case Datatype::Undefined: os << "Undefined"; break;
   }
   return os;
@@ -217,6 +229,7 @@ Datatype Complex(int bits) {
   
 Datatype Complex64  = Datatype(Datatype::Complex64);
 Datatype Complex128 = Datatype(Datatype::Complex128);
+Datatype Pattern = Datatype(Datatype::Pattern);
 
 struct Dimension::Content {
   size_t size;
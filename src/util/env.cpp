@@ -7,6 +7,7 @@ namespace taco {
 namespace util {
 
 std::string cachedtmpdir = "";
+std::mutex cachedtmpdirMutex;
 
 static int unlink_cb(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf)
 {
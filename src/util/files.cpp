@@ -5,6 +5,10 @@
 #include <iostream>
 #include <fstream>
 #include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -24,4 +28,34 @@ void openStream(std::fstream& stream, std::string path, fstream::openmode mode)
   taco_uassert(stream.is_open()) << "Error opening file: " << path;
 }
 
+MappedFile::MappedFile(std::string path) : data(nullptr), size(0) {
+  int fd = open(sanitizePath(path).c_str(), O_RDONLY);
+  taco_uassert(fd != -1) << "Error opening file: " << path;
+  struct stat fileStat;
+  taco_uassert(fstat(fd, &fileStat) == 0) << "Error opening file: " << path;
+  size = fileStat.st_size;
+  if (size > 0) {
+    void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                         fd, 0);
+    taco_uassert(mapping != MAP_FAILED)
+        << "Error memory-mapping file: " << path;
+    data = (char*)mapping;
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data != nullptr) {
+    munmap(data, size);
+  }
+}
+
+char* MappedFile::getData() const {
+  return data;
+}
+
+size_t MappedFile::getSize() const {
+  return size;
+}
+
 }}
@@ -0,0 +1,73 @@
+#include "taco/util/thread_pool.h"
+
+using namespace std;
+
+namespace taco {
+namespace util {
+
+ThreadPool::ThreadPool(size_t numThreads) : stopping(false) {
+  numThreads = (numThreads > 0) ? numThreads : 1;
+  for (size_t i = 0; i < numThreads; ++i) {
+    workers.emplace_back([this]() { work(); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    lock_guard<mutex> lock(tasksMutex);
+    stopping = true;
+  }
+  condition.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+future<void> ThreadPool::submit(function<void()> task) {
+  packaged_task<void()> packagedTask(task);
+  future<void> result = packagedTask.get_future();
+  {
+    lock_guard<mutex> lock(tasksMutex);
+    tasks.push_back(std::move(packagedTask));
+  }
+  condition.notify_one();
+  return result;
+}
+
+size_t ThreadPool::getNumThreads() const {
+  return workers.size();
+}
+
+void ThreadPool::work() {
+  while (true) {
+    packaged_task<void()> task;
+    {
+      unique_lock<mutex> lock(tasksMutex);
+      condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if (tasks.empty()) {
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    task();
+  }
+}
+
+void parallelFor(size_t n, size_t numThreads,
+                 const function<void(size_t,size_t)>& body) {
+  if (numThreads <= 1) {
+    body(0, n);
+    return;
+  }
+  vector<thread> threads;
+  for (size_t t = 1; t < numThreads; ++t) {
+    threads.emplace_back(body, t * n / numThreads, (t + 1) * n / numThreads);
+  }
+  body(0, n / numThreads);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+}}
@@ -5,6 +5,8 @@
 
 #include "taco/tensor.h"
 #include "taco/format.h"
+#include "taco/lower/mode_format_hashed.h"
+#include "taco/lower/mode_format_bitmap.h"
 #include "taco/index_notation/index_notation.h"
 #include "taco/storage/storage.h"
 #include "taco/util/strings.h"
@@ -72,3 +74,450 @@ TEST(format, dense) {
   A.pack();
   ASSERT_COMPONENTS_EQUALS({{{3}}, {{3}}}, {0,2,0, 0,0,0, 3,0,4}, A);
 }
+
+TEST(format, int64_positions) {
+  Format csr64 = CSR;
+  csr64.setCoordinateTypes(Int64, Int32);
+  Format dcsr64({Sparse, Sparse});
+  dcsr64.setCoordinateTypes(Int64, Int64);
+
+  Tensor<double> A("A", {3,3}, csr64);
+  Tensor<double> B("B", {3,3}, dcsr64);
+  Tensor<double> Aref("Aref", {3,3}, CSR);
+  Tensor<double> x("x", {3}, Dense);
+  for (auto& component : std::vector<std::pair<std::vector<int>,double>>{
+       {{0,1}, 1.0}, {{2,0}, 2.0}, {{2,2}, 3.0}}) {
+    A.insert(component.first, component.second);
+    B.insert(component.first, component.second);
+    Aref.insert(component.first, component.second);
+  }
+  x.insert({0}, 1.0);
+  x.insert({1}, 2.0);
+  x.insert({2}, 3.0);
+  A.pack();
+  B.pack();
+  Aref.pack();
+  x.pack();
+
+  auto pos = A.getStorage().getIndex().getModeIndex(1).getIndexArray(0);
+  ASSERT_EQ(Int64, pos.getType());
+  ASSERT_ARRAY_EQ<int64_t>({0,1,1,3}, {(int64_t*)pos.getData(), pos.getSize()});
+  ASSERT_TRUE(equals(Aref, A));
+
+  IndexVar i, j;
+  Tensor<double> y("y", {3}, Dense);
+  y(i) = A(i,j) * x(j);
+  Tensor<double> yref("yref", {3}, Dense);
+  yref(i) = Aref(i,j) * x(j);
+  y.evaluate();
+  yref.evaluate();
+  ASSERT_TRUE(equals(yref, y));
+
+  Tensor<double> C("C", {3,3}, csr64);
+  C(i,j) = A(i,j) + B(i,j);
+  C.evaluate();
+  Tensor<double> Cref("Cref", {3,3}, CSR);
+  Cref(i,j) = Aref(i,j) + Aref(i,j);
+  Cref.evaluate();
+  ASSERT_TRUE(equals(Cref, C));
+  ASSERT_EQ(Int64, C.getStorage().getIndex().getModeIndex(1)
+                    .getIndexArray(0).getType());
+}
+
+TEST(format, narrow_coordinates) {
+  Format csr8 = CSR;
+  csr8.narrowCoordinateTypes({3,200});
+  Format dcsr16({Sparse, Sparse});
+  dcsr16.narrowCoordinateTypes({300,200});
+  ASSERT_EQ(UInt8, csr8.getCoordinateTypeIdx(1));
+  ASSERT_EQ(UInt16, dcsr16.getCoordinateTypeIdx(0));
+  ASSERT_EQ(UInt8, dcsr16.getCoordinateTypeIdx(1));
+
+  Tensor<double> A("A", {3,200}, csr8);
+  Tensor<double> B("B", {300,200}, dcsr16);
+  Tensor<double> Aref("Aref", {3,200}, CSR);
+  Tensor<double> Bref("Bref", {300,200}, CSR);
+  for (auto& component : std::vector<std::pair<std::vector<int>,double>>{
+       {{0,1}, 1.0}, {{2,0}, 2.0}, {{2,199}, 3.0}}) {
+    A.insert(component.first, component.second);
+    Aref.insert(component.first, component.second);
+  }
+  for (auto& component : std::vector<std::pair<std::vector<int>,double>>{
+       {{1,199}, 4.0}, {{2,0}, 5.0}, {{299,3}, 6.0}}) {
+    B.insert(component.first, component.second);
+    Bref.insert(component.first, component.second);
+  }
+  A.pack();
+  B.pack();
+  Aref.pack();
+  Bref.pack();
+
+  auto crd = A.getStorage().getIndex().getModeIndex(1).getIndexArray(1);
+  ASSERT_EQ(UInt8, crd.getType());
+  ASSERT_ARRAY_EQ<uint8_t>({1,0,199}, {(uint8_t*)crd.getData(), crd.getSize()});
+  ASSERT_TRUE(equals(Aref, A));
+  ASSERT_TRUE(equals(Bref, B));
+
+  IndexVar i, j, k;
+  Tensor<double> C("C", {3,300}, Dense);
+  C(i,k) = A(i,j) * B(k,j);
+  C.evaluate();
+  Tensor<double> Cref("Cref", {3,300}, Dense);
+  Cref(i,k) = Aref(i,j) * Bref(k,j);
+  Cref.evaluate();
+  ASSERT_TRUE(equals(Cref, C));
+}
+
+TEST(format, bcsr) {
+  Tensor<double> A("A", {7,6}, CSR);
+  Tensor<double> x("x", {6}, Dense);
+  A.insert({0,0}, 1.0);
+  A.insert({1,4}, 2.0);
+  A.insert({4,2}, 3.0);
+  A.insert({6,5}, 4.0);
+  for (int j = 0; j < 6; ++j) {
+    x.insert({j}, (double)(j + 1));
+  }
+  A.pack();
+  x.pack();
+
+  Tensor<double> Ab = A.block({2,3}, BCSR);
+  Tensor<double> xb = x.block({3}, Format({Dense, Dense}));
+  ASSERT_EQ(std::vector<int>({4,2,2,3}), Ab.getDimensions());
+  ASSERT_TRUE(equals(A, Ab.unblock({7,6}, CSR)));
+
+  IndexVar i, j, bi, bj;
+  Tensor<double> yb("yb", {4,2}, Format({Dense, Dense}));
+  yb(i,bi) = Ab(i,j,bi,bj) * xb(j,bj);
+  yb.evaluate();
+
+  Tensor<double> y("y", {7}, Dense);
+  y(i) = A(i,j) * x(j);
+  y.evaluate();
+  ASSERT_TRUE(equals(y, yb.unblock({7}, Dense)));
+
+  Tensor<double> T("T", {3,4,5}, Format({Sparse, Sparse, Sparse}));
+  T.insert({0,1,2}, 1.0);
+  T.insert({2,3,4}, 2.0);
+  T.pack();
+  Tensor<double> Tb = T.block({2,2,2}, BCSF(3));
+  ASSERT_TRUE(equals(T, Tb.unblock({3,4,5}, Format({Sparse, Sparse, Sparse}))));
+}
+
+TEST(format, sell) {
+  Tensor<double> A("A", {7,5}, CSR);
+  Tensor<double> As("As", {7,5}, SELL(2));
+  Tensor<double> x("x", {5}, Dense);
+  const std::vector<std::vector<int>> coords = {{0,0}, {1,1}, {1,3}, {1,4},
+                                                {4,2}, {6,0}, {6,4}};
+  for (size_t n = 0; n < coords.size(); ++n) {
+    A.insert(coords[n], (double)(n + 1));
+    As.insert(coords[n], (double)(n + 1));
+  }
+  for (int j = 0; j < 5; ++j) {
+    x.insert({j}, (double)(j + 1));
+  }
+  A.pack();
+  As.pack();
+  x.pack();
+  ASSERT_TRUE(equals(A, As));
+
+  // The slices of rows {0,1}, {2,3}, {4,5} and {6} are 3, 0, 1 and 2 wide
+  auto index = As.getStorage().getIndex().getModeIndex(1);
+  ASSERT_EQ(5u, index.getIndexArray(0).getSize());
+  ASSERT_EQ(12u, index.getIndexArray(0).get(4).getAsIndex());
+  const int* crd = (const int*)index.getIndexArray(1).getData();
+  int numPadded = 0;
+  for (int p = 0; p < 12; ++p) {
+    numPadded += (crd[p] == -1);
+  }
+  ASSERT_EQ(5, numPadded);
+
+  IndexVar i, j;
+  Tensor<double> y("y", {7}, Dense);
+  y(i) = As(i,j) * x(j);
+  y.evaluate();
+
+  Tensor<double> expected("expected", {7}, Dense);
+  expected(i) = A(i,j) * x(j);
+  expected.evaluate();
+  ASSERT_TRUE(equals(expected, y));
+
+  // Sorting rows {0,1,2,3} and {4,5,6} by length slices rows {1,0}, {2,3},
+  // {6,4} and {5}, which are 3, 0, 2 and 0 wide
+  Tensor<double> Ap("Ap", {7,5}, SELL(2,4));
+  for (size_t n = 0; n < coords.size(); ++n) {
+    Ap.insert(coords[n], (double)(n + 1));
+  }
+  Ap.pack();
+  index = Ap.getStorage().getIndex().getModeIndex(1);
+  ASSERT_EQ(10u, index.getIndexArray(0).get(4).getAsIndex());
+  const int* perm = (const int*)index.getIndexArray(2).getData();
+  ASSERT_EQ(std::vector<int>({1,0,2,3,6,4,5,7}), std::vector<int>(perm, perm+8));
+
+  Tensor<double> yp("yp", {7}, Dense);
+  yp(i) = Ap(i,j) * x(j);
+  yp.evaluate();
+  ASSERT_TRUE(equals(expected, yp));
+}
+
+TEST(format, hashed) {
+  Tensor<double> A("A", {4,6}, CSR);
+  Tensor<double> B("B", {6,5}, CSR);
+  A.insert({0,1}, 1.0);
+  A.insert({0,5}, 2.0);
+  A.insert({2,0}, 3.0);
+  A.insert({3,1}, 4.0);
+  B.insert({1,4}, 5.0);
+  B.insert({1,0}, 6.0);
+  B.insert({5,4}, 7.0);
+  B.insert({0,2}, 8.0);
+  A.pack();
+  B.pack();
+
+  // Sparse results assembled by scattered inserts into hash tables
+  IndexVar i, j, k;
+  Tensor<double> C("C", {4,5}, Format({Dense, Hashed}));
+  C(i,j) = A(i,k) * B(k,j);
+  C.evaluate();
+  Tensor<double> Cref("Cref", {4,5}, CSR);
+  Cref(i,j) = A(i,k) * B(k,j);
+  Cref.evaluate();
+  ASSERT_TRUE(equals(Cref, C));
+  // Tables grow from one slot as rows fill, to twice the longest row
+  ASSERT_EQ(4u, C.getStorage().getIndex().getModeIndex(1)
+                .getIndexArray(0).get(0).getAsIndex());
+
+  // Rows that overflow the requested width grow their tables
+  Tensor<double> F("F", {2,8}, Format({Dense,
+      ModeFormat(std::make_shared<HashedModeFormat>(2))}));
+  Tensor<double> Fref("Fref", {2,8}, CSR);
+  for (int j : {2, 4, 6}) {
+    F.insert({1,j}, (double)j);
+    Fref.insert({1,j}, (double)j);
+  }
+  F.pack();
+  Fref.pack();
+  ASSERT_TRUE(equals(Fref, F));
+  ASSERT_EQ(8u, F.getStorage().getIndex().getModeIndex(1)
+                .getIndexArray(0).get(0).getAsIndex());
+
+  // Tables are sized from the fibers, not from the dimension
+  Tensor<double> L("L", {10,100000}, Format({Dense, Hashed}));
+  L.insert({3,99999}, 1.0);
+  L.pack();
+  ASSERT_EQ(2u, L.getStorage().getIndex().getModeIndex(1)
+                .getIndexArray(0).get(0).getAsIndex());
+  ASSERT_EQ(20u, L.getStorage().getIndex().getModeIndex(1)
+                 .getIndexArray(1).getSize());
+  ASSERT_DOUBLE_EQ(1.0, L.at({3,99999}));
+
+  // Hashed operands are iterated and located into
+  Tensor<double> H("H", {4,5}, Format({Dense,
+      ModeFormat(std::make_shared<HashedModeFormat>(4))}));
+  Tensor<double> Href("Href", {4,5}, CSR);
+  for (auto& component : std::vector<std::pair<std::vector<int>,double>>{
+       {{0,4}, 1.0}, {{0,0}, 2.0}, {{1,3}, 3.0}, {{2,1}, 4.0}}) {
+    H.insert(component.first, component.second);
+    Href.insert(component.first, component.second);
+  }
+  H.pack();
+  Href.pack();
+  ASSERT_TRUE(equals(Href, H));
+  Tensor<double> D("D", {4,5}, Format({Dense, Dense}));
+  D(i,j) = C(i,j) + H(i,j);
+  D.evaluate();
+  Tensor<double> Dref("Dref", {4,5}, Format({Dense, Dense}));
+  Dref(i,j) = Cref(i,j) + Href(i,j);
+  Dref.evaluate();
+  ASSERT_TRUE(equals(Dref, D));
+  ASSERT_DOUBLE_EQ(2.0, H.at({0,0}));
+}
+
+TEST(format, bitmap) {
+  // Rows of 70 bits straddle the 64-bit words of the bitmap
+  Format bitmapMatrix({Dense, Bitmap});
+  Tensor<double> B("B", {3,70}, bitmapMatrix);
+  Tensor<double> C("C", {3,70}, bitmapMatrix);
+  Tensor<double> Bref("Bref", {3,70}, CSR);
+  Tensor<double> Cref("Cref", {3,70}, CSR);
+  for (int i = 0; i < 3; i++) {
+    for (int j = i; j < 70; j += 3) {
+      B.insert({i,j}, (double)(i+j));
+      Bref.insert({i,j}, (double)(i+j));
+    }
+    for (int j = 2*i; j < 70; j += 5) {
+      C.insert({i,j}, 1.0 + j);
+      Cref.insert({i,j}, 1.0 + j);
+    }
+  }
+  B.pack();
+  C.pack();
+  Bref.pack();
+  Cref.pack();
+  ASSERT_TRUE(equals(Bref, B));
+  const Array& bitmap = B.getStorage().getIndex().getModeIndex(1)
+                         .getIndexArray(1);
+  ASSERT_EQ(UInt64, bitmap.getType());
+  ASSERT_EQ(BitmapModeFormat::getNumWords(3*70), bitmap.getSize());
+  ASSERT_DOUBLE_EQ(0.0, B.at({0,1}));
+  ASSERT_DOUBLE_EQ(8.0, B.at({1,7}));
+
+  IndexVar i, j;
+  Tensor<double> A("A", {3,70}, Format({Dense, Dense}));
+  A(i,j) = B(i,j) * C(i,j);
+  A.evaluate();
+  Tensor<double> Aref("Aref", {3,70}, Format({Dense, Dense}));
+  Aref(i,j) = Bref(i,j) * Cref(i,j);
+  Aref.evaluate();
+  ASSERT_TRUE(equals(Aref, A));
+
+  Tensor<double> D("D", {3,70}, bitmapMatrix);
+  D(i,j) = B(i,j) + C(i,j);
+  D.evaluate();
+  Tensor<double> Dref("Dref", {3,70}, Format({Dense, Dense}));
+  Dref(i,j) = Bref(i,j) + Cref(i,j);
+  Dref.evaluate();
+  ASSERT_TRUE(equals(Dref, D));
+
+  // Intersections and the words they are combined with
+  Tensor<double> E("E", {3,70}, bitmapMatrix);
+  E(i,j) = B(i,j) * C(i,j);
+  E.evaluate();
+  ASSERT_TRUE(equals(Aref, E));
+  Tensor<double> Eref("Eref", {3,70}, CSR);
+  Eref(i,j) = Bref(i,j) * Cref(i,j);
+  Eref.evaluate();
+  size_t intersected = 0;
+  for (auto& component : iterate<double>(E)) {
+    (void)component;
+    intersected++;
+  }
+  ASSERT_EQ(Eref.getStorage().getValues().getSize(), intersected);
+
+  Tensor<double> F("F", {3,70}, Format({Dense, Dense}));
+  F(i,j) = B(i,j) * C(i,j) + B(i,j);
+  F.evaluate();
+  Tensor<double> Fref("Fref", {3,70}, Format({Dense, Dense}));
+  Fref(i,j) = Bref(i,j) * Cref(i,j) + Bref(i,j);
+  Fref.evaluate();
+  ASSERT_TRUE(equals(Fref, F));
+
+  // Bitmaps merged with other formats
+  Tensor<double> G("G", {3,70}, Format({Dense, Dense}));
+  G(i,j) = B(i,j) + Cref(i,j);
+  G.evaluate();
+  ASSERT_TRUE(equals(Dref, G));
+}
+
+TEST(format, bitmap_coiterate) {
+  // Bitmap modes iterate over coordinates, which are merged with the
+  // coordinates of position iterated compressed modes
+  Format bitmapMatrix({Dense, Bitmap});
+  Tensor<double> B("B", {3,70}, bitmapMatrix);
+  Tensor<double> C("C", {3,70}, CSR);
+  Tensor<double> Bref("Bref", {3,70}, CSR);
+  for (int i = 0; i < 3; i++) {
+    for (int j = i; j < 70; j += 3) {
+      B.insert({i,j}, (double)(i+j));
+      Bref.insert({i,j}, (double)(i+j));
+    }
+    for (int j = 2*i; j < 70; j += 5) {
+      C.insert({i,j}, 1.0 + j);
+    }
+  }
+  B.pack();
+  C.pack();
+  Bref.pack();
+
+  IndexVar i, j;
+  Tensor<double> A("A", {3,70}, CSR);
+  A(i,j) = B(i,j) + C(i,j);
+  A.evaluate();
+  Tensor<double> Aref("Aref", {3,70}, CSR);
+  Aref(i,j) = Bref(i,j) + C(i,j);
+  Aref.evaluate();
+  ASSERT_TRUE(equals(Aref, A));
+
+  Tensor<double> D("D", {3,70}, CSR);
+  D(i,j) = B(i,j) * C(i,j) - C(i,j);
+  D.evaluate();
+  Tensor<double> Dref("Dref", {3,70}, CSR);
+  Dref(i,j) = Bref(i,j) * C(i,j) - C(i,j);
+  Dref.evaluate();
+  ASSERT_TRUE(equals(Dref, D));
+
+  Tensor<double> x("x", {70}, Format({Dense}));
+  for (int j = 0; j < 70; j++) {
+    x.insert({j}, (double)(j % 4));
+  }
+  x.pack();
+  Tensor<double> y("y", {3}, Format({Dense}));
+  y(i) = B(i,j) * x(j);
+  y.evaluate();
+  Tensor<double> yref("yref", {3}, Format({Dense}));
+  yref(i) = Bref(i,j) * x(j);
+  yref.evaluate();
+  ASSERT_TRUE(equals(yref, y));
+}
+
+TEST(format, rle) {
+  // Rows hold runs of ten coordinates with equal values, with gaps
+  Format rleMatrix({Dense, RLE});
+  Tensor<double> B("B", {3,40}, rleMatrix);
+  Tensor<double> Bref("Bref", {3,40}, CSR);
+  for (int i = 0; i < 3; i++) {
+    for (int j = 2*i; j < 40; j++) {
+      if (j % 10 != 7) {
+        B.insert({i,j}, (double)(i + j/10));
+        Bref.insert({i,j}, (double)(i + j/10));
+      }
+    }
+  }
+  B.pack();
+  Bref.pack();
+  ASSERT_TRUE(equals(Bref, B));
+  // Each row packs into eight runs, split by the gaps and the value changes
+  const Array& runs = B.getStorage().getIndex().getModeIndex(1)
+                       .getIndexArray(1);
+  ASSERT_EQ(3u*8*2, runs.getSize());
+  ASSERT_EQ(3u*8, B.getStorage().getValues().getSize());
+
+  IndexVar i, j;
+  Tensor<double> y("y", {3}, Format({Dense}));
+  y(i) = B(i,j);
+  y.evaluate();
+  Tensor<double> yref("yref", {3}, Format({Dense}));
+  yref(i) = Bref(i,j);
+  yref.evaluate();
+  ASSERT_TRUE(equals(yref, y));
+
+  Tensor<double> x("x", {40}, Format({Dense}));
+  for (int j = 0; j < 40; j++) {
+    x.insert({j}, (double)(j % 3));
+  }
+  x.pack();
+  Tensor<double> z("z", {3}, Format({Dense}));
+  z(i) = B(i,j) * x(j);
+  z.evaluate();
+  Tensor<double> zref("zref", {3}, Format({Dense}));
+  zref(i) = Bref(i,j) * x(j);
+  zref.evaluate();
+  ASSERT_TRUE(equals(zref, z));
+
+  Tensor<double> A("A", {3,40}, CSR);
+  A(i,j) = B(i,j) + Bref(i,j);
+  A.evaluate();
+  Tensor<double> Aref("Aref", {3,40}, CSR);
+  Aref(i,j) = Bref(i,j) + Bref(i,j);
+  Aref.evaluate();
+  ASSERT_TRUE(equals(Aref, A));
+
+  Tensor<double> C("C", {3,40}, rleMatrix);
+  C(i,j) = B(i,j) * x(j);
+  C.evaluate();
+  Tensor<double> Cref("Cref", {3,40}, CSR);
+  Cref(i,j) = Bref(i,j) * x(j);
+  Cref.evaluate();
+  ASSERT_TRUE(equals(Cref, C));
+}
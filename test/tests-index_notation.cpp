@@ -153,6 +153,27 @@ TEST(notation, isomorphic) {
   ASSERT_FALSE(isomorphic(sum(j, B(i,j) + C(i,j)), sum(j, B(j,i) + C(j,i))));
 }
 
+TEST(notation, isomorphicHash) {
+  ASSERT_EQ(isomorphicHash(A(i,j) = B(i,j) + C(i,j)),
+            isomorphicHash(B(i,j) = C(i,j) + A(i,j)));
+  ASSERT_EQ(isomorphicHash(A(i,j) = B(i,j) + C(i,j)),
+            isomorphicHash(A(j,i) = B(j,i) + C(j,i)));
+  ASSERT_EQ(isomorphicHash(forall(i, forall(j, A(i,j) = B(i,j) + C(i,j)))),
+            isomorphicHash(forall(j, forall(i, A(j,i) = B(j,i) + C(j,i)))));
+  ASSERT_EQ(isomorphicHash(sum(j, B(i,j) + C(i,j))),
+            isomorphicHash(sum(i, B(j,i) + C(j,i))));
+  ASSERT_NE(isomorphicHash(A(i,j) = B(i,j) + C(i,j)),
+            isomorphicHash(A(i,k) = B(i,k) + C(k,i)));
+  ASSERT_NE(isomorphicHash(A(i,j) = B(i,j) + C(i,j)),
+            isomorphicHash(D(i,j) = E(i,j) + F(i,j)));
+  ASSERT_NE(isomorphicHash(D(i,j) = E(i,j) + F(i,j)),
+            isomorphicHash(D(i,j) = E(i,j) + G(i,j)));
+  ASSERT_NE(isomorphicHash(A(i,j) = B(i,j) + C(i,j)),
+            isomorphicHash(A(i,j) = B(i,j) * C(i,j)));
+  ASSERT_NE(isomorphicHash(forall(i, forall(j, A(i,j) = B(i,j) + C(i,j)))),
+            isomorphicHash(forall(i, forall(j, A(j,i) = B(j,i) + C(j,i)))));
+}
+
 TEST(notation, generatePackCOOStmt) {
   ModeFormat compressedNU = ModeFormat::Compressed(ModeFormat::NOT_UNIQUE);
   ModeFormat singletonNU = ModeFormat::Singleton(ModeFormat::NOT_UNIQUE);
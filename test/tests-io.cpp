@@ -1,6 +1,13 @@
 #include "test.h"
 
 #include "taco/tensor.h"
+#include "taco/storage/file_io_tns.h"
+#include "taco/storage/file_io_mtx.h"
+#include "taco/storage/file_io_ttb.h"
+#include "taco/util/env.h"
+
+#include <cstdio>
+#include <sstream>
 
 using namespace taco;
 
@@ -127,3 +134,191 @@ TEST(io, mtxsymmetric) {
 
   ASSERT_TRUE(equals(expected, tensor));
 }
+
+TEST(io, ttb) {
+  Tensor<double> csc = read(testDataDirectory()+"d567.ttx",
+                            Format({Sparse, Dense, Sparse}, {1, 0, 2}));
+  Tensor<float> coo({4, 5}, COO(2));
+  coo.insert({0, 1}, 1.0f);
+  coo.insert({3, 4}, 2.0f);
+  coo.insert({3, 0}, 3.0f);
+  coo.pack();
+
+  for (TensorBase tensor : {TensorBase(csc), TensorBase(coo)}) {
+    std::string filename = util::getTmpdir() + "io_ttb.ttb";
+    write(filename, tensor);
+    TensorBase mapped = read(filename, tensor.getFormat());
+    ASSERT_EQ(tensor.getFormat(), mapped.getFormat());
+    ASSERT_EQ(tensor.getComponentType(), mapped.getComponentType());
+    ASSERT_TRUE(equals(tensor, mapped));
+
+    std::stringstream stream;
+    writeTTB(stream, tensor);
+    TensorBase copied = readTTB(stream, tensor.getFormat());
+    ASSERT_TRUE(equals(tensor, copied));
+    remove(filename.c_str());
+  }
+}
+
+TEST(io, ttb_insert) {
+  Tensor<double> csr({4, 3}, CSR);
+  csr.insert({0, 1}, 1.0);
+  csr.insert({2, 2}, 2.0);
+  csr.pack();
+
+  Tensor<double> expected({4, 3}, CSR);
+  expected.insert({0, 1}, 1.0);
+  expected.insert({2, 2}, 2.0);
+  expected.insert({3, 0}, 5.0);
+  expected.pack();
+
+  std::string filename = util::getTmpdir() + "io_ttb_insert.ttb";
+  writeTTB(filename, csr);
+
+  // Components inserted into a loaded tensor are packed along with the file's
+  Tensor<double> mapped = readTTB(filename, CSR);
+  mapped.insert({3, 0}, 5.0);
+  mapped.pack();
+  ASSERT_TRUE(equals(expected, mapped));
+
+  Tensor<double> unpacked = readTTB(filename, CSR, false);
+  ASSERT_TRUE(unpacked.needsPack());
+  unpacked.insert({3, 0}, 5.0);
+  unpacked.pack();
+  ASSERT_TRUE(equals(expected, unpacked));
+  remove(filename.c_str());
+}
+
+TEST(io, tns_parallel) {
+  // Large enough to be split into several chunks
+  std::stringstream text;
+  text << "# comment" << std::endl;
+  unsigned seed = 11;
+  for (int n = 0; n < 150000; ++n) {
+    seed = seed * 1103515245 + 12345;
+    text << (seed >> 8) % 200 + 1 << " " << (seed >> 16) % 300 + 1 << "\t"
+         << n % 13 + 1 << " " << (n % 4 == 0 ? "1.5e-2" : "-0.25") << "\n";
+  }
+  const std::string contents = text.str();
+
+  std::stringstream serialStream(contents);
+  TensorBase serial = readTNS(serialStream, Sparse);
+
+  const int numThreads = taco_get_num_threads();
+  taco_set_num_threads(4);
+  std::stringstream parallelStream(contents);
+  TensorBase parallel = readTNS(parallelStream, Sparse);
+  taco_set_num_threads(numThreads);
+
+  ASSERT_EQ(serial.getDimensions(), parallel.getDimensions());
+  ASSERT_TRUE(equals(serial, parallel));
+}
+
+TEST(io, read_out_of_core) {
+  // Coordinates repeat, so the runs hold duplicates that must be summed
+  std::stringstream tnsText;
+  std::stringstream mtxText;
+  mtxText << "%%MatrixMarket matrix coordinate real symmetric" << std::endl;
+  mtxText << "% comment" << std::endl;
+  mtxText << "40 40 3000" << std::endl;
+  unsigned seed = 5;
+  for (int n = 0; n < 3000; ++n) {
+    seed = seed * 1103515245 + 12345;
+    int i = (seed >> 8) % 40 + 1;
+    int j = (seed >> 16) % 30 + 1;
+    tnsText << i << " " << j << " " << n % 7 + 1 << " " << n % 5 << ".5\n";
+    mtxText << std::max(i, j) << " " << std::min(i, j) << " " << n % 3
+            << ".25\n";
+  }
+  const std::string tnsContents = tnsText.str();
+  const std::string mtxContents = mtxText.str();
+
+  std::vector<Format> tnsFormats = {
+    Format({Sparse, Sparse, Sparse}),
+    Format({Dense, Sparse, Dense}, {2, 0, 1}),
+    Format({Sparse, Dense, Sparse}, {1, 2, 0})
+  };
+  std::vector<Format> mtxFormats = {CSR, CSC, Format({Sparse, Sparse})};
+
+  for (auto& format : tnsFormats) {
+    std::stringstream inMemoryStream(tnsContents);
+    TensorBase inMemory = readTNS(inMemoryStream, format);
+
+    setReadMemoryBudget(1 << 13);
+    std::stringstream outOfCoreStream(tnsContents);
+    TensorBase outOfCore = readTNS(outOfCoreStream, format);
+    setReadMemoryBudget(0);
+
+    ASSERT_EQ(inMemory.getDimensions(), outOfCore.getDimensions());
+    ASSERT_TRUE(equals(inMemory, outOfCore));
+
+    // Components inserted later are packed along with the ones read
+    inMemory.insert({0, 0, 0}, 1.0);
+    inMemory.pack();
+    outOfCore.insert({0, 0, 0}, 1.0);
+    outOfCore.pack();
+    ASSERT_TRUE(equals(inMemory, outOfCore));
+  }
+
+  for (auto& format : mtxFormats) {
+    std::stringstream inMemoryStream(mtxContents);
+    TensorBase inMemory = readMTX(inMemoryStream, format);
+
+    setReadMemoryBudget(1 << 13);
+    std::stringstream outOfCoreStream(mtxContents);
+    TensorBase outOfCore = readMTX(outOfCoreStream, format);
+    setReadMemoryBudget(0);
+
+    ASSERT_EQ(inMemory.getDimensions(), outOfCore.getDimensions());
+    ASSERT_TRUE(equals(inMemory, outOfCore));
+  }
+}
+
+TEST(io, typed_read) {
+  std::string tns = "1 2 3.5\n2 1 -2.25\n3 3 1e1\n";
+  std::stringstream floatStream(tns);
+  Tensor<float> floats = readTNS(floatStream, Sparse, Float32);
+  ASSERT_EQ(Float32, floats.getComponentType());
+  Tensor<float> expectedFloats({3, 3}, Sparse);
+  expectedFloats.insert({0, 1}, 3.5f);
+  expectedFloats.insert({1, 0}, -2.25f);
+  expectedFloats.insert({2, 2}, 10.0f);
+  expectedFloats.pack();
+  ASSERT_TRUE(equals(expectedFloats, floats));
+
+  std::stringstream integerStream(
+      "%%MatrixMarket matrix coordinate integer general\n"
+      "2 3 2\n"
+      "1 3 -7\n"
+      "2 1 5000000000\n");
+  Tensor<int64_t> integers = readMTX(integerStream, CSR, Int64);
+  Tensor<int64_t> expectedIntegers({2, 3}, CSR);
+  expectedIntegers.insert({0, 2}, (int64_t)-7);
+  expectedIntegers.insert({1, 0}, (int64_t)5000000000);
+  expectedIntegers.pack();
+  ASSERT_TRUE(equals(expectedIntegers, integers));
+
+  std::stringstream patternStream(
+      "%%MatrixMarket matrix coordinate pattern symmetric\n"
+      "3 3 2\n"
+      "2 1\n"
+      "3 3\n");
+  Tensor<float> pattern = readMTX(patternStream, CSR, Float32);
+  Tensor<float> expectedPattern({3, 3}, CSR);
+  expectedPattern.insert({0, 1}, 1.0f);
+  expectedPattern.insert({1, 0}, 1.0f);
+  expectedPattern.insert({2, 2}, 1.0f);
+  expectedPattern.pack();
+  ASSERT_TRUE(equals(expectedPattern, pattern));
+
+  std::stringstream complexStream(
+      "%%MatrixMarket matrix coordinate complex general\n"
+      "1 2 1\n"
+      "1 2 1.5 -2\n");
+  Tensor<std::complex<double>> complexes = readMTX(complexStream, Sparse,
+                                                    Complex128);
+  Tensor<std::complex<double>> expectedComplexes({1, 2}, Sparse);
+  expectedComplexes.insert({0, 1}, std::complex<double>(1.5, -2.0));
+  expectedComplexes.pack();
+  ASSERT_TRUE(equals(expectedComplexes, complexes));
+}
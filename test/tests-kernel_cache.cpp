@@ -0,0 +1,90 @@
+#include "test.h"
+#include "taco/codegen/module.h"
+#include "taco/codegen/kernel_cache.h"
+#include "taco/util/env.h"
+
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace taco;
+using namespace taco::ir;
+
+namespace {
+struct KernelCacheEnv {
+  KernelCacheEnv(std::string maxSize = "") {
+    dir = util::getTmpdir() + "kernel_cache_" + std::to_string(getpid()) +
+          "_" + std::to_string(rand()) + "/";
+    setenv("TACO_KERNEL_CACHE_DIR", dir.c_str(), 1);
+    if (maxSize != "") {
+      setenv("TACO_KERNEL_CACHE_MAX_SIZE", maxSize.c_str(), 1);
+    }
+    resetKernelCacheStats();
+  }
+  ~KernelCacheEnv() {
+    unsetenv("TACO_KERNEL_CACHE_DIR");
+    unsetenv("TACO_KERNEL_CACHE_MAX_SIZE");
+  }
+  std::string dir;
+};
+
+int callAnswer(Module& module) {
+  typedef int (*fnptr_t)();
+  fnptr_t func;
+  *reinterpret_cast<void**>(&func) = module.getFuncPtr("answer");
+  return func();
+}
+}
+
+TEST(kernel_cache, disabled) {
+  unsetenv("TACO_KERNEL_CACHE_DIR");
+  ASSERT_FALSE(isKernelCacheEnabled());
+  resetKernelCacheStats();
+  Module module;
+  module.setSource("int answer() { return 41; }\n");
+  module.compile();
+  ASSERT_EQ(41, callAnswer(module));
+  ASSERT_EQ(0u, getKernelCacheStats().misses);
+}
+
+TEST(kernel_cache, hit) {
+  KernelCacheEnv env;
+  ASSERT_TRUE(isKernelCacheEnabled());
+
+  Module module1;
+  module1.setSource("int answer() { return 42; }\n");
+  module1.compile();
+  ASSERT_EQ(42, callAnswer(module1));
+  ASSERT_EQ(1u, getKernelCacheStats().misses);
+  ASSERT_EQ(1u, getKernelCacheStats().stores);
+  ASSERT_EQ(0u, getKernelCacheStats().hits);
+
+  Module module2;
+  module2.setSource("int answer() { return 42; }\n");
+  std::string path = module2.compile();
+  ASSERT_EQ(0u, path.find(env.dir));
+  ASSERT_EQ(42, callAnswer(module2));
+  ASSERT_EQ(1u, getKernelCacheStats().hits);
+  ASSERT_EQ(1u, getKernelCacheStats().stores);
+}
+
+TEST(kernel_cache, key) {
+  std::string key = getKernelCacheKey("int f();", "cc -O3");
+  ASSERT_EQ(key, getKernelCacheKey("int f();", "cc -O3"));
+  ASSERT_NE(key, getKernelCacheKey("int f();", "cc -O2"));
+  ASSERT_NE(key, getKernelCacheKey("int g();", "cc -O3"));
+}
+
+TEST(kernel_cache, evict) {
+  KernelCacheEnv env("1");
+
+  Module module1;
+  module1.setSource("int answer() { return 1; }\n");
+  module1.compile();
+  ASSERT_EQ(0u, getKernelCacheStats().evictions);
+
+  Module module2;
+  module2.setSource("int answer() { return 2; }\n");
+  module2.compile();
+  ASSERT_EQ(2, callAnswer(module2));
+  ASSERT_EQ(1u, getKernelCacheStats().evictions);
+}
@@ -0,0 +1,137 @@
+#include "test.h"
+#include "test_tensors.h"
+#include "taco/tensor.h"
+#include "taco/llvm.h"
+#include "taco/codegen/module.h"
+
+using namespace taco;
+
+namespace {
+// Restores the LLVM codegen setting when a test exits
+struct LLVMCodegen {
+  LLVMCodegen(bool enabled) : previous(should_use_LLVM_codegen()) {
+    set_LLVM_codegen_enabled(enabled);
+  }
+  ~LLVMCodegen() {
+    set_LLVM_codegen_enabled(previous);
+  }
+  bool previous;
+};
+}
+
+TEST(llvm, disabled) {
+  if (LLVM_BUILT) {
+    return;
+  }
+  ASSERT_FALSE(should_use_LLVM_codegen());
+  set_LLVM_codegen_enabled(false);
+  ASSERT_FALSE(should_use_LLVM_codegen());
+}
+
+TEST(llvm, spmv) {
+  if (!LLVM_BUILT) {
+    return;
+  }
+  Tensor<double> A = d33a("A", Format({Dense, Sparse}));
+  Tensor<double> x = d3a("x", Format({Dense}));
+  IndexVar i, j;
+
+  Tensor<double> y("y", {3}, Format({Sparse}));
+  y(i) = A(i,j) * x(j);
+  {
+    LLVMCodegen jit(true);
+    y.evaluate();
+  }
+  ASSERT_NE("", y.getSource());
+
+  Tensor<double> expected("expected", {3}, Format({Sparse}));
+  expected(i) = A(i,j) * x(j);
+  {
+    LLVMCodegen jit(false);
+    expected.evaluate();
+  }
+  ASSERT_TENSOR_EQ(expected, y);
+}
+
+TEST(llvm, module) {
+  if (!LLVM_BUILT) {
+    return;
+  }
+  LLVMCodegen jit(true);
+  ir::Expr x = ir::Var::make("x", Int32);
+  ir::Expr y = ir::Var::make("y", Int32);
+  ir::Stmt body = ir::Assign::make(x, ir::Add::make(x, y));
+  ir::Module module;
+  module.addFunction(ir::Function::make("add", {x}, {y}, body));
+  ASSERT_EQ("", module.compile());
+
+  typedef int (*fnptr_t)(int, int);
+  fnptr_t add;
+  *reinterpret_cast<void**>(&add) = module.getFuncPtr("add");
+  ASSERT_NE(nullptr, reinterpret_cast<void*>(add));
+  ASSERT_EQ(0, add(1, 2));
+  ASSERT_NE(nullptr, module.getFuncPtr("_shim_add"));
+  ASSERT_EQ(nullptr, module.getFuncPtr("sub"));
+}
+
+TEST(llvm, int64_positions) {
+  if (!LLVM_BUILT) {
+    return;
+  }
+  Format csr64 = CSR;
+  csr64.setCoordinateTypes(Int64, Int64);
+  IndexVar i, j;
+
+  // Kernels over 64-bit index arrays fall back to the C backend
+  Tensor<double> y("y", {3}, Format({Dense}));
+  {
+    LLVMCodegen jit(true);
+    Tensor<double> A = d33a("A", csr64);
+    Tensor<double> x = d3a("x", Format({Dense}));
+    y(i) = A(i,j) * x(j);
+    y.evaluate();
+  }
+
+  Tensor<double> expected("expected", {3}, Format({Dense}));
+  {
+    LLVMCodegen jit(false);
+    Tensor<double> A = d33a("A", CSR);
+    Tensor<double> x = d3a("x", Format({Dense}));
+    expected(i) = A(i,j) * x(j);
+    expected.evaluate();
+  }
+  ASSERT_TENSOR_EQ(expected, y);
+}
+
+TEST(llvm, narrow_coordinates) {
+  if (!LLVM_BUILT) {
+    return;
+  }
+  Format csr8 = CSR;
+  csr8.narrowCoordinateTypes({3,200});
+  Format dcsr16({Sparse, Sparse});
+  dcsr16.narrowCoordinateTypes({300,200});
+  IndexVar i, j, k;
+
+  // Kernels over UInt8 and UInt16 coordinates fall back to the C backend
+  auto multiply = [&](Format aFormat, Format bFormat, bool jit) {
+    LLVMCodegen codegen(jit);
+    Tensor<double> A("A", {3,200}, aFormat);
+    Tensor<double> B("B", {300,200}, bFormat);
+    A.insert({0,1}, 1.0);
+    A.insert({2,0}, 2.0);
+    A.insert({2,199}, 3.0);
+    B.insert({1,199}, 4.0);
+    B.insert({2,0}, 5.0);
+    B.insert({299,199}, 6.0);
+    A.pack();
+    B.pack();
+    Tensor<double> C("C", {3,300}, Dense);
+    C(i,k) = A(i,j) * B(k,j);
+    C.evaluate();
+    return C;
+  };
+  Tensor<double> C = multiply(csr8, dcsr16, true);
+  Tensor<double> expected = multiply(CSR, Format({Sparse, Sparse}), false);
+  ASSERT_TENSOR_EQ(expected, C);
+}
@@ -23,6 +23,8 @@ static const Dimension n;
 static const Type vectype(Float64, {n});
 static const Type mattype(Float64, {n,n});
 static const Type tentype(Float64, {n,n,n});
+static const Type fixedvectype(Float64, {5});
+static const Type fixedmattype(Float64, {5,5});
 
 static TensorVar alpha("alpha", Float64);
 static TensorVar beta("beta",   Float64);
@@ -40,12 +42,19 @@ static TensorVar c("c", vectype, Format());
 static TensorVar d("d", vectype, Format());
 
 static TensorVar w("w", vectype, dense);
+static TensorVar W("W", mattype, Format({dense,dense}));
+static TensorVar w5("w5", fixedvectype, dense);
+static TensorVar wh("wh", vectype, Format({hashed}));
 
 static TensorVar A("A", mattype, Format());
 static TensorVar B("B", mattype, Format());
 static TensorVar C("C", mattype, Format());
 static TensorVar D("D", mattype, Format());
 
+static TensorVar P("P", fixedmattype, Format());
+static TensorVar Q("Q", fixedmattype, Format());
+static TensorVar R("R", fixedmattype, Format());
+
 static TensorVar S("S", tentype, Format());
 static TensorVar T("T", tentype, Format());
 static TensorVar U("U", tentype, Format());
@@ -717,6 +726,83 @@ TEST_STMT(DISABLED_where_spmm,
   }
 )
 
+TEST_STMT(where_matrix_workspace,
+  where(forall(i,
+               forall(j,
+                      A(i,j) = W(i,j))),
+        forall(i,
+               forall(k,
+                      forall(j,
+                             W(i,j) += B(i,k) * C(k,j))))),
+  Values(
+         Formats({{A,Format({dense,dense})},
+                  {B,Format({dense,sparse})}, {C,Format({dense,dense})}}),
+         Formats({{A,Format({dense,dense})},
+                  {B,Format({dense,sparse})}, {C,Format({dense,sparse})}})
+         ),
+  {
+    TestCase({{B, { {{0,1}, 2.0}, {{2,0},  3.0}, {{2,2}, 4.0}} },
+              {C, { {{0,0},10.0}, {{0,1}, 20.0}, {{2,1},30.0}} }},
+             {{A, { {{2,0},30.0}, {{2,1},180.0} }}})
+  }
+)
+
+TEST_STMT(where_hashed_workspace,
+  forall(i,
+         where(forall(j,
+                      A(i,j) = wh(j)),
+               forall(k,
+                      forall(j,
+                             wh(j) += B(i,k) * C(k,j))))),
+  Values(
+         Formats({{A,Format({dense,dense})}, {wh,Format({hashed})},
+                  {B,Format({dense,sparse})}, {C,Format({dense,sparse})}})
+         ),
+  {
+    TestCase({{B, { {{0,1}, 2.0}, {{2,0},  3.0}, {{2,2}, 4.0}} },
+              {C, { {{0,0},10.0}, {{0,1}, 20.0}, {{2,1},30.0}} }},
+             {{A, { {{2,0},30.0}, {{2,1},180.0} }}})
+  }
+)
+
+TEST_STMT(where_parallel_workspace,
+  forall(i,
+         where(forall(j,
+                      P(i,j) = w5(j)),
+               forall(k,
+                      forall(j,
+                             w5(j) += Q(i,k) * R(k,j)))),
+         ParallelUnit::CPUThread, OutputRaceStrategy::NoRaces),
+  Values(
+         Formats({{P,Format({dense,dense})},
+                  {Q,Format({dense,sparse})}, {R,Format({dense,dense})}})
+         ),
+  {
+    TestCase({{Q, { {{0,1}, 2.0}, {{2,0},  3.0}, {{2,2}, 4.0}} },
+              {R, { {{0,0},10.0}, {{0,1}, 20.0}, {{2,1},30.0}} }},
+             {{P, { {{2,0},30.0}, {{2,1},180.0} }}})
+  }
+)
+
+TEST_STMT(where_parallel_runtime_workspace,
+  forall(i,
+         where(forall(j,
+                      A(i,j) = w(j)),
+               forall(k,
+                      forall(j,
+                             w(j) += B(i,k) * C(k,j)))),
+         ParallelUnit::CPUThread, OutputRaceStrategy::NoRaces),
+  Values(
+         Formats({{A,Format({dense,dense})},
+                  {B,Format({dense,sparse})}, {C,Format({dense,dense})}})
+         ),
+  {
+    TestCase({{B, { {{0,1}, 2.0}, {{2,0},  3.0}, {{2,2}, 4.0}} },
+              {C, { {{0,0},10.0}, {{0,1}, 20.0}, {{2,1},30.0}} }},
+             {{A, { {{2,0},30.0}, {{2,1},180.0} }}})
+  }
+)
+
 
 // Test sequence statements
 
@@ -732,6 +818,24 @@ TEST_STMT(sequence_scalar,
   }
 )
 
+TEST_STMT(sequence_vector_fused,
+  forall(i,
+         sequence(a(i) = b(i),
+                  a(i) += c(i) * d(i))
+         ),
+  Values(
+         Formats({{a, dense}, {b, dense}, {c, dense}, {d, dense}}),
+         Formats({{a, dense}, {b,sparse}, {c,sparse}, {d, dense}}),
+         Formats({{a,sparse}, {b,sparse}, {c,sparse}, {d, dense}})
+         ),
+  {
+    TestCase({{b, {{{0}, 1.0}, {{2},  2.0}}},
+              {c, {{{2}, 3.0}, {{4},  4.0}}},
+              {d, {{{0}, 5.0}, {{2},  6.0}, {{3}, 7.0}, {{4}, 8.0}}}},
+             {{a, {{{0}, 1.0}, {{2}, 20.0}, {{4}, 32.0}}}})
+  }
+)
+
 
 // Test multi statements
 
@@ -5,6 +5,7 @@
 
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include "taco/util/collections.h"
 
@@ -157,6 +158,147 @@ TEST(tensor, set_from_components) {
   }
 }
 
+TEST(tensor, parallel_pack) {
+  const Format csc({Dense, Sparse}, {1, 0});
+  Tensor<double> serial({1000, 1000}, csc);
+  Tensor<double> parallel({1000, 1000}, csc);
+  unsigned seed = 42;
+  for (int n = 0; n < 300000; ++n) {
+    seed = seed * 1103515245 + 12345;
+    const int i = (seed >> 8) % 1000;
+    seed = seed * 1103515245 + 12345;
+    const int j = (seed >> 8) % 1000;
+    serial.insert({i, j}, (double)(n % 7));
+    parallel.insert({i, j}, (double)(n % 7));
+  }
+
+  const int numThreads = taco_get_num_threads();
+  serial.pack();
+  taco_set_num_threads(4);
+  parallel.pack();
+  taco_set_num_threads(numThreads);
+  ASSERT_TRUE(equals(serial, parallel));
+}
+
+TEST(tensor, pack_wide_coordinates) {
+  // The coordinates need 90 bits, so pack sorts them with 128-bit keys
+  const int dim = 1 << 30;
+  Tensor<double> a({dim, dim, dim}, Sparse);
+  map<vector<int>,double> vals;
+  unsigned seed = 7;
+  for (int n = 0; n < 1000; ++n) {
+    vector<int> coord(3);
+    for (auto& c : coord) {
+      seed = seed * 1103515245 + 12345;
+      c = (int)(seed % dim);
+    }
+    coord[0] %= 4;
+    a.insert(coord, (double)n);
+    vals[coord] += n;
+  }
+  a.pack();
+
+  auto expected = vals.begin();
+  for (auto val = a.beginTyped<int>(); val != a.endTyped<int>(); ++val) {
+    ASSERT_TRUE(expected != vals.end());
+    ASSERT_EQ(expected->first, val->first.toVector());
+    ASSERT_EQ(expected->second, val->second);
+    ++expected;
+  }
+  ASSERT_TRUE(expected == vals.end());
+}
+
+TEST(tensor, concurrent_pack) {
+  // Tensors of different orders, packed at the same time from several threads
+  const int numTensors = 6;
+  vector<Tensor<double>> tensors;
+  vector<map<vector<int>,double>> vals(numTensors);
+  for (int t = 0; t < numTensors; ++t) {
+    const int order = t % 3 + 1;
+    tensors.push_back(Tensor<double>(vector<int>(order, 50), Sparse));
+    unsigned seed = t;
+    for (int n = 0; n < 2000; ++n) {
+      vector<int> coord(order);
+      for (auto& c : coord) {
+        seed = seed * 1103515245 + 12345;
+        c = (seed >> 8) % 50;
+      }
+      tensors[t].insert(coord, (double)n);
+      vals[t][coord] += n;
+    }
+  }
+
+  vector<std::thread> threads;
+  for (int t = 0; t < numTensors; ++t) {
+    threads.emplace_back([&tensors, t]() { tensors[t].pack(); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (int t = 0; t < numTensors; ++t) {
+    auto expected = vals[t].begin();
+    for (auto val = tensors[t].beginTyped<int>();
+         val != tensors[t].endTyped<int>(); ++val) {
+      ASSERT_TRUE(expected != vals[t].end());
+      ASSERT_EQ(expected->first, val->first.toVector());
+      ASSERT_EQ(expected->second, val->second);
+      ++expected;
+    }
+    ASSERT_TRUE(expected == vals[t].end());
+  }
+}
+
+TEST(tensor, incremental_pack) {
+  Tensor<double> a({20, 30}, Format({Sparse, Sparse}, {1, 0}));
+  map<vector<int>,double> vals;
+  unsigned seed = 3;
+  for (int batch = 0; batch < 4; ++batch) {
+    for (int n = 0; n < 50; ++n) {
+      seed = seed * 1103515245 + 12345;
+      const int i = (seed >> 8) % 20;
+      seed = seed * 1103515245 + 12345;
+      const int j = (seed >> 8) % 30;
+      a.insert({i, j}, (double)(n + 1));
+      vals[{i, j}] += n + 1;
+    }
+    a.pack();
+
+    map<vector<int>,double> packed;
+    for (auto val = a.beginTyped<int>(); val != a.endTyped<int>(); ++val) {
+      packed[val->first.toVector()] = val->second;
+    }
+    ASSERT_EQ(vals, packed);
+  }
+}
+
+TEST(tensor, set_from_coo) {
+  // Sorted by column, as the CSC mode ordering requires
+  const int rows[] = {0, 3, 1, 2, 0};
+  const int cols[] = {0, 0, 2, 2, 4};
+  const double vals[] = {1.0, 2.0, 3.0, 4.0, 5.0};
+
+  Tensor<double> expected({4, 5}, CSC);
+  for (int n = 0; n < 5; ++n) {
+    expected.insert({rows[n], cols[n]}, vals[n]);
+  }
+  expected.pack();
+
+  Tensor<double> sorted({4, 5}, CSC);
+  sorted.insert({1, 1}, 42.0);
+  sorted.setFromCOO({rows, cols}, vals, 5, true);
+  ASSERT_FALSE(sorted.needsPack());
+  ASSERT_TRUE(equals(expected, sorted));
+
+  // Unsorted, and with a duplicate
+  const int dupRows[] = {0, 2, 3, 1, 0, 3};
+  const int dupCols[] = {4, 2, 0, 2, 0, 0};
+  const double dupVals[] = {5.0, 4.0, 1.5, 3.0, 1.0, 0.5};
+  Tensor<double> unsorted({4, 5}, CSC);
+  unsorted.setFromCOO({dupRows, dupCols}, dupVals, 6);
+  ASSERT_TRUE(equals(expected, unsorted));
+}
+
 TEST(tensor, hidden_pack) {
   Tensor<double> a({5,5}, Sparse);
   a(1,2) = 42.0;
@@ -311,6 +453,48 @@ TEST(tensor, explicit_compiler_methods) {
   }
 }
 
+TEST(tensor, async_compile) {
+  Tensor<double> A({2,3}, Format({Dense,Sparse}));
+  Tensor<double> B({2,3}, Format({Dense,Sparse}));
+  Tensor<double> C({2,3}, Format({Sparse,Sparse}));
+  Tensor<double> d({3},   Format({Dense}));
+
+  C(0,1) = 2.0;
+  C(1,2) = 3.0;
+  d(1) = 4.0;
+  d(2) = 5.0;
+
+  IndexVar i, j;
+  A(i,j) = C(i,j) * d(j);
+  B(i,j) = C(i,j) + C(i,j) * d(j);
+
+  std::shared_future<void> compileA = A.compileAsync();
+  std::shared_future<void> compileB = B.compileAsync();
+  ASSERT_FALSE(A.needsCompile());
+  ASSERT_FALSE(B.needsCompile());
+
+  // Packing overlaps with the compilation running in the background
+  C.pack();
+  d.pack();
+
+  compileA.wait();
+  A.assemble();
+  A.compute();
+  B.evaluate();
+
+  map<vector<int>,double> valsA = {{{0,1}, 8.0}, {{1,2}, 15.0}};
+  for (auto val = A.beginTyped<int>(); val != A.endTyped<int>(); ++val) {
+    ASSERT_TRUE(util::contains(valsA, val->first.toVector()));
+    ASSERT_EQ(valsA.at(val->first.toVector()), val->second);
+  }
+  map<vector<int>,double> valsB = {{{0,1}, 10.0}, {{1,2}, 18.0}};
+  for (auto val = B.beginTyped<int>(); val != B.endTyped<int>(); ++val) {
+    ASSERT_TRUE(util::contains(valsB, val->first.toVector()));
+    ASSERT_EQ(valsB.at(val->first.toVector()), val->second);
+  }
+  compileB.wait();
+}
+
 TEST(tensor, computation_dependency_modification) {
   Format csr({Dense,Sparse});
   Format csf({Sparse,Sparse,Sparse});
@@ -479,3 +663,66 @@ TEST(tensor, recompile) {
   ASSERT_TRUE(c.needsCompile());
   ASSERT_EQ(c.begin()->second, 42.0);
 }
+
+TEST(tensor, fuse_operands) {
+  Tensor<double> S("S", {3,3}, CSR);
+  Tensor<double> B("B", {3,2}, Format({Dense,Dense}));
+  Tensor<double> C("C", {2,3}, Format({Dense,Dense}));
+  Tensor<double> D("D", {3,2}, Format({Dense,Dense}));
+  Tensor<double> T("T", {3,3}, CSR);
+  Tensor<double> A("A", {3,2}, Format({Dense,Dense}));
+  Tensor<double> expected("expected", {3,2}, Format({Dense,Dense}));
+
+  S(0,1) = 1.0;
+  S(1,0) = 2.0;
+  S(2,2) = 3.0;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 2; j++) {
+      B(i,j) = i + j + 1.0;
+      C(j,i) = i - j;
+      D(i,j) = i * j + 1.0;
+    }
+  }
+
+  IndexVar i, j, k, l;
+  T(i,j) = S(i,j) * sum(k, B(i,k) * C(k,j));
+  A(i,l) = T(i,j) * D(j,l);
+
+  A.fuseOperands();
+
+  // The fused kernel computes A without computing T, and computes each sampled
+  // product of T once, outside of the loop over l
+  IndexStmt stmt = makeConcreteNotation(A.getAssignment());
+  ASSERT_TRUE(isa<Forall>(stmt));
+  ASSERT_TRUE(isa<Forall>(to<Forall>(stmt).getStmt()));
+  ASSERT_TRUE(isa<Where>(to<Forall>(to<Forall>(stmt).getStmt()).getStmt()));
+  A.evaluate();
+  ASSERT_TRUE(T.needsCompute());
+
+  expected(0,0) = 1.0;
+  expected(0,1) = 2.0;
+  expected(1,0) = -6.0;
+  expected(1,1) = -6.0;
+  expected(2,0) = 30.0;
+  expected(2,1) = 90.0;
+  expected.pack();
+  ASSERT_TENSOR_EQ(expected, A);
+
+  // SDDMM followed by SpMV is fused, since the sampled products are used once
+  Tensor<double> U("U", {3,3}, CSR);
+  Tensor<double> x("x", {3}, Dense);
+  Tensor<double> y("y", {3}, Dense);
+  Tensor<double> expectedY("expectedY", {3}, Dense);
+  for (int n = 0; n < 3; n++) {
+    x(n) = n + 1.0;
+  }
+  U(i,j) = S(i,j) * sum(k, B(i,k) * C(k,j));
+  y(i) = U(i,j) * x(j);
+  y.fuseOperands();
+  y.evaluate();
+  ASSERT_TRUE(U.needsCompute());
+
+  expectedY(i) = T(i,j) * x(j);
+  expectedY.evaluate();
+  ASSERT_TENSOR_EQ(expectedY, y);
+}
@@ -5,6 +5,7 @@
 
 #include "taco/tensor.h"
 #include "taco/storage/typed_vector.h"
+#include "taco/storage/file_io_mtx.h"
 
 #define _USE_MATH_DEFINES
 
@@ -45,7 +46,7 @@ TYPED_TEST_P(VectorTensorTest, types) {
   ASSERT_EQ(t, a.getComponentType());
   ASSERT_EQ(1, a.getOrder());
   ASSERT_EQ(5, a.getDimension(0));
-  map<vector<int>,TypeParam> vals = {{{0}, 1.0}, {{2}, 2.0}};
+  map<vector<int>,TypeParam> vals = {{{0}, (TypeParam)1.0}, {{2}, (TypeParam)2.0}};
   for (auto& val : vals) {
     a.insert(val.first, val.second);
   }
@@ -379,6 +380,55 @@ TEST(tensor_types, int_float_promotion) {
   ASSERT_TRUE(equalsExact(a, expected));
 }
 
+TEST(tensor_types, pattern) {
+  Format csr({Dense, Sparse});
+  TensorBase a("a", taco::Pattern, {3, 3}, csr);
+  a.insert({0, 0}, true);
+  a.insert({0, 1}, true);
+  a.insert({0, 2}, true);
+  a.insert({1, 2}, true);
+  a.insert({2, 0}, true);
+  a.pack();
+
+  std::stringstream bStream(
+      "%%MatrixMarket matrix coordinate real general\n"
+      "3 3 4\n"
+      "1 1 5.0\n"
+      "2 2 -1.0\n"
+      "2 3 2.5\n"
+      "3 3 7.0\n");
+  TensorBase b = readMTX(bStream, csr, taco::Pattern);
+  ASSERT_EQ(taco::Pattern, b.getComponentType());
+  ASSERT_EQ(0, b.getStorage().getValues().getType().getNumBytes());
+
+  // Counts the paths of length two through the two structures
+  Tensor<int> c("c", {3, 3}, Format({Dense, Dense}));
+  c(i,j) = a(i,k) * b(k,j);
+  c.evaluate();
+  Tensor<int> expected("expected", {3, 3}, Format({Dense, Dense}));
+  expected.insert({0, 0}, 1);
+  expected.insert({0, 1}, 1);
+  expected.insert({0, 2}, 2);
+  expected.insert({1, 2}, 1);
+  expected.insert({2, 0}, 1);
+  expected.pack();
+  ASSERT_TRUE(equals(expected, c));
+
+  TensorBase d("d", taco::Pattern, {3, 3}, csr);
+  d(i,j) = a(i,j) + b(i,j);
+  d.evaluate();
+  TensorBase expectedUnion("expectedUnion", taco::Pattern, {3, 3}, csr);
+  for (auto& coordinate : vector<vector<int>>({{0,0}, {0,1}, {0,2}, {1,1},
+                                               {1,2}, {2,0}, {2,2}})) {
+    expectedUnion.insert(coordinate, true);
+  }
+  expectedUnion.pack();
+  ASSERT_TRUE(equals(expectedUnion, d));
+  Tensor<bool> dView = d;
+  ASSERT_TRUE(dView.at({1, 1}));
+  ASSERT_FALSE(dView.at({1, 0}));
+}
+
 TEST(DISABLED_tensor_types, coordinate_types) {
   TensorData<double> testData = TensorData<double>({5, 3, 2}, {
     {{0,0,0}, 0.0},
@@ -207,6 +207,7 @@ INSTANTIATE_TEST_CASE_P(reorder, apply,
 );
 
 static Assignment elmul = (a(i) = b(i) * c(i));
+static Assignment matadd = (A(i,j) = B(i,j) + C(i,j));
 
 INSTANTIATE_TEST_CASE_P(precompute, apply,
   Values(
@@ -216,6 +217,16 @@ INSTANTIATE_TEST_CASE_P(precompute, apply,
                                          a(i) = w(i)),
                                   forall(iw,
                                          w(iw) = b(iw) * c(iw)))
+                            ),
+         TransformationTest(Precompute(matadd.getRhs(), {i,j}, {iw,jw}, W),
+                            makeConcreteNotation(matadd),
+                            where(forall(i,
+                                         forall(j,
+                                                A(i,j) = W(i,j))),
+                                  forall(iw,
+                                         forall(jw,
+                                                W(iw,jw) = B(iw,jw) +
+                                                           C(iw,jw))))
                             )
   )
 );
@@ -353,4 +364,29 @@ TEST(schedule, workspace_spmspm) {
   ASSERT_TENSOR_EQ(E,A);
 }
 
+TEST(schedule, hashed_workspace_spmspm) {
+  TensorBase A("A", Float(64), {3,3}, Format({dense,hashed}));
+  TensorBase B = d33a("B", Format({dense,compressed}));
+  TensorBase C = d33b("C", Format({dense,compressed}));
+  B.pack();
+  C.pack();
+
+  IndexVar i, j, k;
+  IndexExpr matmul = B(i,k) * C(k,j);
+  A(i,j) = matmul;
+
+  TensorVar wh("wh", Type(Float64, {3}), Format({hashed}));
+  IndexStmt stmt = A.getAssignment().concretize();
+  stmt = stmt.reorder({i,k,j}).precompute(matmul, j, j, wh);
+  A.compile(stmt);
+  A.assemble();
+  A.compute();
+
+  Tensor<double> E("e", {3,3}, Format({dense,compressed}));
+  E.insert({2,0}, 30.0);
+  E.insert({2,1}, 180.0);
+  E.pack();
+  ASSERT_TRUE(equals(E,A));
+}
+
 }